@@ -0,0 +1,171 @@
+#define _XOPEN_SOURCE 700
+
+// Interactive startup of each shell build: starts it on a pseudo-terminal,
+// waits for the "$ " prompt, then reads the peak RSS (VmHWM) and the shared
+// objects mapped before killing it. Median time to the prompt over RUNS
+// starts of each. Meant for a Readline build against a SHELL_LINE_EDITOR
+// one; the shells read the history in $HOME, so set HOME to compare them
+// on equal terms.
+//
+//   editor_startup RUNS SHELL...
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PROMPT "$ "
+#define PROMPT_TIMEOUT_MS 5000
+
+typedef struct {
+    int64_t ns;  // fork to prompt
+    long hwm_kib;
+    int shared_objects;
+} Sample;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static long peak_rss_kib(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    FILE* f = fopen(path, "re");
+    if (!f) return -1;
+    char line[256];
+    long kib = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmHWM: %ld kB", &kib) == 1) break;
+    }
+    fclose(f);
+    return kib;
+}
+
+// Distinct .so files in the process's mappings
+static int shared_objects(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", (int)pid);
+    FILE* f = fopen(path, "re");
+    if (!f) return -1;
+    char line[4096], last[4096] = "";
+    int count = 0;
+    while (fgets(line, sizeof(line), f)) {
+        char* file = strchr(line, '/');
+        if (!file || !strstr(file, ".so")) continue;
+        if (strcmp(file, last) != 0) count++;  // a file's maps are adjacent
+        snprintf(last, sizeof(last), "%s", file);
+    }
+    fclose(f);
+    return count;
+}
+
+static pid_t spawn_on_pty(const char* shell, int* master) {
+    *master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0) {
+        perror("posix_openpt");
+        exit(1);
+    }
+    const char* name = ptsname(*master);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        setsid();
+        int tty = open(name, O_RDWR);  // becomes the controlling terminal
+        if (tty < 0) _exit(127);
+        dup2(tty, STDIN_FILENO);
+        dup2(tty, STDOUT_FILENO);
+        dup2(tty, STDERR_FILENO);
+        if (tty > STDERR_FILENO) close(tty);
+        execl(shell, shell, (char*)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+// Reads the terminal until the prompt shows; false on EOF or timeout
+static bool wait_for_prompt(int master) {
+    char buf[4096];
+    size_t len = 0;
+    struct pollfd pfd = {master, POLLIN, 0};
+    while (poll(&pfd, 1, PROMPT_TIMEOUT_MS) > 0) {
+        if (len == sizeof(buf) - 1) len = 0;  // only the tail matters
+        ssize_t n = read(master, buf + len, sizeof(buf) - 1 - len);
+        if (n <= 0) return false;
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (strstr(buf, PROMPT)) return true;
+    }
+    return false;
+}
+
+static bool sample(const char* shell, Sample* s) {
+    int master;
+    int64_t start = now_ns();
+    pid_t pid = spawn_on_pty(shell, &master);
+    bool ok = wait_for_prompt(master);
+    s->ns = now_ns() - start;
+    if (ok) {
+        s->hwm_kib = peak_rss_kib(pid);
+        s->shared_objects = shared_objects(pid);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    close(master);
+    return ok;
+}
+
+static int compare_sample(const void* a, const void* b) {
+    int64_t x = ((const Sample*)a)->ns, y = ((const Sample*)b)->ns;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || atoi(argv[1]) < 1) {
+        fprintf(stderr, "usage: editor_startup RUNS SHELL...\n");
+        return 2;
+    }
+    int runs = atoi(argv[1]);
+    int shells = argc - 2;
+    Sample* samples = malloc(sizeof(Sample) * runs * shells);
+    if (!samples) return 1;
+
+    // one untimed start each to warm the page cache, then the shells in
+    // turn so drift in the machine's load hits them alike
+    for (int r = -1; r < runs; r++) {
+        for (int i = 0; i < shells; i++) {
+            Sample s;
+            if (!sample(argv[i + 2], &s)) {
+                fprintf(stderr, "%s: no prompt within %d ms\n", argv[i + 2],
+                        PROMPT_TIMEOUT_MS);
+                free(samples);
+                return 1;
+            }
+            if (r >= 0) samples[i * runs + r] = s;
+        }
+    }
+
+    printf("median of %d starts to the first prompt\n", runs);
+    for (int i = 0; i < shells; i++) {
+        Sample* v = &samples[i * runs];
+        qsort(v, runs, sizeof(Sample), compare_sample);
+        const Sample* mid = &v[runs / 2];
+        printf("%-32s %6.2f ms  peak RSS %5.1f MiB  %3d .so\n", argv[i + 2],
+               (double)mid->ns / 1e6, (double)mid->hwm_kib / 1024,
+               mid->shared_objects);
+    }
+    free(samples);
+    return 0;
+}
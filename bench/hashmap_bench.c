@@ -0,0 +1,277 @@
+#define _POSIX_C_SOURCE 200809L
+
+// HashMap against the index it replaced (the builtin registry's linear
+// probe: FNV-1a, no stored hash, at most half full), and the SSE2 tag
+// probe against HASHMAP_SCALAR. ns per operation on 30-byte keys,
+// median of the runs.
+//
+//   hashmap_bench [RUNS]
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ds/hashmap.h"
+
+void scalar_hashmap_init(HashMap* map);
+void scalar_hashmap_free(HashMap* map);
+bool scalar_hashmap_get(const HashMap* map, const char* key, void** value);
+bool scalar_hashmap_put(HashMap* map, const char* key, void* value,
+                        bool* added);
+HashStats scalar_hashmap_stats(const HashMap* map);
+
+#define KEY_BYTES 30
+#define MIN_OPS 2000000  // lookups per measurement, repeating the keys
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ */
+/* The old index                                                */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    char** keys;  // dense entry array
+    void** values;
+    size_t count;
+    size_t capacity;
+    uint32_t* slots;  // entry index + 1, 0 = empty
+    size_t slot_capacity;
+} OldIndex;
+
+static uint64_t fnv1a(const char* s) {
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void old_insert_slot(OldIndex* ix, size_t entry) {
+    size_t mask = ix->slot_capacity - 1;
+    size_t i = fnv1a(ix->keys[entry]) & mask;
+    while (ix->slots[i]) i = (i + 1) & mask;
+    ix->slots[i] = (uint32_t)entry + 1;
+}
+
+static void old_rebuild(OldIndex* ix, size_t capacity) {
+    free(ix->slots);
+    ix->slots = calloc(capacity, sizeof(uint32_t));
+    if (!ix->slots) exit(1);
+    ix->slot_capacity = capacity;
+    for (size_t i = 0; i < ix->count; i++) old_insert_slot(ix, i);
+}
+
+static void* old_create(void) {
+    OldIndex* ix = calloc(1, sizeof(OldIndex));
+    if (!ix) exit(1);
+    old_rebuild(ix, 16);
+    return ix;
+}
+
+static void old_destroy(void* t) {
+    OldIndex* ix = t;
+    for (size_t i = 0; i < ix->count; i++) free(ix->keys[i]);
+    free(ix->keys);
+    free(ix->values);
+    free(ix->slots);
+    free(ix);
+}
+
+static bool old_get(void* t, const char* key) {
+    OldIndex* ix = t;
+    size_t mask = ix->slot_capacity - 1;
+    for (size_t i = fnv1a(key) & mask; ix->slots[i]; i = (i + 1) & mask) {
+        if (strcmp(ix->keys[ix->slots[i] - 1], key) == 0) return true;
+    }
+    return false;
+}
+
+static void old_put(void* t, const char* key, void* value) {
+    OldIndex* ix = t;
+    if (old_get(ix, key)) return;  // registration checked first
+    if (ix->count == ix->capacity) {
+        ix->capacity = ix->capacity ? ix->capacity * 2 : 16;
+        ix->keys = realloc(ix->keys, sizeof(char*) * ix->capacity);
+        ix->values = realloc(ix->values, sizeof(void*) * ix->capacity);
+        if (!ix->keys || !ix->values) exit(1);
+    }
+    ix->keys[ix->count] = strdup(key);
+    ix->values[ix->count] = value;
+    ix->count++;
+    if (ix->count * 2 > ix->slot_capacity) {
+        old_rebuild(ix, ix->slot_capacity * 2);
+    } else {
+        old_insert_slot(ix, ix->count - 1);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* HashMap builds                                               */
+/* ------------------------------------------------------------ */
+
+static void* map_create(void) {
+    HashMap* map = malloc(sizeof(HashMap));
+    if (!map) exit(1);
+    hashmap_init(map);
+    return map;
+}
+
+static void map_destroy(void* t) {
+    hashmap_free(t);
+    free(t);
+}
+
+static bool map_get(void* t, const char* key) {
+    return hashmap_get(t, key, NULL);
+}
+
+static void map_put(void* t, const char* key, void* value) {
+    hashmap_put(t, key, value, NULL);
+}
+
+static void* scalar_create(void) {
+    HashMap* map = malloc(sizeof(HashMap));
+    if (!map) exit(1);
+    scalar_hashmap_init(map);
+    return map;
+}
+
+static void scalar_destroy(void* t) {
+    scalar_hashmap_free(t);
+    free(t);
+}
+
+static bool scalar_get(void* t, const char* key) {
+    return scalar_hashmap_get(t, key, NULL);
+}
+
+static void scalar_put(void* t, const char* key, void* value) {
+    scalar_hashmap_put(t, key, value, NULL);
+}
+
+typedef struct {
+    const char* name;
+    void* (*create)(void);
+    void (*destroy)(void*);
+    void (*put)(void*, const char*, void*);
+    bool (*get)(void*, const char*);
+    HashStats (*stats)(const HashMap*);
+} Table;
+
+static const Table tables[] = {
+    {"old index", old_create, old_destroy, old_put, old_get, NULL},
+    {"HashMap", map_create, map_destroy, map_put, map_get, hashmap_stats},
+    {"HashMap scalar", scalar_create, scalar_destroy, scalar_put, scalar_get,
+     scalar_hashmap_stats},
+};
+
+/* ------------------------------------------------------------ */
+/* Measurement                                                  */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    double hit, miss, insert;
+} Timing;
+
+static char** make_keys(size_t n, const char* tag) {
+    char** keys = malloc(sizeof(char*) * n);
+    if (!keys) exit(1);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = malloc(KEY_BYTES + 1);
+        if (!keys[i]) exit(1);
+        snprintf(keys[i], KEY_BYTES + 1, "%s-%010zu-abcdefghijklmno", tag,
+                 i * 2654435761u % 4294967291u);
+    }
+    return keys;
+}
+
+static volatile size_t sink;
+
+// ns per lookup of every key in keys, repeated up to MIN_OPS lookups
+static double lookups(const Table* t, void* table, char** keys, size_t n) {
+    size_t rounds = n >= MIN_OPS ? 1 : MIN_OPS / n;
+    size_t found = 0;
+    int64_t start = now_ns();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < n; i++) found += t->get(table, keys[i]);
+    }
+    sink = found;
+    return (double)(now_ns() - start) / (double)(rounds * n);
+}
+
+static Timing run_once(const Table* t, char** keys, char** absent,
+                       size_t n) {
+    Timing tm;
+    void* table = t->create();
+    int64_t start = now_ns();
+    for (size_t i = 0; i < n; i++) t->put(table, keys[i], keys[i]);
+    tm.insert = (double)(now_ns() - start) / (double)n;
+    tm.hit = lookups(t, table, keys, n);
+    tm.miss = lookups(t, table, absent, n);
+    t->destroy(table);
+    return tm;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double* v, int n) {
+    qsort(v, n, sizeof(double), compare_double);
+    return v[n / 2];
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : 5;
+    if (runs < 1) runs = 1;
+    const size_t sizes[] = {64, 100000};
+
+    printf("ns/op, %d-byte keys, median of %d runs\n", KEY_BYTES, runs);
+    printf("%-16s %8s %8s %8s %8s %10s\n", "", "n", "hit", "miss", "insert",
+           "max probe");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        size_t n = sizes[s];
+        char** keys = make_keys(n, "key");
+        char** absent = make_keys(n, "not");
+
+        for (size_t t = 0; t < sizeof(tables) / sizeof(*tables); t++) {
+            double hit[runs], miss[runs], insert[runs];
+            for (int r = 0; r < runs; r++) {
+                Timing tm = run_once(&tables[t], keys, absent, n);
+                hit[r] = tm.hit;
+                miss[r] = tm.miss;
+                insert[r] = tm.insert;
+            }
+            printf("%-16s %8zu %8.1f %8.1f %8.1f", tables[t].name, n,
+                   median(hit, runs), median(miss, runs),
+                   median(insert, runs));
+
+            if (tables[t].stats) {
+                void* table = tables[t].create();
+                for (size_t i = 0; i < n; i++) {
+                    tables[t].put(table, keys[i], keys[i]);
+                }
+                printf(" %10zu", tables[t].stats(table).max_probe);
+                tables[t].destroy(table);
+            }
+            putchar('\n');
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            free(keys[i]);
+            free(absent[i]);
+        }
+        free(keys);
+        free(absent);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 200809L
+
+// Lexer throughput on 64 KB lines, for each build of the run scanner.
+// Configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+//   lexer_bench [SECONDS_PER_CASE]
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parse/lexer.h"
+
+Token* scalar_lex_tokens(char* line);
+#ifdef LEXER_BENCH_AVX2
+Token* avx2_lex_tokens(char* line);
+#endif
+
+#define LINE_BYTES (64 * 1024)
+
+const char* alias_get(const char* name) {
+    (void)name;
+    return NULL;
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Repeats piece after prefix until the line holds LINE_BYTES, then
+// appends suffix
+static char* make_line(const char* prefix, const char* piece,
+                       const char* suffix) {
+    char* line = malloc(LINE_BYTES + 1);
+    if (!line) exit(1);
+    size_t len = strlen(prefix), n = strlen(piece), tail = strlen(suffix);
+    memcpy(line, prefix, len);
+    while (len + n + tail <= LINE_BYTES) {
+        memcpy(line + len, piece, n);
+        len += n;
+    }
+    memcpy(line + len, suffix, tail);
+    line[len + tail] = '\0';
+    return line;
+}
+
+// MB/s of lex over line, best of the rounds run within seconds
+static double measure(Token* (*lex)(char*), char* line, double seconds) {
+    size_t len = strlen(line);
+    double best = 0;
+    int64_t deadline = now_ns() + (int64_t)(seconds * 1e9);
+    do {
+        int64_t start = now_ns();
+        int reps = 0;
+        while (now_ns() - start < 20000000) {  // 20 ms rounds
+            Token* tokens = lex(line);
+            for (size_t i = 0; tokens && tokens[i].text; i++) {
+                free(tokens[i].text);
+            }
+            free(tokens);
+            reps++;
+        }
+        double mbps = (double)len * reps / ((now_ns() - start) / 1e3);
+        if (mbps > best) best = mbps;
+    } while (now_ns() < deadline);
+    return best;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+
+    struct {
+        const char* name;
+        char* line;
+    } cases[] = {
+        {"plain words", make_line("echo", " argument-1234", "")},
+        {"one long word",
+         make_line("echo ", "QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVo=", "")},
+        {"single-quoted JSON",
+         make_line("curl -d '{", "\"key\": \"value 1234\", ", "\"end\": 0}'")},
+        {"double-quoted $vars",
+         make_line("echo \"", "text $HOME/path and more ", "\"")},
+    };
+    struct {
+        const char* name;
+        Token* (*lex)(char*);
+    } builds[] = {
+        {"scalar", scalar_lex_tokens},
+        {"default", lex_tokens},
+#ifdef LEXER_BENCH_AVX2
+        {"avx2", __builtin_cpu_supports("avx2") ? avx2_lex_tokens : NULL},
+#endif
+    };
+    size_t build_count = sizeof(builds) / sizeof(*builds);
+
+    printf("%-22s", "MB/s, 64 KB lines");
+    for (size_t b = 0; b < build_count; b++) printf("%10s", builds[b].name);
+    putchar('\n');
+    for (size_t c = 0; c < sizeof(cases) / sizeof(*cases); c++) {
+        printf("%-22s", cases[c].name);
+        for (size_t b = 0; b < build_count; b++) {
+            if (!builds[b].lex) {
+                printf("%10s", "-");
+                continue;
+            }
+            printf("%10.0f", measure(builds[b].lex, cases[c].line, seconds));
+            fflush(stdout);
+        }
+        putchar('\n');
+        free(cases[c].line);
+    }
+    return 0;
+}
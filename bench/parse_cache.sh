@@ -0,0 +1,28 @@
+#!/bin/sh
+# Repeated-line throughput with and without the parse cache: writes a
+# recording of N lines cycling over three builtin lines, then replays it
+# back to back with SHELL_PARSE_CACHE_BYTES=0 and with the default budget.
+#
+#   bench/parse_cache.sh SHELL [N]
+
+set -eu
+
+shell=${1:?usage: parse_cache.sh SHELL [N]}
+n=${2:-60000}
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+# the format `shell --record` writes; offsets are ignored under --fast
+awk -v n="$n" 'BEGIN {
+    lines[0] = "x=$((x + 1))"
+    lines[1] = "echo \"line $x\" '\''a | b ; c'\'' one two three four five"
+    lines[2] = "test \"$x\" -gt 0"
+    print "# shell recording v1: offset_us\tline"
+    for (i = 0; i < n; i++) printf "%d\t%s\n", i, lines[i % 3]
+}' >"$dir/lines"
+
+echo "== cache off"
+SHELL_PARSE_CACHE_BYTES=0 "$shell" --replay "$dir/lines" --fast
+echo "== cache on"
+"$shell" --replay "$dir/lines" --fast
@@ -0,0 +1,57 @@
+#!/bin/sh
+# Cold start against the command server: runs LINE N times as a fresh
+# interactive shell reading stdin, as `shell -c`, and as `shell --client`
+# against one warm server, and reports the time per run.
+#
+#   bench/server_startup.sh SHELL [N] [LINE]
+
+set -eu
+
+shell=${1:?usage: server_startup.sh SHELL [N] [LINE]}
+n=${2:-500}
+line=${3:-true}
+
+dir=$(mktemp -d)
+server=
+cleanup() {
+    [ -n "$server" ] && kill "$server" 2>/dev/null
+    rm -rf "$dir"
+}
+trap cleanup EXIT
+
+"$shell" --server "$dir/sock" &
+server=$!
+tries=0
+while [ ! -S "$dir/sock" ]; do
+    tries=$((tries + 1))
+    if [ "$tries" -gt 500 ]; then
+        echo "server did not start" >&2
+        exit 1
+    fi
+    sleep 0.01
+done
+
+now_ns() { date +%s%N; }
+
+# run LABEL COMMAND...: COMMAND N times, stdout and stderr discarded
+run() {
+    label=$1
+    shift
+    start=$(now_ns)
+    i=0
+    while [ "$i" -lt "$n" ]; do
+        "$@" >/dev/null 2>&1 || true
+        i=$((i + 1))
+    done
+    end=$(now_ns)
+    total_ms=$(((end - start) / 1000000))
+    printf '%-28s %7d ms  %6d us/run\n' "$label" "$total_ms" \
+        $(((end - start) / 1000 / n))
+}
+
+cold() { echo "$line" | "$shell"; }
+
+echo "$n runs of '$line'"
+run "cold: echo LINE | shell" cold
+run "cold: shell -c LINE" "$shell" -c "$line"
+run "warm: shell --client" "$shell" --client "$dir/sock" "$line"
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Conditionals per second with the test/[/true builtins against the same
+# lines run through the external binaries, which is what every one of
+# them cost before the builtins existed.
+#
+#   bench/test_builtins.sh SHELL [LINES]
+
+set -eu
+
+shell=${1:?usage: test_builtins.sh SHELL [LINES]}
+lines=${2:-6000}
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+# first executable NAME on PATH
+external() {
+    old_ifs=$IFS
+    IFS=:
+    for d in $PATH; do
+        if [ -x "$d/$1" ] && [ -f "$d/$1" ]; then
+            IFS=$old_ifs
+            echo "$d/$1"
+            return 0
+        fi
+    done
+    IFS=$old_ifs
+    echo "no external $1 on PATH" >&2
+    exit 1
+}
+
+# script FILE BRACKET TRUE TEST: LINES lines cycling over three
+# conditionals
+script() {
+    i=0
+    while [ "$i" -lt "$lines" ]; do
+        case $((i % 3)) in
+            0) echo "$2 -f /etc/passwd ]" ;;
+            1) echo "$3" ;;
+            2) echo "$4 3 -lt 10" ;;
+        esac
+        i=$((i + 1))
+    done >"$1"
+}
+
+script "$dir/builtin.sh" "[" true test
+script "$dir/external.sh" "$(external "[")" "$(external true)" \
+    "$(external test)"
+
+now_ns() { date +%s%N; }
+
+run() {
+    start=$(now_ns)
+    "$shell" "$2" >/dev/null
+    end=$(now_ns)
+    ms=$(((end - start) / 1000000))
+    [ "$ms" -gt 0 ] || ms=1
+    printf '%-10s %7d ms  %8d lines/s\n' "$1" "$ms" $((lines * 1000 / ms))
+}
+
+echo "$lines lines of [ -f /etc/passwd ] / true / test 3 -lt 10"
+run external "$dir/external.sh"
+run builtin "$dir/builtin.sh"
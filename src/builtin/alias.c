@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "parse/alias.h"
+#include "shell.h"
+
+// alias name='text' in a form the shell reads back
+static void print_alias(BuiltinIO* io, const char* name, const char* value) {
+    out_printf(&io->out, "alias %s='", name);
+    for (const char* p = value; *p; p++) {
+        if (*p == '\'') {
+            out_puts(&io->out, "'\\''");
+        } else {
+            out_write(&io->out, p, 1);
+        }
+    }
+    out_puts(&io->out, "'\n");
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static int list_aliases(BuiltinIO* io) {
+    size_t count = 0, iter = 0;
+    const char *name, *value;
+    while (alias_next(&iter, &name, &value)) count++;
+    if (count == 0) return 0;
+
+    const char** names = malloc(sizeof(char*) * count);
+    if (!names) return 1;
+    iter = 0;
+    for (size_t i = 0; alias_next(&iter, &name, &value); i++) names[i] = name;
+    qsort(names, count, sizeof(char*), compare_names);
+
+    for (size_t i = 0; i < count; i++) {
+        print_alias(io, names[i], alias_get(names[i]));
+    }
+    free(names);
+    return 0;
+}
+
+// alias                 list aliases
+// alias NAME=TEXT...    define
+// alias NAME...         show
+int exec_alias(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc == 1) return list_aliases(io);
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        const char* arg = cmd->argv[i];
+        const char* eq = strchr(arg, '=');
+        if (!eq) {
+            const char* value = alias_get(arg);
+            if (value) {
+                print_alias(io, arg, value);
+            } else {
+                out_printf(&io->err, "alias: %s: not found\n", arg);
+                status = 1;
+            }
+            continue;
+        }
+
+        char name[eq - arg + 1];
+        memcpy(name, arg, eq - arg);
+        name[eq - arg] = '\0';
+        if (!alias_valid_name(name)) {
+            out_printf(&io->err, "alias: %s: invalid alias name\n", name);
+            status = 1;
+        } else if (!alias_set(name, eq + 1)) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// unalias NAME...   remove
+// unalias -a        remove all
+int exec_unalias(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc == 2 && strcmp(cmd->argv[1], "-a") == 0) {
+        alias_clear();
+        return 0;
+    }
+    if (cmd->argc < 2) {
+        out_puts(&io->err, "unalias: usage: unalias [-a] name...\n");
+        return 2;
+    }
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        if (!alias_remove(cmd->argv[i])) {
+            out_printf(&io->err, "unalias: %s: not found\n", cmd->argv[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
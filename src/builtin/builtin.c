@@ -1,20 +1,144 @@
 #include "builtin.h"
 
+#include <dlfcn.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "ds/hashmap.h"
+
 typedef struct {
-    const char* name;
+    char* name;
     builtin_func function;
+    void* handle;  // dlopen() handle for loaded builtins, NULL if static
 } builtin_entry;
 
-static builtin_entry builtins[] = {
+static const struct {
+    const char* name;
+    builtin_func function;
+} static_builtins[] = {
     {"cd", exec_cd},     {"pwd", exec_pwd},   {"echo", exec_echo},
-    {"exit", exec_exit}, {"type", exec_type}, {"history", exec_history}};
+    {"exit", exec_exit}, {"type", exec_type}, {"history", exec_history},
+    {"printf", exec_printf}, {"enable", exec_enable}, {"set", exec_set},
+    {"shellstats", exec_shellstats}, {"let", exec_let},
+    {"test", exec_test}, {"[", exec_test}, {"true", exec_true},
+    {"false", exec_false}, {":", exec_true}, {"alias", exec_alias},
+    {"unalias", exec_unalias}, {"local", exec_local},
+    {"return", exec_return}, {"memo", exec_memo},
+    {"read", exec_read}, {"mapfile", exec_mapfile}};
+
+/* ------------------------------------------------------------ */
+/* Registry: dense entry array + name index                     */
+/* ------------------------------------------------------------ */
+
+static builtin_entry* entries;
+static size_t entry_count;
+static size_t entry_capacity;
+
+// name -> entry index
+static HashMap name_index;
+
+static void registry_init(void) {
+    static bool initialized;
+    if (initialized) return;
+    initialized = true;
+
+    for (size_t i = 0; i < sizeof(static_builtins) / sizeof(static_builtins[0]);
+         i++) {
+        builtin_register(static_builtins[i].name, static_builtins[i].function,
+                         NULL);
+    }
+}
+
+static builtin_entry* find_entry(const char* name) {
+    registry_init();
+
+    void* i;
+    if (!hashmap_get(&name_index, name, &i)) return NULL;
+    return &entries[(uintptr_t)i];
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
 
 builtin_func find_builtin(const char* name) {
-    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
-        if (strcmp(name, builtins[i].name) == 0) return builtins[i].function;
+    builtin_entry* e = find_entry(name);
+    return e ? e->function : NULL;
+}
+
+bool builtin_register(const char* name, builtin_func function, void* handle) {
+    registry_init();
+
+    builtin_entry* existing = find_entry(name);
+    if (existing) {
+        // replacing a loaded builtin drops its reference on the library
+        if (existing->handle) dlclose(existing->handle);
+        existing->function = function;
+        existing->handle = handle;
+        return true;
     }
-    return NULL;
+
+    if (entry_count == entry_capacity) {
+        size_t new_capacity = entry_capacity ? entry_capacity * 2 : 16;
+        builtin_entry* tmp =
+            realloc(entries, sizeof(builtin_entry) * new_capacity);
+        if (!tmp) return false;
+        entries = tmp;
+        entry_capacity = new_capacity;
+    }
+
+    void* slot = (void*)(uintptr_t)entry_count;
+    if (!hashmap_put(&name_index, name, slot, NULL)) return false;
+    entries[entry_count] = (builtin_entry){strdup(name), function, handle};
+    entry_count++;
+    return true;
+}
+
+bool builtin_unregister(const char* name) {
+    builtin_entry* e = find_entry(name);
+    if (!e || !e->handle) return false;  // static builtins stay
+
+    dlclose(e->handle);
+    e->handle = NULL;
+
+    // a loaded builtin that shadowed a static one falls back to it
+    for (size_t i = 0; i < sizeof(static_builtins) / sizeof(static_builtins[0]);
+         i++) {
+        if (strcmp(static_builtins[i].name, name) == 0) {
+            e->function = static_builtins[i].function;
+            return true;
+        }
+    }
+
+    // the last entry moves into the hole
+    hashmap_remove(&name_index, name, NULL);
+    free(e->name);
+    *e = entries[--entry_count];
+    if (e != &entries[entry_count]) {
+        void* slot = (void*)(uintptr_t)(e - entries);
+        hashmap_put(&name_index, e->name, slot, NULL);
+    }
+    return true;
+}
+
+size_t builtin_count(void) {
+    registry_init();
+    return entry_count;
+}
+
+const char* builtin_name_at(size_t i) {
+    registry_init();
+    return i < entry_count ? entries[i].name : NULL;
+}
+
+HashStats builtin_index_stats(void) {
+    registry_init();
+    return hashmap_stats(&name_index);
+}
+
+bool builtin_is_loaded(const char* name) {
+    builtin_entry* e = find_entry(name);
+    return e && e->handle;
 }
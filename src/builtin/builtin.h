@@ -1,20 +1,60 @@
 #ifndef BUILTIN_H
 #define BUILTIN_H
 
+#include "builtin/output.h"
+#include "ds/hashstats.h"
 #include "shell.h"  // for ParsedCommand
 
-typedef int (*builtin_func)(const Command*);
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Builtins loaded with `enable -f lib.so name` export
+ *     int name_builtin(const Command*, BuiltinIO*);
+ * and must export `int shell_builtin_abi_version` equal to
+ * BUILTIN_ABI_VERSION; a library without it is refused. Bump it whenever Command, BuiltinIO or the out_*
+ * helpers change layout or meaning.
+ *
+ *   2: Redirection gained DUP, whose filename is an fd number
+ */
+#define BUILTIN_ABI_VERSION 2
+
+typedef int (*builtin_func)(const Command*, BuiltinIO*);
 
 builtin_func find_builtin(const char* name);
 
+/* Registry of static and loaded builtins */
+bool builtin_register(const char* name, builtin_func function, void* handle);
+bool builtin_unregister(const char* name);
+bool builtin_is_loaded(const char* name);
+size_t builtin_count(void);
+const char* builtin_name_at(size_t i);
+HashStats builtin_index_stats(void);
+
 /* builtin declarations */
-int exec_cd(const Command*);
-int exec_pwd(const Command*);
-int exec_echo(const Command*);
-int exec_exit(const Command*);
-int exec_type(const Command*);
-int exec_history(const Command*);
+int exec_cd(const Command*, BuiltinIO*);
+int exec_pwd(const Command*, BuiltinIO*);
+int exec_echo(const Command*, BuiltinIO*);
+int exec_exit(const Command*, BuiltinIO*);
+int exec_type(const Command*, BuiltinIO*);
+int exec_history(const Command*, BuiltinIO*);
+int exec_printf(const Command*, BuiltinIO*);
+int exec_enable(const Command*, BuiltinIO*);
+int exec_set(const Command*, BuiltinIO*);
+int exec_shellstats(const Command*, BuiltinIO*);
+int exec_let(const Command*, BuiltinIO*);
+int exec_test(const Command*, BuiltinIO*);
+int exec_true(const Command*, BuiltinIO*);
+int exec_false(const Command*, BuiltinIO*);
+int exec_alias(const Command*, BuiltinIO*);
+int exec_unalias(const Command*, BuiltinIO*);
+int exec_local(const Command*, BuiltinIO*);
+int exec_return(const Command*, BuiltinIO*);
+int exec_memo(const Command*, BuiltinIO*);
+int exec_read(const Command*, BuiltinIO*);
+int exec_mapfile(const Command*, BuiltinIO*);
 void initialize_history();
 void save_history();
+void history_stats(size_t* entries, size_t* bytes);
 
 #endif
\ No newline at end of file
@@ -1,21 +1,21 @@
+#include <errno.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "builtin/builtin.h"
 #include "shell.h"
 
-int exec_cd(const Command* cmd) {
+int exec_cd(const Command* cmd, BuiltinIO* io) {
     const char* target = cmd->argv[1];
     if (target == NULL || (strcmp(target, "~") == 0)) {
         target = getenv("HOME");
     }
 
     if (chdir(target) != 0) {
-        char msg[1024];
-        snprintf(msg, sizeof(msg), "cd: %s", target);
-        perror(msg);
+        out_printf(&io->err, "cd: %s: %s\n", target, strerror(errno));
         return -1;
     }
     return 0;
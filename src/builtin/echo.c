@@ -2,15 +2,16 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "builtin/builtin.h"
 #include "shell.h"
 
-int exec_echo(const Command* command) {
+int exec_echo(const Command* command, BuiltinIO* io) {
     for (int i = 1; i < command->argc; i++) {
-        write(STDOUT_FILENO, command->argv[i], strlen(command->argv[i]));
-        if (i + 1 < command->argc) write(STDOUT_FILENO, " ", 1);
+        out_ref(&io->out, command->argv[i], strlen(command->argv[i]));
+        if (i + 1 < command->argc) out_write(&io->out, " ", 1);
     }
 
-    write(STDOUT_FILENO, "\n", 1);
+    out_write(&io->out, "\n", 1);
 
     return 0;
 }
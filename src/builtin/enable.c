@@ -0,0 +1,85 @@
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "shell.h"
+
+static int load_builtin(BuiltinIO* io, const char* file, const char* name) {
+    void* handle = dlopen(file, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        out_printf(&io->err, "enable: %s\n", dlerror());
+        return 1;
+    }
+
+    // a library that does not say which ABI it was built for is refused:
+    // it cannot be told apart from one built against an older one
+    const int* abi = dlsym(handle, "shell_builtin_abi_version");
+    if (!abi) {
+        out_printf(&io->err,
+                   "enable: %s: no shell_builtin_abi_version (expected %d)\n",
+                   file, BUILTIN_ABI_VERSION);
+        dlclose(handle);
+        return 1;
+    }
+    if (*abi != BUILTIN_ABI_VERSION) {
+        out_printf(&io->err, "enable: %s: ABI version %d, expected %d\n", file,
+                   *abi, BUILTIN_ABI_VERSION);
+        dlclose(handle);
+        return 1;
+    }
+
+    char symbol[strlen(name) + sizeof("_builtin")];
+    snprintf(symbol, sizeof(symbol), "%s_builtin", name);
+
+    // POSIX guarantees function pointers round-trip through dlsym()
+    builtin_func function;
+    *(void**)&function = dlsym(handle, symbol);
+    if (!function) {
+        out_printf(&io->err, "enable: %s: no symbol %s\n", file, symbol);
+        dlclose(handle);
+        return 1;
+    }
+
+    if (!builtin_register(name, function, handle)) {
+        dlclose(handle);
+        return 1;
+    }
+    return 0;
+}
+
+// enable               list builtins
+// enable -f FILE NAME  load NAME from the shared object FILE
+// enable -d NAME       remove a loaded builtin
+int exec_enable(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc == 1) {
+        for (size_t i = 0; i < builtin_count(); i++) {
+            out_printf(&io->out, "enable %s\n", builtin_name_at(i));
+        }
+        return 0;
+    }
+
+    const char* opt = cmd->argv[1];
+    if (strcmp(opt, "-f") == 0 && cmd->argc >= 4) {
+        int status = 0;
+        for (int i = 3; i < cmd->argc; i++) {
+            status |= load_builtin(io, cmd->argv[2], cmd->argv[i]);
+        }
+        return status;
+    }
+
+    if (strcmp(opt, "-d") == 0 && cmd->argc >= 3) {
+        int status = 0;
+        for (int i = 2; i < cmd->argc; i++) {
+            if (!builtin_unregister(cmd->argv[i])) {
+                out_printf(&io->err, "enable: %s: not a loaded builtin\n",
+                           cmd->argv[i]);
+                status = 1;
+            }
+        }
+        return status;
+    }
+
+    out_puts(&io->err, "enable: usage: enable [-f file name...] [-d name...]\n");
+    return 2;
+}
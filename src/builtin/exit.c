@@ -2,9 +2,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "builtin/builtin.h"
 #include "shell.h"
 
-int exec_exit(const Command* cmd) {
+int exec_exit(const Command* cmd, BuiltinIO* io) {
     int code = 0;  // default exit code
 
     // If user provides an argument: exit <code>
@@ -12,7 +13,7 @@ int exec_exit(const Command* cmd) {
         char* endptr = NULL;
         code = strtol(cmd->argv[1], &endptr, 10);
         if (*endptr != '\0') {
-            fprintf(stderr, "exit: numeric argument required\n");
+            out_puts(&io->err, "exit: numeric argument required\n");
             code = 1;
         }
     }
@@ -21,5 +22,7 @@ int exec_exit(const Command* cmd) {
     // free_parsed_command(cmd);  // if you want to free immediately
     // free any other global resources if needed
 
+    builtin_io_close(io);
+    shell_last_status = code;  // for atexit handlers reporting the status
     exit(code);  // terminate shell
 }
\ No newline at end of file
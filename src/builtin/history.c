@@ -1,45 +1,42 @@
-#include <readline/history.h>
-#include <readline/readline.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "builtin/builtin.h"
+#include "input/history.h"
 #include "shell.h"
 
-void print_history(int limit) {
-    HIST_ENTRY** list = history_list();  // get all history entries
-    if (!list) {
-        printf("No history.\n");
+void print_history(OutBuf* out, int limit) {
+    int total = hist_count();
+    if (total == 0) {
+        out_puts(out, "No history.\n");
         return;
     }
 
-    int total = history_length;
     int start = 0;
     if (limit > 0 && limit < total) {
         start = total - limit;  // last 'limit' entries
     }
 
     for (int i = start; i < total; ++i) {
-        HIST_ENTRY* entry = list[i];  // direct array access
-        if (entry && entry->line) {
-            printf("%5d  %s\n", i + history_base, entry->line);
-        }
+        const char* line = hist_get(i);
+        if (line) out_printf(out, "%5d  %s\n", i + hist_base(), line);
     }
 }
 
 typedef int (*history_op_func)(const char* filename);
 
 // NOT thread-safe!
-int history_read_op(const char* filename) { return read_history(filename); }
-int history_write_op(const char* filename) { return write_history(filename); }
+int history_read_op(const char* filename) { return hist_read(filename); }
+int history_write_op(const char* filename) { return hist_write(filename); }
 static int last_append_index = 0;
 int history_append_op(const char* filename) {
-    int new_entries = history_length - last_append_index;
+    int new_entries = (int)hist_count() - last_append_index;
     if (new_entries <= 0) return 0;
 
-    int result = append_history(new_entries, filename);
+    int result = hist_append(filename, new_entries);
     if (result == 0) {
-        last_append_index = history_length;
+        last_append_index = hist_count();
     }
     return result;
 }
@@ -55,11 +52,11 @@ static history_op_entry history_ops[] = {
     {'a', history_append_op},
 };
 
-int exec_history(const Command* c) {
+int exec_history(const Command* c, BuiltinIO* io) {
     if (c->argc > 2) {
         if (c->argv[1][0] != '-') {
-            fprintf(stderr, "history: invalid second argument '%s'\n",
-                    c->argv[1]);
+            out_printf(&io->err, "history: invalid second argument '%s'\n",
+                       c->argv[1]);
             return 1;
         } else {
             char mode = c->argv[1][1];
@@ -68,13 +65,13 @@ int exec_history(const Command* c) {
                 if (history_ops[i].mode == mode) {
                     int result = history_ops[i].func(c->argv[2]);
                     if (result != 0) {
-                        fprintf(stderr, "history: couldn't %c %s\n", mode,
-                                c->argv[2]);
+                        out_printf(&io->err, "history: couldn't %c %s\n",
+                                   mode, c->argv[2]);
                     }
                     return result;
                 }
             }
-            fprintf(stderr, "history: invalid mode '%c'\n", mode);
+            out_printf(&io->err, "history: invalid mode '%c'\n", mode);
             return 1;
         }
 
@@ -84,23 +81,28 @@ int exec_history(const Command* c) {
             char* endptr;
             history_limit = strtol(c->argv[1], &endptr, 10);
             if (*endptr != '\0' || history_limit < 0) {
-                printf("Invalid history limit: %s\n", c->argv[1]);
+                out_printf(&io->out, "Invalid history limit: %s\n",
+                           c->argv[1]);
                 return 1;
             }
         }
 
-        print_history(history_limit);
+        print_history(&io->out, history_limit);
     }
     return 0;
 }
 
 void initialize_history() {
     const char* HISTFILE_PATH = getenv("HISTFILE");
-    read_history(HISTFILE_PATH);
+    hist_read(HISTFILE_PATH);
+}
+
+void history_stats(size_t* entries, size_t* bytes) {
+    *entries = hist_count();
+    *bytes = hist_bytes();
 }
 
 void save_history() {
     const char* HISTFILE_PATH = getenv("HISTFILE");
-    // append_history(history_length, HISTFILE_PATH);
-    write_history(HISTFILE_PATH);
+    hist_write(HISTFILE_PATH);
 }
\ No newline at end of file
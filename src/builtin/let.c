@@ -0,0 +1,23 @@
+#include <stdint.h>
+
+#include "builtin/builtin.h"
+#include "expand/arith.h"
+#include "shell.h"
+
+// let EXPR...   evaluate each argument; status 0 if the last one is nonzero
+int exec_let(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc < 2) {
+        out_puts(&io->err, "let: expression expected\n");
+        return 2;
+    }
+
+    int64_t value = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        const char* error;
+        if (!arith_eval(cmd->argv[i], &value, &error)) {
+            out_printf(&io->err, "let: %s: %s\n", cmd->argv[i], error);
+            return 2;
+        }
+    }
+    return value == 0;
+}
@@ -0,0 +1,30 @@
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "expand/vars.h"
+#include "shell.h"
+
+// local NAME[=VALUE]...   variables restored when the function returns
+int exec_local(const Command* cmd, BuiltinIO* io) {
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        const char* arg = cmd->argv[i];
+        const char* eq = strchr(arg, '=');
+        size_t len = eq ? (size_t)(eq - arg) : strlen(arg);
+
+        char name[len + 1];
+        memcpy(name, arg, len);
+        name[len] = '\0';
+        if (!vars_valid_name(name, len)) {
+            out_printf(&io->err, "local: %s: not a valid identifier\n", arg);
+            status = 1;
+            continue;
+        }
+        if (!vars_make_local(name)) {
+            out_puts(&io->err, "local: can only be used in a function\n");
+            return 1;
+        }
+        if (eq) vars_set(name, eq + 1);
+    }
+    return status;
+}
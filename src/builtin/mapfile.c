@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "builtin/builtin.h"
+#include "expand/vars.h"
+#include "shell.h"
+
+#define MAPFILE_READ_CHUNK 65536
+
+// The rest of fd's input. A regular file is mapped (*map set, for
+// munmap) and starts at the current offset; other input is read into a
+// buffer, which *map returns as NULL.
+static const char* load_input(int fd, size_t* len, void** map,
+                              size_t* map_len, off_t* offset) {
+    struct stat st;
+    *map = NULL;
+    *offset = -1;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        off_t cur = lseek(fd, 0, SEEK_CUR);
+        if (cur >= 0 && cur >= st.st_size) {
+            *len = 0;
+            *offset = cur;
+            return "";
+        }
+        void* m = cur >= 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                                  fd, 0)
+                           : MAP_FAILED;
+        if (m != MAP_FAILED) {
+            posix_madvise(m, st.st_size, POSIX_MADV_SEQUENTIAL);
+            *map = m;
+            *map_len = st.st_size;
+            *len = st.st_size - cur;
+            *offset = cur;
+            return (const char*)m + cur;
+        }
+    }
+
+    char* buf = NULL;
+    size_t n = 0, capacity = 0;
+    while (1) {
+        if (capacity - n < MAPFILE_READ_CHUNK) {
+            capacity = capacity ? capacity * 2 : MAPFILE_READ_CHUNK * 2;
+            char* tmp = realloc(buf, capacity);
+            if (!tmp) {
+                free(buf);
+                return NULL;
+            }
+            buf = tmp;
+        }
+        ssize_t r = read(fd, buf + n, capacity - n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;
+        n += r;
+    }
+    *len = n;
+    return buf ? buf : strdup("");
+}
+
+static bool parse_count(const char* s, size_t* count) {
+    if (!s || !isdigit((unsigned char)*s)) return false;
+    char* end;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*end || errno == ERANGE) return false;
+    *count = v;
+    return true;
+}
+
+// mapfile [-t] [-d DELIM] [-n COUNT] [-s SKIP] [NAME]
+//     reads the lines of stdin into the array NAME (default MAPFILE).
+//     -t strips the delimiter, -d uses DELIM's first character ('' for
+//     NUL) instead of a newline, -n stops after COUNT lines (0: all) and
+//     -s discards the first SKIP. A regular file is left positioned after
+//     the last line taken.
+int exec_mapfile(const Command* cmd, BuiltinIO* io) {
+    bool strip = false;
+    int delim = '\n';
+    size_t limit = 0, skip = 0;
+    int i = 1;
+    for (; i < cmd->argc && cmd->argv[i][0] == '-'; i++) {
+        const char* arg = cmd->argv[i];
+        const char* value = i + 1 < cmd->argc ? cmd->argv[i + 1] : NULL;
+        if (strcmp(arg, "-t") == 0) {
+            strip = true;
+        } else if (strcmp(arg, "-d") == 0 && value) {
+            delim = (unsigned char)value[0];
+            i++;
+        } else if (strcmp(arg, "-n") == 0 && parse_count(value, &limit)) {
+            i++;
+        } else if (strcmp(arg, "-s") == 0 && parse_count(value, &skip)) {
+            i++;
+        } else {
+            out_puts(&io->err, "mapfile: usage: mapfile [-t] [-d DELIM] "
+                               "[-n COUNT] [-s SKIP] [NAME]\n");
+            return 2;
+        }
+    }
+    if (i + 1 < cmd->argc) {
+        out_puts(&io->err, "mapfile: too many arguments\n");
+        return 2;
+    }
+    const char* name = i < cmd->argc ? cmd->argv[i] : "MAPFILE";
+    if (!vars_valid_name(name, strlen(name))) {
+        out_printf(&io->err, "mapfile: `%s': not a valid identifier\n", name);
+        return 2;
+    }
+
+    size_t len, map_len = 0;
+    void* map;
+    off_t offset;
+    const char* data = load_input(io->in, &len, &map, &map_len, &offset);
+    if (!data) {
+        out_puts(&io->err, "mapfile: out of memory\n");
+        return 1;
+    }
+
+    // first pass: where the skipped lines end and the taken ones do
+    const char* end = data + len;
+    const char* start = data;
+    for (size_t k = 0; k < skip && start < end; k++) {
+        const char* nl = memchr(start, delim, end - start);
+        start = nl ? nl + 1 : end;
+    }
+    size_t count = 0;
+    const char* stop = start;
+    while (stop < end && (limit == 0 || count < limit)) {
+        const char* nl = memchr(stop, delim, end - stop);
+        stop = nl ? nl + 1 : end;
+        count++;
+    }
+
+    // second pass: every line gets its own terminator in one block
+    char** items = malloc(sizeof(char*) * (count ? count : 1));
+    char* storage = malloc((stop - start) + count + 1);
+    int status = 0;
+    if (!items || !storage) {
+        free(items);
+        free(storage);
+        out_puts(&io->err, "mapfile: out of memory\n");
+        status = 1;
+    } else {
+        char* w = storage;
+        const char* p = start;
+        for (size_t k = 0; k < count; k++) {
+            const char* nl = memchr(p, delim, stop - p);
+            const char* line_end = nl ? nl + 1 : stop;
+            size_t n = line_end - p - (nl && strip ? 1 : 0);
+            memcpy(w, p, n);
+            w[n] = '\0';
+            items[k] = w;
+            w += n + 1;
+            p = line_end;
+        }
+        if (!vars_set_array(name, items, count, storage)) status = 1;
+    }
+
+    // whoever reads the fd next starts after the last line taken
+    if (offset >= 0) lseek(io->in, offset + (stop - data), SEEK_SET);
+    if (map) {
+        munmap(map, map_len);
+    } else if (offset < 0) {
+        free((char*)data);
+    }
+    return status;
+}
@@ -0,0 +1,120 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "exec/exec.h"
+#include "exec/wait.h"
+#include "shell.h"
+#include "util/memo.h"
+
+static void replay(const MemoEntry* e, BuiltinIO* io) {
+    // the entry stays mapped until both streams are flushed
+    out_ref(&io->out, e->out, e->out_len);
+    out_flush(&io->out);
+    out_ref(&io->err, e->err, e->err_len);
+    out_flush(&io->err);
+}
+
+static double mib(uint64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+static int print_stats(BuiltinIO* io) {
+    MemoStats s = memo_stats();
+    OutBuf* out = &io->out;
+    out_printf(out, "%-14s %s\n", "directory", s.dir ? s.dir : "(none)");
+    out_printf(out, "%-14s %zu, %.1f MiB of %.1f MiB\n", "entries", s.entries,
+               mib(s.bytes), mib(s.max_bytes));
+    out_printf(out, "%-14s %lu hits, %lu misses, %lu stored, %lu evicted\n",
+               "session", s.hits, s.misses, s.stores, s.evictions);
+    out_printf(out, "%-14s %.3f s of original run time\n", "saved",
+               s.saved_ns / 1e9);
+    return 0;
+}
+
+// Runs inner and records it under key; without a usable cache it just runs
+static int run_and_store(const Command* inner, const MemoKey* key,
+                         BuiltinIO* io) {
+    MemoCapture cap;
+    if (!memo_capture_begin(key, &cap)) {
+        out_flush(&io->out);
+        out_flush(&io->err);
+        return execute_captured(inner, io->out.fd, io->err.fd);
+    }
+
+    int64_t start = monotonic_ns();
+    int status = execute_captured(inner, cap.out_fd, cap.err_fd);
+    int64_t run_ns = monotonic_ns() - start;
+
+    MemoEntry entry;
+    if (!memo_capture_end(&cap, key, status, run_ns, &entry)) {
+        out_puts(&io->err, "memo: could not record the output\n");
+        return status;
+    }
+    replay(&entry, io);
+    memo_entry_release(&entry);
+    return status;
+}
+
+// memo [-d PATH]... [-e NAME]... [--] command [arg...]
+//     replay command's stdout, stderr and status from the cache, keyed on
+//     argv, cwd, the environment variables NAME and the mtimes of PATHs
+// memo --stats   cache size and this session's hits
+// memo --clear   delete every entry
+int exec_memo(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc == 2 && strcmp(cmd->argv[1], "--stats") == 0) {
+        return print_stats(io);
+    }
+    if (cmd->argc == 2 && strcmp(cmd->argv[1], "--clear") == 0) {
+        out_printf(&io->out, "%zu entries removed\n", memo_clear());
+        return 0;
+    }
+
+    char* env[cmd->argc];
+    char* deps[cmd->argc];
+    size_t env_count = 0, dep_count = 0;
+    int i = 1;
+    for (; i < cmd->argc; i++) {
+        const char* arg = cmd->argv[i];
+        if (strcmp(arg, "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(arg, "-d") != 0 && strcmp(arg, "-e") != 0) break;
+        if (i + 1 >= cmd->argc) {
+            out_printf(&io->err, "memo: %s: argument required\n", arg);
+            return 2;
+        }
+        if (arg[1] == 'd') {
+            deps[dep_count++] = cmd->argv[++i];
+        } else {
+            env[env_count++] = cmd->argv[++i];
+        }
+    }
+    env[env_count] = NULL;
+    deps[dep_count] = NULL;
+
+    if (i >= cmd->argc) {
+        out_puts(&io->err,
+                 "memo: usage: memo [-d PATH]... [-e NAME]... [--] command "
+                 "[arg...] | --stats | --clear\n");
+        return 2;
+    }
+    Command inner = {.argv = cmd->argv + i, .argc = cmd->argc - i};
+
+    MemoKey key;
+    if (!memo_key(&key, inner.argv, env, deps)) {
+        out_puts(&io->err, "memo: cannot build cache key\n");
+        return 1;
+    }
+
+    MemoEntry entry;
+    int status;
+    if (memo_lookup(&key, &entry)) {
+        replay(&entry, io);
+        status = entry.status;
+        memo_entry_release(&entry);
+    } else {
+        status = run_and_store(&inner, &key, io);
+    }
+    memo_key_free(&key);
+    return status;
+}
@@ -0,0 +1,139 @@
+#include "output.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "exec/redirection.h"
+
+void outbuf_init(OutBuf* ob, int fd) {
+    ob->fd = fd;
+    ob->iovcnt = 0;
+    ob->used = 0;
+    ob->failed = false;
+}
+
+int out_flush(OutBuf* ob) {
+    struct iovec* iov = ob->iov;
+    int cnt = ob->iovcnt;
+
+    while (cnt > 0 && !ob->failed) {
+        ssize_t n = writev(ob->fd, iov, cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ob->failed = true;
+            break;
+        }
+        // skip fully written vectors, adjust a partially written one
+        while (cnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    ob->iovcnt = 0;
+    ob->used = 0;
+    return ob->failed ? -1 : 0;
+}
+
+static void push_iov(OutBuf* ob, const char* s, size_t n) {
+    if (ob->iovcnt == OUTBUF_IOV) out_flush(ob);
+    ob->iov[ob->iovcnt].iov_base = (void*)s;
+    ob->iov[ob->iovcnt].iov_len = n;
+    ob->iovcnt++;
+}
+
+void out_write(OutBuf* ob, const char* s, size_t n) {
+    while (n > 0) {
+        size_t room = OUTBUF_CHUNK - ob->used;
+        if (room == 0 || ob->iovcnt == OUTBUF_IOV) {
+            out_flush(ob);
+            continue;
+        }
+        size_t take = n < room ? n : room;
+        char* dst = ob->chunk + ob->used;
+        memcpy(dst, s, take);
+
+        // grow the previous vector when it ends right where we copied
+        struct iovec* last = ob->iovcnt ? &ob->iov[ob->iovcnt - 1] : NULL;
+        if (last && (char*)last->iov_base + last->iov_len == dst) {
+            last->iov_len += take;
+        } else {
+            push_iov(ob, dst, take);
+        }
+
+        ob->used += take;
+        s += take;
+        n -= take;
+    }
+}
+
+void out_ref(OutBuf* ob, const char* s, size_t n) {
+    if (n < OUTBUF_REF_MIN) {
+        out_write(ob, s, n);
+    } else {
+        push_iov(ob, s, n);
+    }
+}
+
+void out_puts(OutBuf* ob, const char* s) { out_write(ob, s, strlen(s)); }
+
+void out_printf(OutBuf* ob, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+
+    // push_iov must not flush once we've formatted into the chunk
+    if (ob->iovcnt == OUTBUF_IOV) out_flush(ob);
+    size_t room = OUTBUF_CHUNK - ob->used;
+    va_list copy;
+    va_copy(copy, ap);
+    int n = vsnprintf(ob->chunk + ob->used, room, fmt, copy);
+    va_end(copy);
+
+    if (n >= 0 && (size_t)n < room) {
+        // formatted in place; account for it like a copy
+        char* dst = ob->chunk + ob->used;
+        struct iovec* last = ob->iovcnt ? &ob->iov[ob->iovcnt - 1] : NULL;
+        if (last && (char*)last->iov_base + last->iov_len == dst) {
+            last->iov_len += n;
+        } else {
+            push_iov(ob, dst, n);
+        }
+        ob->used += n;
+    } else if (n >= 0) {
+        char* tmp = malloc((size_t)n + 1);
+        if (tmp) {
+            vsnprintf(tmp, (size_t)n + 1, fmt, ap);
+            out_write(ob, tmp, n);
+            free(tmp);
+        }
+    }
+
+    va_end(ap);
+}
+
+int builtin_io_open(BuiltinIO* io, const Command* cmd) {
+    int fds[3];
+    if (open_redirections(cmd, fds) != 0) return -1;
+
+    io->in = fds[0];
+    outbuf_init(&io->out, fds[1]);
+    outbuf_init(&io->err, fds[2]);
+    return 0;
+}
+
+void builtin_io_close(BuiltinIO* io) {
+    out_flush(&io->out);
+    out_flush(&io->err);
+
+    int fds[3] = {io->in, io->out.fd, io->err.fd};
+    close_redirections(fds);
+}
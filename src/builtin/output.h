@@ -0,0 +1,64 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "shell.h"
+
+/*
+ * Per-invocation output buffer for builtins.
+ *
+ * Small writes are copied into an inline chunk; large ones are referenced in
+ * place. Everything is handed to the kernel with a single writev() when the
+ * buffer fills up or the builtin returns.
+ */
+
+#define OUTBUF_IOV 128
+#define OUTBUF_CHUNK 16384
+// writes at least this large are referenced instead of copied
+#define OUTBUF_REF_MIN 256
+
+typedef struct {
+    int fd;
+    int iovcnt;
+    struct iovec iov[OUTBUF_IOV];
+    size_t used;  // bytes of chunk in use
+    char chunk[OUTBUF_CHUNK];
+    bool failed;
+} OutBuf;
+
+/* Resolved standard streams of one builtin invocation */
+typedef struct {
+    int in;
+    OutBuf out;
+    OutBuf err;
+} BuiltinIO;
+
+void outbuf_init(OutBuf* ob, int fd);
+
+/* Copy n bytes into the buffer */
+void out_write(OutBuf* ob, const char* s, size_t n);
+
+/* Like out_write, but s must stay valid until the next flush */
+void out_ref(OutBuf* ob, const char* s, size_t n);
+
+void out_puts(OutBuf* ob, const char* s);
+void out_printf(OutBuf* ob, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/* Returns 0 on success, -1 if any write failed */
+int out_flush(OutBuf* ob);
+
+/*
+ * Resolve the command's redirections to fds without touching the shell's
+ * own stdin/stdout/stderr. Returns 0 on success, -1 if a target can't be
+ * opened (the error has already been reported).
+ */
+int builtin_io_open(BuiltinIO* io, const Command* cmd);
+
+/* Flush both streams and close any fds opened for redirections */
+void builtin_io_close(BuiltinIO* io);
+
+#endif
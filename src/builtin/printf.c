@@ -0,0 +1,174 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "shell.h"
+
+// Emit the backslash escape starting at s[0] == '\\'.
+// Returns the number of characters consumed after the backslash.
+static int put_escape(OutBuf* out, const char* s) {
+    char c;
+    switch (s[1]) {
+        case 'a': c = '\a'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'v': c = '\v'; break;
+        case '\\': c = '\\'; break;
+        case '"': c = '"'; break;
+        case '\'': c = '\''; break;
+        case '0': case '1': case '2': case '3':
+        case '4': case '5': case '6': case '7': {
+            int value = 0, n = 0;
+            while (n < 3 && s[1 + n] >= '0' && s[1 + n] <= '7') {
+                value = value * 8 + (s[1 + n] - '0');
+                n++;
+            }
+            c = (char)value;
+            out_write(out, &c, 1);
+            return n;
+        }
+        case '\0':
+            out_write(out, "\\", 1);
+            return 0;
+        default:
+            out_write(out, s, 2);
+            return 1;
+    }
+    out_write(out, &c, 1);
+    return 1;
+}
+
+// %b argument: like %s but with escapes interpreted
+static void put_escaped_string(OutBuf* out, const char* s) {
+    while (*s) {
+        if (*s == '\\') {
+            s += put_escape(out, s) + 1;
+        } else {
+            const char* next = strchr(s, '\\');
+            size_t n = next ? (size_t)(next - s) : strlen(s);
+            out_write(out, s, n);
+            s += n;
+        }
+    }
+}
+
+// POSIX: a leading quote yields the character's code
+static long long numeric_arg(const char* arg, bool* ok) {
+    if (arg[0] == '\'' || arg[0] == '"') return (unsigned char)arg[1];
+
+    char* end;
+    long long v = strtoll(arg, &end, 0);
+    if (*arg == '\0' || *end != '\0') *ok = false;
+    return v;
+}
+
+int exec_printf(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc < 2) {
+        out_puts(&io->err, "printf: usage: printf format [arguments]\n");
+        return 2;
+    }
+
+    const char* format = cmd->argv[1];
+    int argi = 2;
+    int status = 0;
+
+    // the format is reused until all arguments are consumed
+    do {
+        int first_arg = argi;
+        const char* p = format;
+
+        while (*p) {
+            if (*p == '\\') {
+                p += put_escape(&io->out, p) + 1;
+                continue;
+            }
+            if (*p != '%') {
+                const char* next = strpbrk(p, "\\%");
+                size_t n = next ? (size_t)(next - p) : strlen(p);
+                out_write(&io->out, p, n);
+                p += n;
+                continue;
+            }
+            if (p[1] == '%') {
+                out_write(&io->out, "%", 1);
+                p += 2;
+                continue;
+            }
+
+            // copy flags/width/precision into a C conversion spec
+            char spec[32];
+            size_t si = 0;
+            spec[si++] = *p++;
+            while (*p && strchr("-+ #0123456789.", *p) && si < sizeof(spec) - 4)
+                spec[si++] = *p++;
+
+            char conv = *p ? *p++ : '\0';
+            const char* arg = argi < cmd->argc ? cmd->argv[argi++] : NULL;
+            bool ok = true;
+
+            switch (conv) {
+                case 'd':
+                case 'i':
+                case 'o':
+                case 'u':
+                case 'x':
+                case 'X': {
+                    long long v = arg ? numeric_arg(arg, &ok) : 0;
+                    spec[si++] = 'l';
+                    spec[si++] = 'l';
+                    spec[si++] = conv;
+                    spec[si] = '\0';
+                    out_printf(&io->out, spec, v);
+                    break;
+                }
+                case 'e':
+                case 'E':
+                case 'f':
+                case 'F':
+                case 'g':
+                case 'G': {
+                    double v = 0;
+                    if (arg) {
+                        char* end;
+                        v = strtod(arg, &end);
+                        if (*end != '\0') ok = false;
+                    }
+                    spec[si++] = conv;
+                    spec[si] = '\0';
+                    out_printf(&io->out, spec, v);
+                    break;
+                }
+                case 'c':
+                    if (arg && *arg) out_write(&io->out, arg, 1);
+                    break;
+                case 's':
+                    spec[si++] = 's';
+                    spec[si] = '\0';
+                    out_printf(&io->out, spec, arg ? arg : "");
+                    break;
+                case 'b':
+                    if (arg) put_escaped_string(&io->out, arg);
+                    break;
+                default:
+                    out_printf(&io->err, "printf: %%%c: invalid directive\n",
+                               conv);
+                    return 1;
+            }
+
+            if (!ok) {
+                out_printf(&io->err, "printf: %s: invalid number\n", arg);
+                status = 1;
+            }
+        }
+
+        // a format without conversions doesn't consume arguments
+        if (argi == first_arg) break;
+    } while (argi < cmd->argc);
+
+    return status;
+}
@@ -1,18 +1,22 @@
+#include <errno.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include "builtin/builtin.h"
 #include "shell.h"
 
-int exec_pwd(const Command* cmd) {
+int exec_pwd(const Command* cmd, BuiltinIO* io) {
     char* buffer = getcwd(NULL, 0);
     if (buffer == NULL) {
-        perror("getcwd");
+        out_printf(&io->err, "getcwd: %s\n", strerror(errno));
         return -1;
     }
 
-    printf("%s\n", buffer);
+    out_puts(&io->out, buffer);
+    out_write(&io->out, "\n", 1);
     free(buffer);
     return 0;
 }
\ No newline at end of file
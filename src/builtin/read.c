@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "builtin/builtin.h"
+#include "expand/vars.h"
+#include "shell.h"
+
+#define READ_FIRST_BLOCK 1024
+#define READ_BLOCK 65536
+#define DEFAULT_IFS " \t\n"
+
+/* ------------------------------------------------------------ */
+/* Input                                                        */
+/* ------------------------------------------------------------ */
+
+// Reading stops right after the delimiter, since whatever comes next
+// belongs to the next reader of the fd. A regular file is read in blocks
+// and the unused tail given back with lseek: two syscalls for a typical
+// line. Blocks start small, as most of one is given back, and double for
+// long lines. Anything else (pipes, terminals) must be read one byte per
+// call.
+typedef struct {
+    int fd;
+    bool seekable;
+    size_t block;  // next read size
+    size_t pos;
+    size_t len;
+    char buf[READ_BLOCK];
+} Input;
+
+static void input_init(Input* in, int fd) {
+    struct stat st;
+    in->fd = fd;
+    in->seekable = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    in->block = in->seekable ? READ_FIRST_BLOCK : 1;
+    in->pos = in->len = 0;
+}
+
+static bool input_fill(Input* in) {
+    ssize_t n;
+    do {
+        n = read(in->fd, in->buf, in->block);
+    } while (n < 0 && errno == EINTR);
+    if (in->seekable && in->block < READ_BLOCK) in->block *= 2;
+    in->pos = 0;
+    in->len = n > 0 ? (size_t)n : 0;
+    return n > 0;
+}
+
+static int input_byte(Input* in) {
+    if (in->pos == in->len && !input_fill(in)) return -1;
+    return (unsigned char)in->buf[in->pos++];
+}
+
+static void input_give_back(Input* in) {
+    if (in->seekable && in->pos < in->len) {
+        lseek(in->fd, -(off_t)(in->len - in->pos), SEEK_CUR);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* Line                                                         */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    char* text;
+    bool* escaped;  // per char: came after a backslash, never a separator
+    size_t len;
+    size_t capacity;
+} Line;
+
+static bool line_reserve(Line* line, size_t extra) {
+    if (line->len + extra + 1 <= line->capacity) return true;
+    size_t capacity = line->capacity ? line->capacity * 2 : 256;
+    while (capacity < line->len + extra + 1) capacity *= 2;
+    char* text = realloc(line->text, capacity);
+    if (text) line->text = text;
+    bool* escaped = realloc(line->escaped, capacity * sizeof(bool));
+    if (escaped) line->escaped = escaped;
+    if (!text || !escaped) return false;
+    line->capacity = capacity;
+    return true;
+}
+
+static bool line_append(Line* line, const char* s, size_t n, bool escaped) {
+    if (!line_reserve(line, n)) return false;
+    memcpy(line->text + line->len, s, n);
+    memset(line->escaped + line->len, escaped, n);
+    line->len += n;
+    line->text[line->len] = '\0';
+    return true;
+}
+
+// Reads up to the delimiter. Without raw, a backslash escapes the next
+// character and backslash-newline continues the line. Returns whether
+// the delimiter was seen (rather than end of input).
+static bool read_line(Input* in, Line* line, int delim, bool raw) {
+    while (1) {
+        if (raw) {
+            // whole runs up to the delimiter at once
+            if (in->pos == in->len && !input_fill(in)) return false;
+            const char* start = in->buf + in->pos;
+            size_t avail = in->len - in->pos;
+            const char* hit = memchr(start, delim, avail);
+            size_t n = hit ? (size_t)(hit - start) : avail;
+            if (!line_append(line, start, n, false)) return false;
+            in->pos += hit ? n + 1 : n;
+            if (hit) return true;
+            continue;
+        }
+
+        int c = input_byte(in);
+        if (c < 0) return false;
+        if (c == delim) return true;
+        if (c == '\\') {
+            c = input_byte(in);
+            if (c < 0) return false;
+            if (c == '\n') continue;
+            char ch = (char)c;
+            if (!line_append(line, &ch, 1, true)) return false;
+            continue;
+        }
+        char ch = (char)c;
+        if (!line_append(line, &ch, 1, false)) return false;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* Field splitting                                              */
+/* ------------------------------------------------------------ */
+
+static bool is_sep(const Line* line, size_t i, const char* ifs) {
+    char c = line->text[i];
+    return !line->escaped[i] && c != '\0' && strchr(ifs, c);
+}
+
+static bool is_sep_space(const Line* line, size_t i, const char* ifs) {
+    char c = line->text[i];
+    return is_sep(line, i, ifs) && (c == ' ' || c == '\t' || c == '\n');
+}
+
+// text[len] is always there for the terminator
+static void set_field(const char* name, Line* line, size_t start,
+                      size_t end) {
+    char saved = line->text[end];
+    line->text[end] = '\0';
+    vars_set(name, line->text + start);
+    line->text[end] = saved;
+}
+
+// IFS splitting: whitespace separators trim and collapse, any other
+// separator ends exactly one field. The last name takes the rest.
+static void assign(char* const* names, int count, Line* line) {
+    const char* ifs = vars_get("IFS");
+    if (!ifs) ifs = DEFAULT_IFS;
+
+    size_t i = 0, len = line->len;
+    while (i < len && is_sep_space(line, i, ifs)) i++;
+
+    for (int k = 0; k < count - 1; k++) {
+        size_t start = i;
+        while (i < len && !is_sep(line, i, ifs)) i++;
+        set_field(names[k], line, start, i);
+
+        while (i < len && is_sep_space(line, i, ifs)) i++;
+        if (i < len && is_sep(line, i, ifs)) {
+            i++;
+            while (i < len && is_sep_space(line, i, ifs)) i++;
+        }
+    }
+
+    size_t end = len;
+    while (end > i && is_sep_space(line, end - 1, ifs)) end--;
+    set_field(names[count - 1], line, i, end);
+}
+
+/* ------------------------------------------------------------ */
+/* Builtin                                                      */
+/* ------------------------------------------------------------ */
+
+// read [-r] [-d DELIM] [NAME...]
+//     reads one line from stdin and splits it on IFS into the NAMEs (the
+//     last one takes the rest), or stores it whole in REPLY. -r keeps
+//     backslashes; -d ends the line at DELIM's first character instead
+//     of a newline ('' for NUL). Status 1 at end of input.
+int exec_read(const Command* cmd, BuiltinIO* io) {
+    bool raw = false;
+    int delim = '\n';
+    int i = 1;
+    for (; i < cmd->argc && cmd->argv[i][0] == '-'; i++) {
+        const char* arg = cmd->argv[i];
+        if (strcmp(arg, "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(arg, "-r") == 0) {
+            raw = true;
+        } else if (strcmp(arg, "-d") == 0 && i + 1 < cmd->argc) {
+            delim = (unsigned char)cmd->argv[++i][0];
+        } else {
+            out_puts(&io->err,
+                     "read: usage: read [-r] [-d DELIM] [NAME...]\n");
+            return 2;
+        }
+    }
+
+    char* reply[] = {"REPLY"};
+    char* const* names = i < cmd->argc ? cmd->argv + i : reply;
+    int count = i < cmd->argc ? cmd->argc - i : 1;
+    for (int k = 0; k < count; k++) {
+        if (!vars_valid_name(names[k], strlen(names[k]))) {
+            out_printf(&io->err, "read: `%s': not a valid identifier\n",
+                       names[k]);
+            return 2;
+        }
+    }
+
+    Input* in = malloc(sizeof(Input));
+    if (!in) return 1;
+    input_init(in, io->in);
+    Line line = {0};
+    bool complete = read_line(in, &line, delim, raw);
+    input_give_back(in);
+    free(in);
+
+    if (!line_reserve(&line, 0)) {
+        free(line.text);
+        free(line.escaped);
+        return 1;
+    }
+    line.text[line.len] = '\0';
+    if (names == reply) {
+        vars_set("REPLY", line.text);  // as read, no splitting or trimming
+    } else {
+        assign(names, count, &line);
+    }
+    free(line.text);
+    free(line.escaped);
+    return complete ? 0 : 1;
+}
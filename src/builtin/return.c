@@ -0,0 +1,24 @@
+#include <stdlib.h>
+
+#include "builtin/builtin.h"
+#include "exec/function.h"
+#include "shell.h"
+
+// return [N]   leave the current function with status N (default $?)
+int exec_return(const Command* cmd, BuiltinIO* io) {
+    int status = shell_last_status;
+    if (cmd->argc > 1) {
+        char* end;
+        status = (int)strtol(cmd->argv[1], &end, 10) & 0xff;
+        if (*cmd->argv[1] == '\0' || *end != '\0') {
+            out_printf(&io->err, "return: %s: numeric argument required\n",
+                       cmd->argv[1]);
+            status = 2;
+        }
+    }
+    if (!function_return(status)) {
+        out_puts(&io->err, "return: can only `return' from a function\n");
+        return 1;
+    }
+    return status;
+}
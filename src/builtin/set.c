@@ -0,0 +1,84 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "shell.h"
+#include "util/trace.h"
+
+typedef struct {
+    const char* name;
+    bool* flag;
+} option_entry;
+
+static option_entry options[] = {
+    {"pipefail", &shell_options.pipefail},
+    {"pipemon", &shell_options.pipemon},
+    {"optimize", &shell_options.optimize},
+    {"explain", &shell_options.explain},
+};
+
+static option_entry* find_option(const char* name) {
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+        if (strcmp(options[i].name, name) == 0) return &options[i];
+    }
+    return NULL;
+}
+
+// trace takes a file rather than being a plain flag
+static int set_trace(bool enable, const char* name, BuiltinIO* io) {
+    if (!enable) {
+        trace_stop();
+        return 0;
+    }
+    if (name[5] != '=' || name[6] == '\0') {
+        out_printf(&io->err, "set: trace: usage: set -o trace=FILE\n");
+        return 1;
+    }
+    return trace_start(name + 6) == 0 ? 0 : 1;
+}
+
+// set -o             list options
+// set -o NAME        enable NAME
+// set +o NAME        disable NAME
+// set -o trace=FILE  record a trace of execution into FILE
+int exec_set(const Command* cmd, BuiltinIO* io) {
+    if (cmd->argc == 1 || (cmd->argc == 2 && strcmp(cmd->argv[1], "-o") == 0)) {
+        for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+            out_printf(&io->out, "%-15s %s\n", options[i].name,
+                       *options[i].flag ? "on" : "off");
+        }
+        out_printf(&io->out, "%-15s %s\n", "trace",
+                   trace_enabled() ? "on" : "off");
+        return 0;
+    }
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        const char* arg = cmd->argv[i];
+        bool enable = strcmp(arg, "-o") == 0;
+        if (!enable && strcmp(arg, "+o") != 0) {
+            out_printf(&io->err, "set: %s: invalid option\n", arg);
+            return 2;
+        }
+        if (i + 1 >= cmd->argc) {
+            out_printf(&io->err, "set: %s: option name required\n", arg);
+            return 2;
+        }
+
+        const char* name = cmd->argv[++i];
+        if (strncmp(name, "trace", 5) == 0 &&
+            (name[5] == '\0' || name[5] == '=')) {
+            if (set_trace(enable, name, io) != 0) status = 1;
+            continue;
+        }
+
+        option_entry* opt = find_option(name);
+        if (!opt) {
+            out_printf(&io->err, "set: %s: invalid option name\n", name);
+            status = 1;
+            continue;
+        }
+        *opt->flag = enable;
+    }
+    return status;
+}
@@ -0,0 +1,104 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+#include "exec/exec.h"
+#include "parse/parsecache.h"
+#include "shell.h"
+#include "util/dircache.h"
+#include "util/scanners.h"
+
+static double mean_us(int64_t total_ns, unsigned long n) {
+    return n ? total_ns / 1000.0 / n : 0.0;
+}
+
+static double hit_rate(unsigned long hits, unsigned long misses) {
+    unsigned long lookups = hits + misses;
+    return lookups ? 100.0 * hits / lookups : 0.0;
+}
+
+static void print_table(OutBuf* out, const char* label, const HashStats* s) {
+    out_printf(out, "%-14s %zu/%zu slots (load %.2f), probes mean %.2f max %zu\n",
+               label, s->count, s->capacity, hash_load_factor(s), s->mean_probe,
+               s->max_probe);
+}
+
+static void print_table_json(OutBuf* out, const char* key, const HashStats* s) {
+    out_printf(out,
+               "\"%s\":{\"count\":%zu,\"capacity\":%zu,\"load\":%.4f,"
+               "\"mean_probe\":%.4f,\"max_probe\":%zu}",
+               key, s->count, s->capacity, hash_load_factor(s), s->mean_probe,
+               s->max_probe);
+}
+
+// shellstats      human-readable report
+// shellstats -j   the same as a single JSON object
+int exec_shellstats(const Command* cmd, BuiltinIO* io) {
+    bool json = false;
+    if (cmd->argc == 2 && strcmp(cmd->argv[1], "-j") == 0) {
+        json = true;
+    } else if (cmd->argc > 1) {
+        out_puts(&io->err, "shellstats: usage: shellstats [-j]\n");
+        return 2;
+    }
+
+    PathCacheStats path = path_cache_stats();
+    HashStats builtins = builtin_index_stats();
+    DirCacheStats dirs = dircache_stats();
+    const ExecStats* ex = exec_stats();
+    size_t hist_entries, hist_bytes;
+    history_stats(&hist_entries, &hist_bytes);
+    ParseCacheStats parsed = parse_cache_stats();
+
+    OutBuf* out = &io->out;
+    if (json) {
+        out_printf(out, "{\"path_cache\":{\"entries\":%zu,\"bytes\":%zu,",
+                   path.entries, path.bytes);
+        print_table_json(out, "names", &path.names);
+        out_puts(out, ",");
+        print_table_json(out, "dirs", &path.dirs);
+        out_puts(out, "},");
+        print_table_json(out, "builtins", &builtins);
+        out_printf(out,
+                   ",\"completion\":{\"hits\":%lu,\"misses\":%lu},"
+                   "\"history\":{\"entries\":%zu,\"bytes\":%zu},",
+                   dirs.hits, dirs.misses, hist_entries, hist_bytes);
+        out_printf(out,
+                   "\"parse_cache\":{\"hits\":%lu,\"misses\":%lu,"
+                   "\"evictions\":%lu,\"entries\":%zu,\"bytes\":%zu,"
+                   "\"budget\":%zu},",
+                   parsed.hits, parsed.misses, parsed.evictions,
+                   parsed.entries, parsed.bytes, parsed.budget);
+        out_printf(out,
+                   "\"exec\":{\"builtins\":%lu,\"forks\":%lu,\"execs\":%lu,"
+                   "\"waits\":%lu,\"fork_ns\":%lld,\"fork_max_ns\":%lld,"
+                   "\"wait_ns\":%lld,\"wait_max_ns\":%lld}}\n",
+                   ex->builtins, ex->forks, ex->execs, ex->waits,
+                   (long long)ex->fork_ns, (long long)ex->fork_max_ns,
+                   (long long)ex->wait_ns, (long long)ex->wait_max_ns);
+        return 0;
+    }
+
+    out_printf(out, "%-14s %zu entries, %zu bytes\n", "path cache",
+               path.entries, path.bytes);
+    print_table(out, "  name index", &path.names);
+    print_table(out, "  dir index", &path.dirs);
+    print_table(out, "builtins", &builtins);
+    out_printf(out, "%-14s %lu hits, %lu misses (%.1f%% hit rate)\n",
+               "completion", dirs.hits, dirs.misses, hit_rate(dirs.hits, dirs.misses));
+    out_printf(out, "%-14s %zu entries, %zu bytes\n", "history", hist_entries,
+               hist_bytes);
+    out_printf(out, "%-14s %zu entries, %zu/%zu bytes\n", "parse cache",
+               parsed.entries, parsed.bytes, parsed.budget);
+    out_printf(out, "%-14s %lu hits, %lu misses (%.1f%% hit rate), "
+               "%lu evicted\n", "", parsed.hits, parsed.misses,
+               hit_rate(parsed.hits, parsed.misses), parsed.evictions);
+    out_printf(out, "%-14s %lu in-shell builtins, %lu forks, %lu execs\n",
+               "processes", ex->builtins, ex->forks, ex->execs);
+    out_printf(out, "%-14s mean %.1f us, max %.1f us\n", "  fork",
+               mean_us(ex->fork_ns, ex->forks), ex->fork_max_ns / 1000.0);
+    out_printf(out, "%-14s %lu waits, mean %.1f us, max %.1f us\n", "  wait",
+               ex->waits, mean_us(ex->wait_ns, ex->waits),
+               ex->wait_max_ns / 1000.0);
+    return 0;
+}
@@ -0,0 +1,318 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "builtin/builtin.h"
+#include "shell.h"
+
+// exit statuses of test(1)
+enum { TEST_TRUE = 0, TEST_FALSE = 1, TEST_ERROR = 2 };
+
+typedef struct {
+    char** args;
+    int count;
+    int pos;
+    const char* name;  // "test" or "["
+    BuiltinIO* io;
+    bool failed;
+} TestParser;
+
+static bool syntax_error(TestParser* tp, const char* what, const char* arg) {
+    if (!tp->failed) {
+        if (arg) {
+            out_printf(&tp->io->err, "%s: %s: %s\n", tp->name, arg, what);
+        } else {
+            out_printf(&tp->io->err, "%s: %s\n", tp->name, what);
+        }
+    }
+    tp->failed = true;
+    return false;
+}
+
+/* ------------------------------------------------------------ */
+/* Primaries                                                    */
+/* ------------------------------------------------------------ */
+
+static bool parse_integer(TestParser* tp, const char* s, long long* out) {
+    const char* p = s;
+    while (isblank((unsigned char)*p)) p++;
+
+    char* end;
+    errno = 0;
+    long long v = strtoll(p, &end, 10);
+    while (isblank((unsigned char)*end)) end++;
+    if (end == p || *end || errno == ERANGE) {
+        return syntax_error(tp, "integer expression expected", s);
+    }
+    *out = v;
+    return true;
+}
+
+static bool is_unary_op(const char* s) {
+    return s[0] == '-' && s[1] && !s[2] && strchr("bcdefghLnprsStuwxzGO", s[1]);
+}
+
+static bool is_binary_op(const char* s) {
+    static const char* const ops[] = {"=",   "==",  "!=",  "<",   ">",
+                                      "-eq", "-ne", "-lt", "-le", "-gt",
+                                      "-ge", "-nt", "-ot", "-ef"};
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(s, ops[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool file_test(char op, const char* path) {
+    struct stat st;
+    int flags = op == 'h' || op == 'L' ? AT_SYMLINK_NOFOLLOW : 0;
+
+    switch (op) {
+        case 'r':
+            return faccessat(AT_FDCWD, path, R_OK, AT_EACCESS) == 0;
+        case 'w':
+            return faccessat(AT_FDCWD, path, W_OK, AT_EACCESS) == 0;
+        case 'x':
+            return faccessat(AT_FDCWD, path, X_OK, AT_EACCESS) == 0;
+    }
+
+    if (fstatat(AT_FDCWD, path, &st, flags) != 0) return false;
+    switch (op) {
+        case 'b': return S_ISBLK(st.st_mode);
+        case 'c': return S_ISCHR(st.st_mode);
+        case 'd': return S_ISDIR(st.st_mode);
+        case 'e': return true;
+        case 'f': return S_ISREG(st.st_mode);
+        case 'g': return (st.st_mode & S_ISGID) != 0;
+        case 'h':
+        case 'L': return S_ISLNK(st.st_mode);
+        case 'p': return S_ISFIFO(st.st_mode);
+        case 's': return st.st_size > 0;
+        case 'S': return S_ISSOCK(st.st_mode);
+        case 'u': return (st.st_mode & S_ISUID) != 0;
+        case 'G': return st.st_gid == getegid();
+        case 'O': return st.st_uid == geteuid();
+    }
+    return false;
+}
+
+// -t FD: the builtin's redirections resolve into io rather than onto
+// fds 0-2, so those three are asked of the streams it actually has
+static bool is_terminal(const BuiltinIO* io, long long fd) {
+    switch (fd) {
+        case STDIN_FILENO: return isatty(io->in);
+        case STDOUT_FILENO: return isatty(io->out.fd);
+        case STDERR_FILENO: return isatty(io->err.fd);
+    }
+    return fd >= 0 && fd <= INT32_MAX && isatty((int)fd);
+}
+
+static bool unary(TestParser* tp, const char* op, const char* arg) {
+    switch (op[1]) {
+        case 'n': return arg[0] != '\0';
+        case 'z': return arg[0] == '\0';
+        case 't': {
+            long long fd;
+            if (!parse_integer(tp, arg, &fd)) return false;
+            return is_terminal(tp->io, fd);
+        }
+    }
+    return file_test(op[1], arg);
+}
+
+static bool newer(const struct stat* a, const struct stat* b) {
+    return a->st_mtim.tv_sec > b->st_mtim.tv_sec ||
+           (a->st_mtim.tv_sec == b->st_mtim.tv_sec &&
+            a->st_mtim.tv_nsec > b->st_mtim.tv_nsec);
+}
+
+static bool binary(TestParser* tp, const char* lhs, const char* op,
+                   const char* rhs) {
+    if (op[0] != '-') {
+        int cmp = strcmp(lhs, rhs);
+        if (op[0] == '<') return cmp < 0;
+        if (op[0] == '>') return cmp > 0;
+        return op[0] == '!' ? cmp != 0 : cmp == 0;
+    }
+
+    if (op[1] == 'n' || op[1] == 'o' || (op[1] == 'e' && op[2] == 'f')) {
+        // file comparisons; a missing file is older than an existing one
+        struct stat a, b;
+        bool have_a = stat(lhs, &a) == 0, have_b = stat(rhs, &b) == 0;
+        if (op[1] == 'e') {
+            return have_a && have_b && a.st_dev == b.st_dev &&
+                   a.st_ino == b.st_ino;
+        }
+        if (op[1] == 'n') return have_a && (!have_b || newer(&a, &b));
+        return have_b && (!have_a || newer(&b, &a));
+    }
+
+    long long a, b;
+    if (!parse_integer(tp, lhs, &a) || !parse_integer(tp, rhs, &b)) {
+        return false;
+    }
+    if (strcmp(op, "-eq") == 0) return a == b;
+    if (strcmp(op, "-ne") == 0) return a != b;
+    if (strcmp(op, "-lt") == 0) return a < b;
+    if (strcmp(op, "-le") == 0) return a <= b;
+    if (strcmp(op, "-gt") == 0) return a > b;
+    return a >= b;  // -ge
+}
+
+/* ------------------------------------------------------------ */
+/* Expression grammar                                           */
+/*   expr    := and ( -o and )*                                 */
+/*   and     := not ( -a not )*                                 */
+/*   not     := ! not | primary                                 */
+/*   primary := ( expr ) | UNARY arg | arg BINARY arg | arg     */
+/* ------------------------------------------------------------ */
+
+static const char* peek(TestParser* tp, int ahead) {
+    int i = tp->pos + ahead;
+    return i < tp->count ? tp->args[i] : NULL;
+}
+
+static const char* next(TestParser* tp) {
+    if (tp->pos >= tp->count) {
+        syntax_error(tp, "argument expected", NULL);
+        return NULL;
+    }
+    return tp->args[tp->pos++];
+}
+
+static bool parse_or(TestParser* tp);
+
+static bool parse_primary(TestParser* tp) {
+    const char* arg = next(tp);
+    if (!arg) return false;
+
+    // a binary operator wins over the word being an operator itself,
+    // so `[ -n = -n ]` compares strings
+    const char* op = peek(tp, 0);
+    if (op && peek(tp, 1) && is_binary_op(op)) {
+        tp->pos += 2;
+        return binary(tp, arg, op, tp->args[tp->pos - 1]);
+    }
+
+    if (strcmp(arg, "(") == 0) {
+        bool value = parse_or(tp);
+        const char* close = next(tp);
+        if (close && strcmp(close, ")") != 0) {
+            return syntax_error(tp, "`)' expected", close);
+        }
+        return value;
+    }
+
+    if (is_unary_op(arg) && peek(tp, 0)) {
+        return unary(tp, arg, next(tp));
+    }
+    return arg[0] != '\0';
+}
+
+static bool parse_not(TestParser* tp) {
+    const char* arg = peek(tp, 0);
+    if (arg && strcmp(arg, "!") == 0 && peek(tp, 1)) {
+        tp->pos++;
+        return !parse_not(tp);
+    }
+    return parse_primary(tp);
+}
+
+static bool parse_and(TestParser* tp) {
+    bool value = parse_not(tp);
+    while (!tp->failed && peek(tp, 0) && strcmp(peek(tp, 0), "-a") == 0) {
+        tp->pos++;
+        bool rhs = parse_not(tp);
+        value = value && rhs;
+    }
+    return value;
+}
+
+static bool parse_or(TestParser* tp) {
+    bool value = parse_and(tp);
+    while (!tp->failed && peek(tp, 0) && strcmp(peek(tp, 0), "-o") == 0) {
+        tp->pos++;
+        bool rhs = parse_and(tp);
+        value = value || rhs;
+    }
+    return value;
+}
+
+/* ------------------------------------------------------------ */
+/* POSIX argument-count rules                                   */
+/* ------------------------------------------------------------ */
+
+// POSIX fixes the meaning of up to four arguments by their count, which
+// keeps e.g. `test ! -f` and `test "(" = "("` unambiguous
+static bool evaluate(TestParser* tp, int start, int n) {
+    char** a = tp->args + start;
+
+    switch (n) {
+        case 0:
+            return false;
+        case 1:
+            return a[0][0] != '\0';
+        case 2:
+            if (strcmp(a[0], "!") == 0) return a[1][0] == '\0';
+            if (is_unary_op(a[0])) return unary(tp, a[0], a[1]);
+            return syntax_error(tp, "unary operator expected", a[0]);
+        case 3:
+            if (is_binary_op(a[1])) return binary(tp, a[0], a[1], a[2]);
+            if (strcmp(a[1], "-a") == 0) return a[0][0] && a[2][0];
+            if (strcmp(a[1], "-o") == 0) return a[0][0] || a[2][0];
+            if (strcmp(a[0], "!") == 0) return !evaluate(tp, start + 1, 2);
+            if (strcmp(a[0], "(") == 0 && strcmp(a[2], ")") == 0)
+                return a[1][0] != '\0';
+            return syntax_error(tp, "binary operator expected", a[1]);
+        case 4:
+            if (strcmp(a[0], "!") == 0) return !evaluate(tp, start + 1, 3);
+            if (strcmp(a[0], "(") == 0 && strcmp(a[3], ")") == 0)
+                return evaluate(tp, start + 1, 2);
+            break;
+    }
+
+    tp->pos = start;
+    bool value = parse_or(tp);
+    if (!tp->failed && tp->pos < tp->count) {
+        syntax_error(tp, "too many arguments", NULL);
+    }
+    return value;
+}
+
+// test EXPR / [ EXPR ]
+int exec_test(const Command* cmd, BuiltinIO* io) {
+    int count = cmd->argc;
+    const char* name = cmd->argv[0];
+
+    if (strcmp(name, "[") == 0) {
+        if (count < 2 || strcmp(cmd->argv[count - 1], "]") != 0) {
+            out_puts(&io->err, "[: missing `]'\n");
+            return TEST_ERROR;
+        }
+        count--;
+    }
+
+    TestParser tp = {cmd->argv, count, 1, name, io, false};
+    bool value = evaluate(&tp, 1, count - 1);
+    if (tp.failed) return TEST_ERROR;
+    return value ? TEST_TRUE : TEST_FALSE;
+}
+
+int exec_true(const Command* cmd, BuiltinIO* io) {
+    (void)cmd;
+    (void)io;
+    return 0;
+}
+
+int exec_false(const Command* cmd, BuiltinIO* io) {
+    (void)cmd;
+    (void)io;
+    return 1;
+}
@@ -3,23 +3,30 @@
 #include <stdlib.h>
 
 #include "builtin/builtin.h"
+#include "exec/function.h"
 #include "exec/path.h"
+#include "parse/alias.h"
 #include "shell.h"
 
-int exec_type(const Command* cmd) {
+int exec_type(const Command* cmd, BuiltinIO* io) {
     if (cmd->argc < 2 || cmd->argv[1] == NULL) {
         return 2;
     }
-    if (find_builtin(cmd->argv[1]) == NULL) {
+    const char* alias = alias_get(cmd->argv[1]);
+    if (alias) {
+        out_printf(&io->out, "%s is aliased to `%s'\n", cmd->argv[1], alias);
+    } else if (function_find(cmd->argv[1])) {
+        out_printf(&io->out, "%s is a function\n", cmd->argv[1]);
+    } else if (find_builtin(cmd->argv[1]) == NULL) {
         char* result = path_lookup(cmd->argv[1]);
         if (!result) {
-            printf("%s: not found\n", cmd->argv[1]);
+            out_printf(&io->out, "%s: not found\n", cmd->argv[1]);
         } else {
-            printf("%s is %s\n", cmd->argv[1], result);
+            out_printf(&io->out, "%s is %s\n", cmd->argv[1], result);
             free(result);
         }
     } else {
-        printf("%s is a shell builtin\n", cmd->argv[1]);
+        out_printf(&io->out, "%s is a shell builtin\n", cmd->argv[1]);
     }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(HASHMAP_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define HASHMAP_SSE2 1
+#endif
+
+#define HASHMAP_MIN_CAPACITY 16  // at least HASHMAP_GROUP
+#define LOAD_FACTOR_NUM 7
+#define LOAD_FACTOR_DEN 8
+
+/* ------------------------------------------------------------ */
+/* Hashing                                                      */
+/* ------------------------------------------------------------ */
+
+static uint64_t hash_key(const char* s) {
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    // FNV-1a's low bits pick the slot; fold the high bits in, the tag
+    // below is taken from the top 7
+    return h ^ (h >> 32);
+}
+
+static uint8_t tag_of(uint64_t hash) { return 0x80 | (uint8_t)(hash >> 57); }
+
+/* ------------------------------------------------------------ */
+/* Slots                                                        */
+/* ------------------------------------------------------------ */
+
+static void set_tag(HashMap* map, size_t i, uint8_t tag) {
+    map->tags[i] = tag;
+    // groups starting near the end read past it into the mirror
+    if (i < HASHMAP_GROUP) map->tags[map->capacity + i] = tag;
+}
+
+// How far slot i is from where its hash wanted it
+static size_t distance(const HashMap* map, size_t i) {
+    return (i - (map->slots[i].hash & (map->capacity - 1))) &
+           (map->capacity - 1);
+}
+
+// Robin-hood insertion of an entry known to be absent: whoever is closer
+// to its home slot gives way
+static void place(HashMap* map, HashMapSlot entry) {
+    size_t mask = map->capacity - 1;
+    size_t i = entry.hash & mask;
+    size_t dist = 0;
+
+    while (map->tags[i]) {
+        size_t theirs = distance(map, i);
+        if (theirs < dist) {
+            HashMapSlot evicted = map->slots[i];
+            map->slots[i] = entry;
+            set_tag(map, i, tag_of(entry.hash));
+            entry = evicted;
+            dist = theirs;
+        }
+        i = (i + 1) & mask;
+        dist++;
+    }
+    map->slots[i] = entry;
+    set_tag(map, i, tag_of(entry.hash));
+}
+
+static bool resize(HashMap* map, size_t capacity) {
+    HashMapSlot* slots = malloc(sizeof(HashMapSlot) * capacity);
+    uint8_t* tags = calloc(capacity + HASHMAP_GROUP, 1);
+    if (!slots || !tags) {
+        free(slots);
+        free(tags);
+        return false;
+    }
+
+    HashMap old = *map;
+    map->slots = slots;
+    map->tags = tags;
+    map->capacity = capacity;
+
+    // stored hashes: no key is hashed again
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.tags[i]) place(map, old.slots[i]);
+    }
+    free(old.slots);
+    free(old.tags);
+    return true;
+}
+
+static bool key_matches(const HashMapSlot* slot, uint64_t hash,
+                        const char* key) {
+    return slot->hash == hash && strcmp(slot->key, key) == 0;
+}
+
+// Slot index of key, or SIZE_MAX
+static size_t find(const HashMap* map, const char* key, uint64_t hash) {
+    if (map->count == 0) return SIZE_MAX;
+    size_t mask = map->capacity - 1;
+    size_t i = hash & mask;
+
+#if defined(HASHMAP_SSE2)
+    // most hits sit in their home slot; skip the group setup for them
+    if (map->tags[i] == tag_of(hash) && key_matches(&map->slots[i], hash, key))
+        return i;
+
+    const __m128i tag = _mm_set1_epi8((char)tag_of(hash));
+    const __m128i empty = _mm_setzero_si128();
+    while (1) {
+        __m128i group = _mm_loadu_si128((const __m128i*)(map->tags + i));
+        unsigned match =
+            (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, tag));
+        unsigned holes =
+            (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, empty));
+
+        // a run ends at the first empty slot; nothing past it can match
+        if (holes) match &= (holes & -holes) - 1;
+        while (match) {
+            size_t idx = (i + __builtin_ctz(match)) & mask;
+            if (key_matches(&map->slots[idx], hash, key)) return idx;
+            match &= match - 1;
+        }
+        if (holes) return SIZE_MAX;
+        i = (i + HASHMAP_GROUP) & mask;
+    }
+#else
+    for (size_t dist = 0; map->tags[i]; dist++) {
+        // robin-hood invariant: the key would have displaced this slot
+        if (distance(map, i) < dist) return SIZE_MAX;
+        if (key_matches(&map->slots[i], hash, key)) return i;
+        i = (i + 1) & mask;
+    }
+    return SIZE_MAX;
+#endif
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+void hashmap_init(HashMap* map) { *map = (HashMap){0}; }
+
+void hashmap_free(HashMap* map) {
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->tags[i]) free(map->slots[i].key);
+    }
+    free(map->slots);
+    free(map->tags);
+    *map = (HashMap){0};
+}
+
+bool hashmap_reserve(HashMap* map, size_t n) {
+    size_t capacity = map->capacity ? map->capacity : HASHMAP_MIN_CAPACITY;
+    while (n * LOAD_FACTOR_DEN > capacity * LOAD_FACTOR_NUM) capacity *= 2;
+    return capacity == map->capacity || resize(map, capacity);
+}
+
+bool hashmap_get(const HashMap* map, const char* key, void** value) {
+    size_t i = find(map, key, hash_key(key));
+    if (i == SIZE_MAX) return false;
+    if (value) *value = map->slots[i].value;
+    return true;
+}
+
+bool hashmap_put(HashMap* map, const char* key, void* value, bool* added) {
+    uint64_t hash = hash_key(key);
+    if (added) *added = false;
+
+    size_t i = find(map, key, hash);
+    if (i != SIZE_MAX) {
+        map->slots[i].value = value;
+        return true;
+    }
+
+    if ((map->count + 1) * LOAD_FACTOR_DEN >
+        map->capacity * LOAD_FACTOR_NUM) {
+        size_t capacity =
+            map->capacity ? map->capacity * 2 : HASHMAP_MIN_CAPACITY;
+        if (!resize(map, capacity)) return false;
+    }
+
+    char* copy = strdup(key);
+    if (!copy) return false;
+    place(map, (HashMapSlot){hash, copy, value});
+    map->count++;
+    if (added) *added = true;
+    return true;
+}
+
+bool hashmap_remove(HashMap* map, const char* key, void** value) {
+    size_t i = find(map, key, hash_key(key));
+    if (i == SIZE_MAX) return false;
+
+    if (value) *value = map->slots[i].value;
+    free(map->slots[i].key);
+
+    // backward shift: pull the rest of the run one slot closer to home
+    size_t mask = map->capacity - 1;
+    size_t next = (i + 1) & mask;
+    while (map->tags[next] && distance(map, next) > 0) {
+        map->slots[i] = map->slots[next];
+        set_tag(map, i, map->tags[next]);
+        i = next;
+        next = (next + 1) & mask;
+    }
+    set_tag(map, i, 0);
+    map->count--;
+    return true;
+}
+
+bool hashmap_next(const HashMap* map, size_t* iter, const char** key,
+                  void** value) {
+    while (*iter < map->capacity) {
+        size_t i = (*iter)++;
+        if (!map->tags[i]) continue;
+        if (key) *key = map->slots[i].key;
+        if (value) *value = map->slots[i].value;
+        return true;
+    }
+    return false;
+}
+
+HashStats hashmap_stats(const HashMap* map) {
+    HashStats stats = {map->count, map->capacity, 0, 0.0};
+    if (map->count == 0) return stats;
+
+    size_t total = 0;
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (!map->tags[i]) continue;
+        size_t probes = distance(map, i) + 1;
+        total += probes;
+        if (probes > stats.max_probe) stats.max_probe = probes;
+    }
+    stats.mean_probe = (double)total / map->count;
+    return stats;
+}
+
+size_t hashmap_memory(const HashMap* map) {
+    size_t bytes = map->capacity * sizeof(HashMapSlot);
+    if (map->tags) bytes += map->capacity + HASHMAP_GROUP;
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->tags[i]) bytes += strlen(map->slots[i].key) + 1;
+    }
+    return bytes;
+}
@@ -0,0 +1,66 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ds/hashstats.h"
+
+/*
+ * String-keyed hash map (robin-hood open addressing).
+ *
+ * Every slot keeps its key's full 64-bit hash: growing the table never
+ * hashes a key again, and almost all mismatches are rejected without
+ * touching the key string. Removal shifts the following run back by one
+ * slot instead of leaving tombstones, so probe lengths never degrade.
+ * Lookups compare a 16-slot group of one-byte hash tags per instruction
+ * where SSE2 is available.
+ *
+ * The map owns copies of its keys; values are opaque pointers.
+ */
+
+#define HASHMAP_GROUP 16
+
+typedef struct {
+    uint64_t hash;
+    char* key;
+    void* value;
+} HashMapSlot;
+
+typedef struct {
+    HashMapSlot* slots;
+    uint8_t* tags;  // per slot, 0 = empty; HASHMAP_GROUP mirrored at the end
+    size_t capacity;
+    size_t count;
+} HashMap;
+
+void hashmap_init(HashMap* map);
+void hashmap_free(HashMap* map);
+
+/* Grow so that n keys fit without further resizing */
+bool hashmap_reserve(HashMap* map, size_t n);
+
+/* Value of key into *value (optional); false if absent */
+bool hashmap_get(const HashMap* map, const char* key, void** value);
+
+/*
+ * Insert key or replace its value. *added (optional) tells whether the
+ * key was new. Returns false if memory ran out.
+ */
+bool hashmap_put(HashMap* map, const char* key, void* value, bool* added);
+
+/* Remove key, handing its value to *value (optional); false if absent */
+bool hashmap_remove(HashMap* map, const char* key, void** value);
+
+/*
+ * Iteration in table order: start with *iter = 0 and call until it
+ * returns false. The map must not change during an iteration.
+ */
+bool hashmap_next(const HashMap* map, size_t* iter, const char** key,
+                  void** value);
+
+HashStats hashmap_stats(const HashMap* map);
+size_t hashmap_memory(const HashMap* map);
+
+#endif
@@ -4,13 +4,14 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "ds/hashmap.h"
+
+/* Set of strings: a HashMap without values */
 typedef struct {
-    char** keys;
-    size_t capacity;
-    size_t size;
+    HashMap map;
 } HashSet;
 
-/* Initialize with a fixed capacity (will round up internally) */
+/* Initialize, sized to hold initial_capacity keys without growing */
 void hashset_init(HashSet* set, size_t initial_capacity);
 
 /* Free all memory owned by the set */
@@ -22,4 +23,7 @@ void hashset_free(HashSet* set);
  */
 bool hashset_add(HashSet* set, const char* key);
 
+/* Load factor and probe lengths */
+HashStats hashset_stats(const HashSet* set);
+
 #endif
@@ -0,0 +1,18 @@
+#ifndef HASHSTATS_H
+#define HASHSTATS_H
+
+#include <stddef.h>
+
+/* Occupancy of an open-addressed table, for `shellstats` */
+typedef struct {
+    size_t count;
+    size_t capacity;
+    size_t max_probe;   // slots inspected by the worst successful lookup
+    double mean_probe;  // ... and on average
+} HashStats;
+
+static inline double hash_load_factor(const HashStats* s) {
+    return s->capacity ? (double)s->count / s->capacity : 0.0;
+}
+
+#endif
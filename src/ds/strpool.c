@@ -0,0 +1,153 @@
+#include "strpool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STRPOOL_INITIAL_CAPACITY 4096
+#define LOAD_FACTOR_NUM 7
+#define LOAD_FACTOR_DEN 10
+
+/* ------------------------------------------------------------ */
+/* Hash function (FNV-1a)                                       */
+/* ------------------------------------------------------------ */
+
+static uint64_t hash_bytes(const char* s, size_t n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* ------------------------------------------------------------ */
+/* Internal helpers                                             */
+/* ------------------------------------------------------------ */
+
+static bool index_resize(StrPool* pool, size_t new_cap) {
+    uint32_t* slots = calloc(new_cap, sizeof(uint32_t));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < pool->index_capacity; ++i) {
+        uint32_t entry = pool->index[i];
+        if (!entry) continue;
+
+        const char* key = pool->data + entry - 1;
+        size_t idx = hash_bytes(key, strlen(key)) & (new_cap - 1);
+        while (slots[idx]) idx = (idx + 1) & (new_cap - 1);
+        slots[idx] = entry;
+    }
+
+    free(pool->index);
+    pool->index = slots;
+    pool->index_capacity = new_cap;
+    return true;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+void strpool_init(StrPool* pool, size_t initial_capacity) {
+    if (initial_capacity == 0) initial_capacity = STRPOOL_INITIAL_CAPACITY;
+    pool->data = malloc(initial_capacity);
+    pool->len = 0;
+    pool->capacity = pool->data ? initial_capacity : 0;
+    pool->index = NULL;
+    pool->index_capacity = 0;
+    pool->index_count = 0;
+}
+
+void strpool_free(StrPool* pool) {
+    free(pool->data);
+    free(pool->index);
+    *pool = (StrPool){0};
+}
+
+uint32_t strpool_add(StrPool* pool, const char* s, size_t n) {
+    if (pool->len + n + 1 > pool->capacity) {
+        size_t new_capacity =
+            pool->capacity ? pool->capacity * 2 : STRPOOL_INITIAL_CAPACITY;
+        while (new_capacity < pool->len + n + 1) new_capacity *= 2;
+        if (new_capacity >= STRPOOL_NONE) return STRPOOL_NONE;
+
+        char* tmp = realloc(pool->data, new_capacity);
+        if (!tmp) return STRPOOL_NONE;
+        pool->data = tmp;
+        pool->capacity = new_capacity;
+    }
+
+    uint32_t off = (uint32_t)pool->len;
+    memcpy(pool->data + off, s, n);
+    pool->data[off + n] = '\0';
+    pool->len += n + 1;
+    return off;
+}
+
+uint32_t strpool_intern(StrPool* pool, const char* s, size_t n, bool* added) {
+    if (added) *added = false;
+
+    if ((pool->index_count + 1) * LOAD_FACTOR_DEN >
+        pool->index_capacity * LOAD_FACTOR_NUM) {
+        size_t new_cap = pool->index_capacity ? pool->index_capacity * 2 : 64;
+        if (!index_resize(pool, new_cap)) return STRPOOL_NONE;
+    }
+
+    size_t mask = pool->index_capacity - 1;
+    size_t idx = hash_bytes(s, n) & mask;
+
+    while (pool->index[idx]) {
+        const char* key = pool->data + pool->index[idx] - 1;
+        if (strncmp(key, s, n) == 0 && key[n] == '\0') {
+            return pool->index[idx] - 1;  // already present
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    uint32_t off = strpool_add(pool, s, n);
+    if (off == STRPOOL_NONE) return STRPOOL_NONE;
+
+    pool->index[idx] = off + 1;
+    pool->index_count++;
+    if (added) *added = true;
+    return off;
+}
+
+void strpool_compact(StrPool* pool) {
+    free(pool->index);
+    pool->index = NULL;
+    pool->index_capacity = 0;
+    pool->index_count = 0;
+
+    if (pool->len > 0 && pool->len < pool->capacity) {
+        char* tmp = realloc(pool->data, pool->len);
+        if (tmp) {
+            pool->data = tmp;
+            pool->capacity = pool->len;
+        }
+    }
+}
+
+size_t strpool_memory(const StrPool* pool) {
+    return pool->capacity + pool->index_capacity * sizeof(uint32_t);
+}
+
+HashStats strpool_index_stats(const StrPool* pool) {
+    HashStats stats = {pool->index_count, pool->index_capacity, 0, 0.0};
+    if (pool->index_count == 0) return stats;
+
+    size_t mask = pool->index_capacity - 1;
+    size_t total = 0;
+    for (size_t i = 0; i < pool->index_capacity; ++i) {
+        uint32_t entry = pool->index[i];
+        if (!entry) continue;
+
+        const char* key = pool->data + entry - 1;
+        size_t home = hash_bytes(key, strlen(key)) & mask;
+        size_t probes = ((i - home) & mask) + 1;
+        total += probes;
+        if (probes > stats.max_probe) stats.max_probe = probes;
+    }
+    stats.mean_probe = (double)total / pool->index_count;
+    return stats;
+}
@@ -0,0 +1,57 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ds/hashstats.h"
+
+/*
+ * Append-only string pool.
+ *
+ * Strings are stored back to back (NUL-terminated) in one growable buffer
+ * and referred to by offset, so they survive reallocation of the buffer.
+ * strpool_intern() additionally keeps a hash index over the pool so equal
+ * strings are stored once.
+ */
+
+#define STRPOOL_NONE UINT32_MAX
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+
+    // interning index: offset + 1 per slot, 0 means empty
+    uint32_t* index;
+    size_t index_capacity;
+    size_t index_count;
+} StrPool;
+
+void strpool_init(StrPool* pool, size_t initial_capacity);
+void strpool_free(StrPool* pool);
+
+/* Append s[0..n) and return its offset, or STRPOOL_NONE on failure */
+uint32_t strpool_add(StrPool* pool, const char* s, size_t n);
+
+/*
+ * Offset of the interned copy of s[0..n), appending it if needed.
+ * *added (optional) tells whether the string was new.
+ */
+uint32_t strpool_intern(StrPool* pool, const char* s, size_t n, bool* added);
+
+/* Release the interning index and any unused buffer space */
+void strpool_compact(StrPool* pool);
+
+/* Bytes held by the pool, including its index */
+size_t strpool_memory(const StrPool* pool);
+
+/* Load and probe lengths of the interning index (zeroes once compacted) */
+HashStats strpool_index_stats(const StrPool* pool);
+
+static inline const char* strpool_get(const StrPool* pool, uint32_t off) {
+    return pool->data + off;
+}
+
+#endif
@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+
+#include "coproc.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "expand/vars.h"
+#include "util/trace.h"
+
+typedef struct {
+    char* name;    // NULL once a newer coprocess took the name
+    pid_t pid;     // 0 once reaped
+    int read_fd;   // -1 when closed
+    int write_fd;  // -1 when closed
+} Coproc;
+
+static Coproc* coprocs;
+static size_t coproc_count;
+static size_t coproc_capacity;
+
+static void close_fd(int* fd) {
+    if (*fd >= 0) close(*fd);
+    *fd = -1;
+}
+
+// NAME=(read_fd write_fd)
+static bool publish_fds(const Coproc* c) {
+    char** items = malloc(sizeof(char*) * 2);
+    char* storage = malloc(2 * 16);
+    if (!items || !storage) {
+        free(items);
+        free(storage);
+        return false;
+    }
+    items[0] = storage;
+    items[1] = storage + 16;
+    snprintf(items[0], 16, "%d", c->read_fd);
+    snprintf(items[1], 16, "%d", c->write_fd);
+    return vars_set_array(c->name, items, 2, storage);
+}
+
+static void pid_var(char* buf, size_t size, const char* name) {
+    snprintf(buf, size, "%s_PID", name);
+}
+
+static Coproc* find(const char* name) {
+    for (size_t i = 0; i < coproc_count; i++) {
+        if (coprocs[i].name && strcmp(coprocs[i].name, name) == 0) {
+            return &coprocs[i];
+        }
+    }
+    return NULL;
+}
+
+static bool add(const char* name, pid_t pid, int read_fd, int write_fd) {
+    Coproc* old = find(name);
+    if (old) {
+        free(old->name);
+        old->name = NULL;
+        close_fd(&old->read_fd);
+        close_fd(&old->write_fd);
+    }
+
+    if (coproc_count == coproc_capacity) {
+        size_t capacity = coproc_capacity ? coproc_capacity * 2 : 4;
+        Coproc* tmp = realloc(coprocs, sizeof(Coproc) * capacity);
+        if (!tmp) return false;
+        coprocs = tmp;
+        coproc_capacity = capacity;
+    }
+    char* copy = strdup(name);
+    if (!copy) return false;
+    Coproc* c = &coprocs[coproc_count++];
+    *c = (Coproc){copy, pid, read_fd, write_fd};
+
+    char var[strlen(name) + 5];
+    pid_var(var, sizeof(var), name);
+    return publish_fds(c) && vars_set_int(var, pid);
+}
+
+// In the subshell: the coprocesses' ends are the shell's, not its own
+static void close_all(void) {
+    for (size_t i = 0; i < coproc_count; i++) {
+        close_fd(&coprocs[i].read_fd);
+        close_fd(&coprocs[i].write_fd);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+bool coproc_start(const char* name, int (*run)(const Pipeline*),
+                  const Pipeline* pl) {
+    int in[2], out[2];  // the coprocess's stdin and stdout
+    if (pipe2(in, O_CLOEXEC) != 0) {
+        perror("coproc: pipe");
+        return false;
+    }
+    if (pipe2(out, O_CLOEXEC) != 0) {
+        perror("coproc: pipe");
+        close(in[0]);
+        close(in[1]);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        trace_child_init();
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        // close-on-exec is not enough: the subshell may never exec
+        close(in[0]);
+        close(in[1]);
+        close(out[0]);
+        close(out[1]);
+        close_all();
+        _exit(run(pl));
+    }
+
+    close(in[0]);
+    close(out[1]);
+    if (pid < 0) {
+        perror("coproc: fork");
+        close(in[1]);
+        close(out[0]);
+        return false;
+    }
+    return add(name, pid, out[0], in[1]);
+}
+
+bool coproc_close_input(const char* name) {
+    Coproc* c = find(name);
+    if (!c) return false;
+    close_fd(&c->write_fd);
+    publish_fds(c);
+    return true;
+}
+
+static bool exited(pid_t pid) {
+    int status;
+    pid_t r;
+    while ((r = waitpid(pid, &status, WNOHANG)) < 0 && errno == EINTR);
+    return r != 0;
+}
+
+void coproc_reap(void) {
+    size_t kept = 0;
+    for (size_t i = 0; i < coproc_count; i++) {
+        Coproc* c = &coprocs[i];
+        if (c->pid > 0 && exited(c->pid)) {
+            c->pid = 0;
+            // nothing reads the write end any more, but output left in
+            // the pipe stays readable through NAME[0]
+            if (c->name) {
+                close_fd(&c->write_fd);
+                publish_fds(c);
+                char var[strlen(c->name) + 5];
+                pid_var(var, sizeof(var), c->name);
+                vars_unset(var);
+            }
+        }
+        if (c->pid == 0 && !c->name) continue;  // nothing left to track
+        coprocs[kept++] = *c;
+    }
+    coproc_count = kept;
+}
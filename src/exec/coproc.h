@@ -0,0 +1,39 @@
+#ifndef COPROC_H
+#define COPROC_H
+
+#include <stdbool.h>
+
+#include "shell.h"
+
+/*
+ * Coprocesses started with `coproc NAME pipeline`: the pipeline runs in
+ * the background with its stdin and stdout on pipes, which the shell
+ * keeps open and publishes as ${NAME[1]} (write to it) and ${NAME[0]}
+ * (read from it), with the process in NAME_PID:
+ *
+ *   coproc CALC awk -W interactive '{ print $1 * $2 }'
+ *   echo 6 7 >&${CALC[1]}; read -r product <&${CALC[0]}
+ *
+ * The shell's ends are close-on-exec, so commands run later do not hold
+ * them open. A coprocess that exits is reaped by coproc_reap() before the
+ * next pipeline runs: its write end is closed (${NAME[1]} becomes -1) and
+ * NAME_PID unset, while its read end stays open so that output it left
+ * behind can still be read.
+ */
+
+/*
+ * Forks a subshell with its stdin and stdout on new pipes, in which
+ * run(pl) runs, and sets NAME and NAME_PID in the shell. Returns without
+ * waiting. A previous coprocess of that name loses its fds; it is still
+ * reaped once it exits.
+ */
+bool coproc_start(const char* name, int (*run)(const Pipeline*),
+                  const Pipeline* pl);
+
+/* `coproc -c NAME`: close the write end, so the coprocess sees EOF */
+bool coproc_close_input(const char* name);
+
+/* Reaps coprocesses that have exited, without waiting for the others */
+void coproc_reap(void);
+
+#endif
@@ -1,8 +1,44 @@
 #ifndef EXEC_H
 #define EXEC_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "shell.h"
 
 int execute_pipeline(const Pipeline* pl);
 
+/*
+ * Runs the items of list in order; stops early when `return` is used.
+ * final says nothing runs after the list (end of `-c` or of a script):
+ * its last external command, or the last stage of its last pipeline, is
+ * then exec'd in the shell process instead of forked and waited for.
+ */
+int execute_list(const CommandList* list, bool final);
+
+/*
+ * Runs one expanded command in a forked child with its stdout and stderr
+ * on out_fd and err_fd (functions and builtins included), and waits for
+ * it. Returns its exit status.
+ */
+int execute_captured(const Command* command, int out_fd, int err_fd);
+
+/*
+ * Cumulative process counters since startup, for `shellstats`. exec is
+ * counted but not timed: the parent only learns when an exec finished by
+ * blocking on each child (a close-on-exec pipe), which would serialize
+ * starting a pipeline. `set -o trace` records each child's setup up to
+ * execvp instead.
+ */
+typedef struct {
+    unsigned long builtins;  // builtins run in the shell itself
+    unsigned long forks;
+    unsigned long execs;     // forked stages that went on to execvp
+    unsigned long waits;     // wait_stages() calls
+    int64_t fork_ns, fork_max_ns;  // time spent in fork()
+    int64_t wait_ns, wait_max_ns;  // time blocked waiting for children
+} ExecStats;
+
+const ExecStats* exec_stats(void);
+
 #endif
\ No newline at end of file
@@ -1,57 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include "builtin/builtin.h"
+#include "coproc.h"
 #include "exec.h"
+#include "expand/expand.h"
+#include "expand/vars.h"
+#include "function.h"
+#include "optimize.h"
+#include "pipemon.h"
 #include "redirection.h"
+#include "stageopts.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
+#include "wait.h"
+
+static ExecStats stats;
+
+// Sentinel meaning: "do not override, inherit from parent"
+enum { FD_INHERIT = -1 };
+
+// Set while the list item being run is the shell's last action
+static bool tail_position;
+
+const ExecStats* exec_stats(void) { return &stats; }
+
+static void count_fork(const Command* cmd, int64_t start, int64_t end) {
+    stats.forks++;
+    if (cmd->argc > 0 && !find_builtin(cmd->argv[0]) &&
+        !function_find(cmd->argv[0])) {
+        stats.execs++;
+    }
+    stats.fork_ns += end - start;
+    if (end - start > stats.fork_max_ns) stats.fork_max_ns = end - start;
+}
 
+static void count_wait(int64_t start, int64_t end) {
+    stats.waits++;
+    stats.wait_ns += end - start;
+    if (end - start > stats.wait_max_ns) stats.wait_max_ns = end - start;
+}
+
+// Builtins run in the shell process: their redirections are resolved to
+// fds handed over through BuiltinIO, so the shell's own 0/1/2 stay intact.
 int exec_builtin(builtin_func bf, const Command* command) {
-    int saved_fds[3];
-    if (apply_redirections(command, saved_fds) != 0) {
-        perror("apply_redirections");
-        return -1;
-    } else {
-        int result = bf(command);
-        restore_fds(saved_fds);
-        return result;
+    BuiltinIO io;
+    if (builtin_io_open(&io, command) != 0) return 1;
+    stats.builtins++;
+
+    int64_t start = trace_enabled() ? monotonic_ns() : 0;
+    int result = bf(command, &io);
+    builtin_io_close(&io);
+    if (start && trace_enabled()) {  // not for the `set` that turned it on
+        trace_span("builtin", command->argv[0], start, monotonic_ns(), 0);
     }
+    return result;
 }
 
-int exec_external(const Command* command) {
+// Run a command in an already forked child. Never returns.
+static void exec_in_child(const Command* command) {
+    int64_t start = trace_enabled() ? monotonic_ns() : 0;
+    if (command->argc == 0) _exit(0);  // "$@" with no parameters
+
+    CommandList* body = function_find(command->argv[0]);
+    if (body) {
+        int result = function_call(body, command);
+        trace_flush();
+        _exit(result);
+    }
+
+    builtin_func bf = find_builtin(command->argv[0]);
+    if (bf) {
+        int result = exec_builtin(bf, command);
+        trace_flush();
+        _exit(result);
+    }
+
+    // in the child process, no need to save and restore fds
+    if (apply_redirections(command, NULL) != 0) {
+        _exit(1);
+    }
+    if (trace_enabled()) {
+        // setup until exec; the events must leave before the image does
+        trace_span("exec", command->argv[0], start, monotonic_ns(), 0);
+        trace_flush();
+    }
+    execvp(command->argv[0], command->argv);
+    // only gets past this point if it fails.
+    fprintf(stderr, "%s: command not found\n", command->argv[0]);
+    _exit(127);
+}
+
+/* ------------------------------------------------------------ */
+/* Tail exec                                                    */
+/* ------------------------------------------------------------ */
+
+// Whether a final external command may replace the shell. Not when the
+// shell still has work after the command ends: recording telemetry or a
+// trace, or reporting pipemon.
+static bool can_tail_exec(const Command* command) {
+    return tail_position && command->argc > 0 && !telemetry_enabled() &&
+           !trace_enabled() && !shell_options.pipemon &&
+           !function_find(command->argv[0]) && !find_builtin(command->argv[0]);
+}
+
+// execve in the shell process itself: the process that would have waited
+// for the command and exited with its status is simply not created.
+// Exit handlers (history saving) do not run. Never returns.
+static void tail_exec(const Command* command) {
+    fflush(NULL);
+    if (apply_redirections(command, NULL) != 0) _exit(1);
+    execvp(command->argv[0], command->argv);
+    fprintf(stderr, "%s: command not found\n", command->argv[0]);
+    _exit(127);
+}
+
+// Forks command with stdout/stderr on out_fd/err_fd (FD_INHERIT: the
+// shell's own) and waits for it
+static int fork_and_wait(const Command* command, int out_fd, int err_fd) {
+    int64_t fork_start = monotonic_ns();
     pid_t pid = fork();
     if (pid < 0) {
         perror("fork");
         return -1;
     }
-    // in the child process(0), no need to save and restore fds
     if (pid == 0) {
-        if (apply_redirections(command, NULL) != 0) {
-            _exit(1);
-        }
-        execvp(command->argv[0], command->argv);
-        // only gets past this point if it fails.
-        fprintf(stderr, "%s: command not found\n", command->argv[0]);
-        _exit(127);
+        trace_child_init();
+        if (out_fd != FD_INHERIT) dup2(out_fd, STDOUT_FILENO);
+        if (err_fd != FD_INHERIT) dup2(err_fd, STDERR_FILENO);
+        exec_in_child(command);
     }
     // parent
+    int64_t forked = monotonic_ns();
+    count_fork(command, fork_start, forked);
     int child_status;
-    pid_t child = waitpid(pid, &child_status, 0);
-    if (WIFEXITED(child_status)) {
-        int code = WEXITSTATUS(child_status);
-        return code;  // return child's exit code to caller
-    } else if (WIFSIGNALED(child_status)) {
-        int sig = WTERMSIG(child_status);
-        fprintf(stderr, "Child killed by signal %d\n", sig);
-        return 128 + sig;  // common shell convention
+    int64_t reaped = 0;
+    WaitOptions opts = {.reaped_ns = &reaped};
+    wait_stages(&pid, 1, &child_status, &opts, NULL);
+    count_wait(forked, reaped);
+    if (trace_enabled()) {
+        trace_span("fork", command->argv[0], fork_start, forked, 0);
+        trace_span("wait", command->argv[0], forked, reaped, 0);
+        trace_span("process", command->argv[0], forked, reaped, pid);
     }
+    if (WIFSIGNALED(child_status)) {
+        fprintf(stderr, "Child killed by signal %d\n", WTERMSIG(child_status));
+    }
+    // child's exit code, or 128 + signal (common shell convention)
+    return wait_status_code(child_status);
+}
 
-    return -1;  // unknown termination
+int exec_external(const Command* command) {
+    if (can_tail_exec(command)) tail_exec(command);
+    return fork_and_wait(command, FD_INHERIT, FD_INHERIT);
+}
+
+int execute_captured(const Command* command, int out_fd, int err_fd) {
+    if (command->argc == 0) return 0;
+    return fork_and_wait(command, out_fd, err_fd);
+}
+
+// `name=value` word, the only thing that can make up an assignment command
+static bool is_assignment(const char* word) {
+    const char* eq = strchr(word, '=');
+    return eq && vars_valid_name(word, eq - word);
+}
+
+// A command made of nothing but `name=value` words sets shell variables
+static bool run_assignments(const Command* cmd) {
+    for (int i = 0; i < cmd->argc; i++) {
+        if (!is_assignment(cmd->argv[i])) return false;
+    }
+    for (int i = 0; i < cmd->argc; i++) {
+        const char* word = cmd->argv[i];
+        const char* eq = strchr(word, '=');
+        char name[eq - word + 1];
+        memcpy(name, word, eq - word);
+        name[eq - word] = '\0';
+        vars_set(name, eq + 1);
+    }
+    return true;
 }
 
 int execute_command(const Command* cmd) {
+    if (cmd->argc == 0) return 0;
+    if (is_assignment(cmd->argv[0]) && run_assignments(cmd)) return 0;
+
+    // functions come first, so they can wrap builtins and programs
+    CommandList* body = function_find(cmd->argv[0]);
+    if (body) return function_call(body, cmd);
+
     builtin_func bf = find_builtin(cmd->argv[0]);
     if (bf) {
         return exec_builtin(bf, cmd);
@@ -60,26 +208,92 @@ int execute_command(const Command* cmd) {
     }
 }
 
-// Sentinel meaning: "do not override, inherit from parent"
-enum { FD_INHERIT = -1 };
-
 // Conventional indices for pipe()
 enum { PIPE_READ = 0, PIPE_WRITE = 1 };
 
-int execute_pipeline(const Pipeline* pl) {
-    // Holds the read end of the previous pipe.
-    // FD_INHERIT means: use normal stdin.
-    if (pl->count == 1) {
-        return execute_command(&pl->cmds[0]);
+// Exit status of a pipeline killed by `timeout` (as coreutils timeout)
+enum { TIMEOUT_STATUS = 124 };
+
+/* ------------------------------------------------------------ */
+/* timeout DURATION pipeline                                    */
+/* ------------------------------------------------------------ */
+
+// DURATION is a number with an optional s/m/h/d suffix
+static bool parse_duration(const char* s, int64_t* ns) {
+    char* end;
+    double v = strtod(s, &end);
+    if (end == s || v <= 0) return false;
+
+    double scale = 1;
+    switch (*end) {
+        case '\0':
+        case 's': break;
+        case 'm': scale = 60; break;
+        case 'h': scale = 3600; break;
+        case 'd': scale = 86400; break;
+        default: return false;
     }
+    if (*end != '\0' && end[1] != '\0') return false;
 
+    *ns = (int64_t)(v * scale * 1e9);
+    return true;
+}
+
+// Recognizes `timeout DURATION cmd...` on the first stage. Anything else
+// named timeout is left alone and runs as an ordinary command.
+static bool timeout_prefix(const Command* first, int64_t* ns) {
+    return first->argc >= 3 && strcmp(first->argv[0], "timeout") == 0 &&
+           parse_duration(first->argv[1], ns);
+}
+
+// A timed pipeline runs in its own process group so the whole group can be
+// signalled. If the shell owns the terminal, the group gets it meanwhile.
+static bool shell_owns_terminal(void) {
+    return isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+}
+
+static void give_terminal(pid_t pgid) {
+    void (*old)(int) = signal(SIGTTOU, SIG_IGN);
+    tcsetpgrp(STDIN_FILENO, pgid);
+    signal(SIGTTOU, old);
+}
+
+/* ------------------------------------------------------------ */
+/* Pipelines                                                    */
+/* ------------------------------------------------------------ */
+
+// statuses receives the exit code of every stage.
+// timeout_ns > 0 forks even a single builtin and enforces the deadline.
+// placement (NULL if none) is applied in each stage's process; it also
+// forces a fork.
+static int run_pipeline(const Pipeline* pl, const StageOptions* placement,
+                        int* statuses, int64_t timeout_ns, WaitResult* wres) {
+    if (pl->count == 1 && timeout_ns == 0 && !placement) {
+        int result = execute_command(&pl->cmds[0]);
+        statuses[0] = result;
+        *wres = (WaitResult){.first_failed = result != 0 ? 0 : -1};
+        return result;
+    }
+
+    bool own_group = timeout_ns > 0;
+    bool with_terminal = own_group && shell_owns_terminal();
+    pid_t pgid = 0;
+    int64_t start = monotonic_ns();
+
+    // Holds the read end of the previous pipe.
+    // FD_INHERIT means: use normal stdin.
     int prev_read = FD_INHERIT;
 
+    // relays between the stages with `set -o pipemon`
+    PipeMonitor* mon = shell_options.pipemon ? pipemon_create(pl) : NULL;
+
     // Store all child PIDs so we can wait for them later
     pid_t pids[pl->count];
+    int64_t forked_ns[pl->count];
+    size_t spawned = 0;
 
     // Iterate once per command in the pipeline
-    for (int i = 0; i < pl->count; i++) {
+    for (size_t i = 0; i < pl->count; i++) {
         // pipefd[0] = read end, pipefd[1] = write end
         // Initialized to FD_INHERIT to mean "no pipe"
         int pipefd[2] = {FD_INHERIT, FD_INHERIT};
@@ -87,10 +301,32 @@ int execute_pipeline(const Pipeline* pl) {
         // Create a pipe only if this is NOT the last command
         // Last command writes to stdout, not to a pipe
         if (i < pl->count - 1) {
-            pipe(pipefd);
+            bool relayed = mon && pipemon_edge(mon, i, &pipefd[PIPE_WRITE],
+                                               &pipefd[PIPE_READ]);
+            if (!relayed && pipe(pipefd) != 0) {
+                // like a failed fork: this stage and the rest never start
+                perror("pipe");
+                break;
+            }
+        }
+
+        // the last stage of a final pipeline takes over the shell; without
+        // pipefail its status is the pipeline's, so no one needs the others'
+        if (i == pl->count - 1 && !own_group && !shell_options.pipefail &&
+            can_tail_exec(&pl->cmds[i])) {
+            // a single placed stage has no pipe to read from
+            if (prev_read != FD_INHERIT) {
+                dup2(prev_read, STDIN_FILENO);
+                close(prev_read);
+            }
+            if (placement && !stage_options_apply(&placement[i])) {
+                _exit(1);
+            }
+            tail_exec(&pl->cmds[i]);
         }
 
         // Fork a new process for this command
+        int64_t fork_start = monotonic_ns();
         pid_t pid = fork();
 
         if (pid == 0) {
@@ -98,11 +334,20 @@ int execute_pipeline(const Pipeline* pl) {
             // CHILD PROCESS
             // ======================
 
+            trace_child_init();
+            if (mon) pipemon_child(mon);
+
+            if (own_group) {
+                setpgid(0, pgid);
+                if (with_terminal) give_terminal(pgid ? pgid : getpid());
+            }
+
             // If there is a previous pipe, connect it to stdin
             // This makes:
             //   previous_command | current_command
             if (prev_read != FD_INHERIT) {
                 dup2(prev_read, STDIN_FILENO);
+                close(prev_read);
             }
 
             // If there is a next pipe, connect stdout to it
@@ -110,25 +355,37 @@ int execute_pipeline(const Pipeline* pl) {
             //   current_command | next_command
             if (pipefd[PIPE_WRITE] != FD_INHERIT) {
                 dup2(pipefd[PIPE_WRITE], STDOUT_FILENO);
+                close(pipefd[PIPE_WRITE]);
+                close(pipefd[PIPE_READ]);
             }
 
-            // Apply redirections (<, >, >>, etc.)
-            // These OVERRIDE any pipe wiring if present
-            apply_redirections(&pl->cmds[i], NULL);
+            if (placement && !stage_options_apply(&placement[i])) _exit(1);
 
-            // Execute the command (builtin or external)
-            execute_command(&pl->cmds[i]);
-
-            // If exec fails, exit immediately
-            _exit(1);
+            // Execute the command (builtin or external); its redirections
+            // OVERRIDE any pipe wiring if present
+            exec_in_child(&pl->cmds[i]);
         }
 
         // ======================
         // PARENT PROCESS
         // ======================
 
-        // Save PID for later waiting
-        pids[i] = pid;
+        if (pid < 0) {
+            perror("fork");
+        } else {
+            // Save PID for later waiting
+            forked_ns[spawned] = monotonic_ns();
+            count_fork(&pl->cmds[i], fork_start, forked_ns[spawned]);
+            if (trace_enabled()) {
+                trace_span("fork", pl->cmds[i].argv[0], fork_start,
+                           forked_ns[spawned], 0);
+            }
+            pids[spawned++] = pid;
+            if (own_group) {
+                if (pgid == 0) pgid = pid;
+                setpgid(pid, pgid);  // also here, whoever runs first wins
+            }
+        }
 
         // Parent must close fds it does not use
         // Otherwise pipes never reach EOF and hang
@@ -146,23 +403,252 @@ int execute_pipeline(const Pipeline* pl) {
         // Carry forward the read end for the next command
         // This becomes stdin for the next child
         prev_read = pipefd[PIPE_READ];
+
+        if (pid < 0) break;
     }
+    if (prev_read != FD_INHERIT) close(prev_read);
+    if (mon) pipemon_start(mon);
 
     // ======================
     // WAIT FOR ALL CHILDREN
     // ======================
 
-    int status, last = 0;
+    // Stages are reaped as they finish, not in pipeline order
+    int64_t reaped_ns[pl->count];
+    WaitOptions opts = {own_group ? start + timeout_ns : 0, pgid, reaped_ns,
+                        shell_options.pipefail};
+    int raw[pl->count];
+    int64_t wait_start = monotonic_ns();
+    wait_stages(pids, spawned, raw, &opts, wres);
+    int64_t wait_end = monotonic_ns();
+    count_wait(wait_start, wait_end);
+    pipemon_finish(mon);
 
-    // Wait for every command in the pipeline
-    for (int i = 0; i < pl->count; i++) {
-        waitpid(pids[i], &status, 0);
+    if (trace_enabled()) {
+        // each stage on its own track, from fork to reap
+        for (size_t i = 0; i < spawned; i++) {
+            trace_span("process", pl->cmds[i].argv[0], forked_ns[i],
+                       reaped_ns[i], pids[i]);
+        }
+        trace_span("wait", NULL, wait_start, wait_end, 0);
+    }
 
-        // Shell convention:
-        // pipeline exit status = exit status of last command
-        if (i == pl->count - 1) last = WEXITSTATUS(status);
+    if (with_terminal) give_terminal(getpgrp());
+
+    for (size_t i = 0; i < pl->count; i++) {
+        // a stage that could not be forked counts as failed
+        statuses[i] = i < spawned ? wait_status_code(raw[i]) : 1;
+    }
+    if (spawned < pl->count && wres->first_failed < 0) {
+        wres->first_failed = (int)spawned;
     }
 
-    // Return status of final pipeline command
-    return last;
-}
\ No newline at end of file
+    if (wres->timed_out) return TIMEOUT_STATUS;
+
+    // pipefail stopped the stages still running when one failed: the ones
+    // it signalled only failed because of that, so the first failure decides
+    // (PIPESTATUS shows them as 143)
+    if (wres->cut_short) return statuses[wres->first_failed];
+
+    // pipefail: the rightmost failing stage decides
+    if (shell_options.pipefail) {
+        for (size_t i = pl->count; i-- > 0;) {
+            if (statuses[i] != 0) return statuses[i];
+        }
+        return 0;
+    }
+
+    // Shell convention:
+    // pipeline exit status = exit status of last command
+    return statuses[pl->count - 1];
+}
+
+/* ------------------------------------------------------------ */
+/* coproc NAME pipeline                                         */
+/* ------------------------------------------------------------ */
+
+static int execute_expanded(const Pipeline* pl);
+
+// In the coprocess: nothing follows, so the last stage can be exec'd
+static int run_coproc(const Pipeline* pl) {
+    tail_position = true;
+    return execute_expanded(pl);
+}
+
+// `coproc NAME pipeline` starts the rest of the first stage and the stages
+// after it in the background; `coproc -c NAME` closes its input
+static int start_coproc(Pipeline* view) {
+    Command* first = &view->cmds[0];
+    if (first->argc == 3 && strcmp(first->argv[1], "-c") == 0) {
+        if (coproc_close_input(first->argv[2])) return 0;
+        fprintf(stderr, "coproc: %s: no such coprocess\n", first->argv[2]);
+        return 1;
+    }
+    if (first->argc < 3 ||
+        !vars_valid_name(first->argv[1], strlen(first->argv[1]))) {
+        fprintf(stderr,
+                "coproc: usage: coproc NAME pipeline | coproc -c NAME\n");
+        return 2;
+    }
+
+    const char* name = first->argv[1];
+    first->argv += 2;
+    first->argc -= 2;
+    int64_t fork_start = monotonic_ns();
+    if (!coproc_start(name, run_coproc, view)) return 1;
+    count_fork(first, fork_start, monotonic_ns());
+    return 0;
+}
+
+// PIPESTATUS: the status of each stage as written. The optimizer's stages
+// keep the argv of the one they came from; a cat it removed reads as 0.
+// Most lines repeat the last statuses (a run of 0s), so the array is only
+// rebuilt when they change or something else has assigned it.
+#define PIPESTATUS_CACHED 16  // longer pipelines always rebuild it
+
+static struct {
+    int statuses[PIPESTATUS_CACHED];
+    size_t count;
+    const char* storage;  // the block last handed to vars_set_array
+} pipestatus;
+
+static void set_pipestatus(const Pipeline* written, const Pipeline* ran,
+                           const int* statuses) {
+    size_t n = written->count;
+    int stage_status[n];
+    for (size_t i = 0, k = 0; i < n; i++) {
+        stage_status[i] = 0;
+        if (k < ran->count && ran->cmds[k].argv == written->cmds[i].argv) {
+            stage_status[i] = statuses[k++];
+        }
+    }
+    if (n == pipestatus.count &&
+        memcmp(stage_status, pipestatus.statuses, sizeof(stage_status)) == 0 &&
+        vars_array_get("PIPESTATUS", 0) == pipestatus.storage) {
+        return;
+    }
+
+    char** items = malloc(sizeof(char*) * n);
+    char* storage = malloc(n * 12);  // "-2147483648" and its NUL
+    if (!items || !storage) {
+        free(items);
+        free(storage);
+        return;
+    }
+    char* p = storage;
+    for (size_t i = 0; i < n; i++) {
+        items[i] = p;
+        p += sprintf(p, "%d", stage_status[i]) + 1;
+    }
+    pipestatus.storage = NULL;
+    if (!vars_set_array("PIPESTATUS", items, n, storage) ||
+        n > PIPESTATUS_CACHED) {
+        return;
+    }
+    memcpy(pipestatus.statuses, stage_status, sizeof(stage_status));
+    pipestatus.count = n;
+    pipestatus.storage = storage;
+}
+
+static int execute_expanded(const Pipeline* pl) {
+    Command cmds[pl->count];
+    memcpy(cmds, pl->cmds, sizeof(cmds));
+    Pipeline view = {cmds, pl->count};
+
+    if (cmds[0].argc > 0 && strcmp(cmds[0].argv[0], "coproc") == 0) {
+        return start_coproc(&view);
+    }
+
+    // `@cpus=... @nice=...` in front of a stage; stripped from the view
+    StageOptions stage_opts[pl->count];
+    memset(stage_opts, 0, sizeof(stage_opts));
+    bool placed = false;
+    for (size_t i = 0; i < pl->count; i++) {
+        if (!stage_options_parse(&cmds[i], &stage_opts[i])) return 2;
+        placed |= stage_options_any(&stage_opts[i]);
+    }
+
+    // `timeout DURATION ...` on the first stage covers the whole pipeline;
+    // run a view of the pipeline with the prefix stripped
+    int64_t timeout_ns = 0;
+    if (timeout_prefix(&cmds[0], &timeout_ns)) {
+        cmds[0].argv += 2;
+        cmds[0].argc -= 2;
+        // `timeout 5 @nice=5 cmd` as well as `@nice=5 timeout 5 cmd`
+        if (!stage_options_parse(&cmds[0], &stage_opts[0])) return 2;
+        placed |= stage_options_any(&stage_opts[0]);
+    }
+    const StageOptions* placement = placed ? stage_opts : NULL;
+
+    // pipemon reports on the edges as written, and placed stages stay as
+    // they were asked for, so leave them all in place
+    Command optimized[pl->count];
+    Pipeline rewritten;
+    Pipeline written = view;
+    if (shell_options.optimize && !shell_options.pipemon && !placed &&
+        optimize_pipeline(&view, optimized, &rewritten)) {
+        if (shell_options.explain) optimize_explain(stderr, &view, &rewritten);
+        view = rewritten;
+    }
+
+    int statuses[pl->count];
+    WaitResult wres;
+
+    if (!telemetry_enabled() && !trace_enabled()) {
+        int result =
+            run_pipeline(&view, placement, statuses, timeout_ns, &wres);
+        set_pipestatus(&written, &view, statuses);
+        return result;
+    }
+
+    TelemetrySpan span;
+    if (telemetry_enabled()) telemetry_begin(&span, &view);
+    int64_t start = monotonic_ns();
+
+    int result = run_pipeline(&view, placement, statuses, timeout_ns, &wres);
+
+    if (trace_enabled()) {
+        trace_span("pipeline", view.cmds[0].argv[0], start, monotonic_ns(), 0);
+    }
+    if (telemetry_enabled()) {
+        telemetry_end(&span, &view, statuses, wres.first_failed);
+    }
+    set_pipestatus(&written, &view, statuses);
+    return result;
+}
+
+int execute_pipeline(const Pipeline* pl) {
+    if (pl->count == 0) return 0;
+    coproc_reap();
+
+    // expansions happen here, once, so forked stages get finished words
+    // and side effects such as $((i++)) stay in the shell
+    Command cmds[pl->count];
+    if (!expand_pipeline(pl, cmds)) {
+        shell_last_status = 1;
+        return 1;
+    }
+
+    Pipeline expanded = {cmds, pl->count};
+    int result = execute_expanded(&expanded);
+    expand_free(pl, cmds);
+
+    shell_last_status = result;
+    return result;
+}
+
+int execute_list(const CommandList* list, bool final) {
+    int status = 0;
+    for (size_t i = 0; i < list->count && !function_returning(); i++) {
+        const ListItem* item = &list->items[i];
+        tail_position = final && i == list->count - 1;
+        if (item->function) {
+            status = function_define(item->function, item->body) ? 0 : 1;
+            shell_last_status = status;
+        } else {
+            status = execute_pipeline(&item->pipeline);
+        }
+    }
+    tail_position = false;
+    return status;
+}
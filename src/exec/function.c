@@ -0,0 +1,78 @@
+#include "function.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ds/hashmap.h"
+#include "exec/exec.h"
+#include "exec/redirection.h"
+#include "expand/vars.h"
+#include "parse/parser.h"
+
+// name -> CommandList*
+static HashMap functions;
+
+static size_t depth;
+static bool returning;
+static int return_status;
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+bool function_define(const char* name, CommandList* body) {
+    void* old = NULL;
+    hashmap_get(&functions, name, &old);
+    if (!hashmap_put(&functions, name, command_list_retain(body), NULL)) {
+        command_list_release(body);
+        return false;
+    }
+    command_list_release(old);
+    return true;
+}
+
+CommandList* function_find(const char* name) {
+    void* body;
+    return hashmap_get(&functions, name, &body) ? body : NULL;
+}
+
+int function_call(CommandList* body, const Command* cmd) {
+    if (depth >= FUNCTION_MAX_DEPTH) {
+        fprintf(stderr, "%s: maximum function nesting level exceeded (%d)\n",
+                cmd->argv[0], FUNCTION_MAX_DEPTH);
+        return 1;
+    }
+
+    int saved_fds[3];
+    if (cmd->redirc > 0 && apply_redirections(cmd, saved_fds) != 0) {
+        return 1;
+    }
+    if (!vars_push_scope(cmd->argc - 1, cmd->argv + 1)) {
+        if (cmd->redirc > 0) restore_fds(saved_fds);
+        return 1;
+    }
+
+    // the body may redefine its own function while it runs
+    command_list_retain(body);
+    depth++;
+    int status = execute_list(body, false);
+    if (returning) {
+        status = return_status;
+        returning = false;
+    }
+    depth--;
+    command_list_release(body);
+
+    vars_pop_scope();
+    if (cmd->redirc > 0) restore_fds(saved_fds);
+    return status;
+}
+
+bool function_return(int status) {
+    if (depth == 0) return false;
+    returning = true;
+    return_status = status;
+    return true;
+}
+
+bool function_returning(void) { return returning; }
@@ -0,0 +1,38 @@
+#ifndef FUNCTION_H
+#define FUNCTION_H
+
+#include <stdbool.h>
+
+#include "shell.h"
+
+/*
+ * Shell functions.
+ *
+ * `name() { list; }` keeps a reference to the parsed body. A call runs it
+ * in the shell process with the arguments as $1..$n, so it costs a table
+ * lookup rather than fork + exec + parse of a script.
+ */
+
+// Calls nested deeper than this fail instead of exhausting the stack
+#define FUNCTION_MAX_DEPTH 1000
+
+/* Defines or replaces name; takes a reference to body */
+bool function_define(const char* name, CommandList* body);
+
+/* Body of function name, or NULL */
+CommandList* function_find(const char* name);
+
+/*
+ * Runs body with cmd's arguments as positional parameters and cmd's
+ * redirections applied. Returns the status of `return` or of the last
+ * command.
+ */
+int function_call(CommandList* body, const Command* cmd);
+
+/* Makes the innermost call return status; false outside a function */
+bool function_return(int status);
+
+/* Whether a `return` is unwinding the current call */
+bool function_returning(void);
+
+#endif
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "optimize.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "builtin/builtin.h"
+#include "function.h"
+
+// Builtins that only produce output: running one in the shell instead of
+// a forked stage cannot change any state the shell keeps. test -t looks at
+// the builtin's own redirected streams, so it still sees FILE, not a tty.
+static const char* const pure_builtins[] = {
+    "echo", "printf", "pwd", "type", "test", "[", "true", "false", ":",
+};
+
+// Whether c runs the external program name
+static bool is_external(const Command* c, const char* name) {
+    return c->argc > 0 && strcmp(c->argv[0], name) == 0 &&
+           !function_find(name) && !find_builtin(name);
+}
+
+static bool redirects_stdin(const Command* c) {
+    for (int i = 0; i < c->redirc; i++) {
+        if (c->redirections[i].target_fd == STDIN_FILENO) return true;
+    }
+    return false;
+}
+
+// FILE of a `cat FILE` or `cat < FILE` stage, if opening it for reading
+// will work; NULL otherwise
+static const char* cat_source(const Command* c) {
+    if (!is_external(c, "cat")) return NULL;
+
+    const char* file;
+    if (c->argc == 2 && c->redirc == 0) {
+        file = c->argv[1];
+    } else if (c->argc == 1 && c->redirc == 1 &&
+               c->redirections[0].target_fd == STDIN_FILENO &&
+               c->redirections[0].mode == READ) {
+        file = c->redirections[0].filename;
+    } else {
+        return NULL;
+    }
+    if (file[0] == '-') return NULL;  // an option, or stdin
+
+    struct stat st;
+    if (stat(file, &st) != 0 || S_ISDIR(st.st_mode) ||
+        access(file, R_OK) != 0) {
+        return NULL;
+    }
+    return file;
+}
+
+// A lone stage runs without a fork when it is a builtin, function or
+// assignment; only let that happen where the forked stage it replaces
+// could not have touched the shell's state
+static bool can_run_alone(const Command* c) {
+    const char* name = c->argv[0];
+    if (c->argc == 0 || strchr(name, '=') || function_find(name)) {
+        return false;
+    }
+    if (!find_builtin(name)) return true;
+    if (builtin_is_loaded(name)) return false;
+
+    for (size_t i = 0; i < sizeof(pure_builtins) / sizeof(pure_builtins[0]);
+         i++) {
+        if (strcmp(pure_builtins[i], name) == 0) return true;
+    }
+    return false;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+bool optimize_pipeline(const Pipeline* pl, Command* cmds, Pipeline* out) {
+    if (pl->count < 2 || shell_options.pipefail) return false;
+
+    // a | cat | b: both sides of the cat are pipes either way
+    size_t n = 0;
+    for (size_t i = 0; i < pl->count; i++) {
+        const Command* c = &pl->cmds[i];
+        if (i > 0 && i < pl->count - 1 && c->argc == 1 && c->redirc == 0 &&
+            is_external(c, "cat")) {
+            continue;
+        }
+        cmds[n++] = *c;
+    }
+
+    // cat FILE | cmd: cmd reads FILE itself
+    const char* file = cat_source(&cmds[0]);
+    if (file && n >= 2 && !redirects_stdin(&cmds[1]) &&
+        cmds[1].redirc < MAX_REDIR) {
+        Command* next = &cmds[1];
+        next->redirections[next->redirc++] =
+            (Redirection){STDIN_FILENO, READ, (char*)file};
+        memmove(cmds, next, sizeof(Command) * --n);
+    }
+
+    if (n == pl->count) return false;
+    if (n == 1 && !can_run_alone(&cmds[0])) return false;
+
+    *out = (Pipeline){cmds, n};
+    return true;
+}
+
+static void print_pipeline(FILE* f, const Pipeline* pl) {
+    for (size_t i = 0; i < pl->count; i++) {
+        const Command* c = &pl->cmds[i];
+        if (i) fputs(" | ", f);
+        for (int j = 0; j < c->argc; j++) {
+            fprintf(f, j ? " %s" : "%s", c->argv[j]);
+        }
+        for (int j = 0; j < c->redirc; j++) {
+            const Redirection* r = &c->redirections[j];
+            const char* op = r->mode == READ     ? "<"
+                             : r->mode == APPEND ? ">>"
+                             : r->mode == DUP    ? (r->target_fd ? ">&" : "<&")
+                                                 : ">";
+            fprintf(f, r->target_fd == STDERR_FILENO ? " 2%s %s" : " %s %s",
+                    op, r->filename);
+        }
+    }
+}
+
+void optimize_explain(FILE* f, const Pipeline* before, const Pipeline* after) {
+    fputs("optimize: ", f);
+    print_pipeline(f, before);
+    fputs("  =>  ", f);
+    print_pipeline(f, after);
+    fputc('\n', f);
+}
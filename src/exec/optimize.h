@@ -0,0 +1,38 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "shell.h"
+
+/*
+ * Pipeline rewriting (`set -o optimize`, on by default).
+ *
+ * Runs on the expanded pipeline just before it executes and removes
+ * processes whose only job is to move bytes:
+ *
+ *   cat FILE | cmd ...     ->  cmd < FILE ...
+ *   cat < FILE | cmd ...   ->  cmd < FILE ...
+ *   a | cat | b            ->  a | b
+ *
+ * A pipeline left with one stage takes the single-command path: an
+ * external program is forked once with no pipe, and a builtin without
+ * side effects on the shell runs in the shell itself. Rewrites are only
+ * made when the output cannot differ: FILE must be a readable
+ * non-directory (otherwise cat's error and the rest of the pipeline
+ * still happen), and none are made under pipefail, where the status of
+ * the removed cat could decide the result.
+ */
+
+/*
+ * Writes the rewritten pipeline to *out, using cmds (pl->count entries)
+ * for its stages; the words stay pl's. Returns false and leaves *out
+ * untouched when nothing applies.
+ */
+bool optimize_pipeline(const Pipeline* pl, Command* cmds, Pipeline* out);
+
+/* `set -o explain`: prints `before  =>  after` to f */
+void optimize_explain(FILE* f, const Pipeline* before, const Pipeline* after);
+
+#endif
@@ -0,0 +1,244 @@
+#define _GNU_SOURCE
+
+#include "pipemon.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "exec/wait.h"
+
+#define RELAY_CHUNK (1 << 20)               // bytes per splice() call
+#define DISPLAY_INTERVAL_NS 500000000LL     // live line refresh
+
+typedef struct {
+    int in;   // read end of the producer's pipe
+    int out;  // write end of the consumer's pipe
+    const char* from;
+    const char* to;
+    pthread_t thread;
+    bool started;
+
+    _Atomic uint64_t bytes;
+    _Atomic int64_t producer_wait_ns;  // nothing to read
+    _Atomic int64_t consumer_wait_ns;  // no room to write
+    int64_t start_ns;
+    _Atomic int64_t end_ns;
+} Edge;
+
+struct PipeMonitor {
+    Edge* edges;
+    size_t count;
+    pthread_t display;
+    bool display_started;
+    _Atomic bool done;
+};
+
+/* ------------------------------------------------------------ */
+/* Relay                                                        */
+/* ------------------------------------------------------------ */
+
+// Blocks until fd is ready for events; the time is charged to *wait_ns.
+// Returns the poll revents.
+static short wait_ready(int fd, short events, _Atomic int64_t* wait_ns) {
+    struct pollfd pfd = {fd, events, 0};
+    int64_t start = monotonic_ns();
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+    atomic_fetch_add_explicit(wait_ns, monotonic_ns() - start,
+                              memory_order_relaxed);
+    return pfd.revents;
+}
+
+static void* relay(void* arg) {
+    Edge* e = arg;
+
+    while (1) {
+        wait_ready(e->in, POLLIN, &e->producer_wait_ns);
+
+        ssize_t n = splice(e->in, NULL, e->out, NULL, RELAY_CHUNK,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            atomic_fetch_add_explicit(&e->bytes, (uint64_t)n,
+                                      memory_order_relaxed);
+            continue;
+        }
+        if (n == 0) break;  // producer closed its end
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) break;  // EPIPE: the consumer is gone
+
+        // input is ready, so the consumer's pipe is full
+        short revents = wait_ready(e->out, POLLOUT, &e->consumer_wait_ns);
+        if (revents & POLLERR) break;
+    }
+
+    // closing both ends passes EOF downstream and SIGPIPE upstream
+    atomic_store(&e->end_ns, monotonic_ns());
+    close(e->in);
+    close(e->out);
+    return NULL;
+}
+
+/* ------------------------------------------------------------ */
+/* Reporting                                                    */
+/* ------------------------------------------------------------ */
+
+static const char* human_bytes(double n, char* buf, size_t size) {
+    static const char* const units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    size_t u = 0;
+    while (n >= 1024 && u < sizeof(units) / sizeof(units[0]) - 1) {
+        n /= 1024;
+        u++;
+    }
+    snprintf(buf, size, u ? "%.1f %s" : "%.0f %s", n, units[u]);
+    return buf;
+}
+
+static void* display(void* arg) {
+    PipeMonitor* mon = arg;
+    uint64_t last_bytes[mon->count];
+    memset(last_bytes, 0, sizeof(last_bytes));
+    int64_t last = monotonic_ns();
+
+    while (!atomic_load(&mon->done)) {
+        struct timespec step = {0, 100 * 1000000};  // 100ms
+        nanosleep(&step, NULL);
+
+        int64_t now = monotonic_ns();
+        if (now - last < DISPLAY_INTERVAL_NS) continue;
+        double seconds = (now - last) / 1e9;
+        last = now;
+
+        char line[1024];
+        size_t len = snprintf(line, sizeof(line), "\r\033[K");
+        for (size_t i = 0; i < mon->count && len < sizeof(line); i++) {
+            Edge* e = &mon->edges[i];
+            uint64_t bytes = atomic_load_explicit(&e->bytes,
+                                                  memory_order_relaxed);
+            char total[32], rate[32];
+            len += snprintf(line + len, sizeof(line) - len,
+                            "%s%s>%s %s %s/s", i ? "  " : "", e->from, e->to,
+                            human_bytes(bytes, total, sizeof(total)),
+                            human_bytes((bytes - last_bytes[i]) / seconds,
+                                        rate, sizeof(rate)));
+            last_bytes[i] = bytes;
+        }
+        if (len > sizeof(line)) len = sizeof(line);
+        write(STDERR_FILENO, line, len);
+    }
+    write(STDERR_FILENO, "\r\033[K", 4);
+    return NULL;
+}
+
+static void print_summary(const PipeMonitor* mon) {
+    for (size_t i = 0; i < mon->count; i++) {
+        const Edge* e = &mon->edges[i];
+        if (!e->started) continue;
+
+        int64_t elapsed = atomic_load(&e->end_ns) - e->start_ns;
+        double seconds = elapsed > 0 ? elapsed / 1e9 : 1e-9;
+        char total[32], rate[32];
+        fprintf(stderr,
+                "pipemon: %s -> %s: %s in %.3f s (%s/s), waiting on producer "
+                "%.0f%%, on consumer %.0f%%\n",
+                e->from, e->to, human_bytes(e->bytes, total, sizeof(total)),
+                seconds, human_bytes(e->bytes / seconds, rate, sizeof(rate)),
+                100.0 * e->producer_wait_ns / (seconds * 1e9),
+                100.0 * e->consumer_wait_ns / (seconds * 1e9));
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+PipeMonitor* pipemon_create(const Pipeline* pl) {
+    if (pl->count < 2) return NULL;
+
+    PipeMonitor* mon = calloc(1, sizeof(PipeMonitor));
+    if (!mon) return NULL;
+    mon->count = pl->count - 1;
+    mon->edges = calloc(mon->count, sizeof(Edge));
+    if (!mon->edges) {
+        free(mon);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < mon->count; i++) {
+        Edge* e = &mon->edges[i];
+        e->in = e->out = -1;
+        e->from = pl->cmds[i].argv[0];
+        e->to = pl->cmds[i + 1].argv[0];
+    }
+    return mon;
+}
+
+bool pipemon_edge(PipeMonitor* mon, size_t i, int* write_fd, int* read_fd) {
+    int upstream[2], downstream[2];
+    if (pipe2(upstream, O_CLOEXEC) != 0) return false;
+    if (pipe2(downstream, O_CLOEXEC) != 0) {
+        close(upstream[0]);
+        close(upstream[1]);
+        return false;
+    }
+
+    Edge* e = &mon->edges[i];
+    e->in = upstream[0];
+    e->out = downstream[1];
+    *write_fd = upstream[1];
+    *read_fd = downstream[0];
+    return true;
+}
+
+void pipemon_child(PipeMonitor* mon) {
+    for (size_t i = 0; i < mon->count; i++) {
+        if (mon->edges[i].in >= 0) close(mon->edges[i].in);
+        if (mon->edges[i].out >= 0) close(mon->edges[i].out);
+    }
+}
+
+void pipemon_start(PipeMonitor* mon) {
+    // relays must not take the shell's signals (SIGINT, SIGPIPE on EPIPE)
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+
+    for (size_t i = 0; i < mon->count; i++) {
+        Edge* e = &mon->edges[i];
+        if (e->in < 0) continue;
+        e->start_ns = monotonic_ns();
+        e->started = pthread_create(&e->thread, NULL, relay, e) == 0;
+        if (!e->started) {
+            close(e->in);
+            close(e->out);
+        }
+    }
+    if (isatty(STDERR_FILENO)) {
+        mon->display_started =
+            pthread_create(&mon->display, NULL, display, mon) == 0;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+void pipemon_finish(PipeMonitor* mon) {
+    if (!mon) return;
+
+    for (size_t i = 0; i < mon->count; i++) {
+        if (mon->edges[i].started) pthread_join(mon->edges[i].thread, NULL);
+    }
+    atomic_store(&mon->done, true);
+    if (mon->display_started) pthread_join(mon->display, NULL);
+
+    print_summary(mon);
+    free(mon->edges);
+    free(mon);
+}
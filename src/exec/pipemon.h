@@ -0,0 +1,40 @@
+#ifndef PIPEMON_H
+#define PIPEMON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "shell.h"
+
+/*
+ * Pipe throughput monitor (`set -o pipemon`).
+ *
+ * Every edge of a pipeline gets two pipes with a relay thread in the shell
+ * between them, moving data with splice() so nothing is copied through
+ * user space. The relay counts bytes and the time it spends waiting for
+ * the producer (edge starved: upstream is slow) and for the consumer
+ * (edge backed up: downstream is slow). A live line is shown on a terminal
+ * stderr and a summary is printed when the pipeline finishes.
+ */
+
+typedef struct PipeMonitor PipeMonitor;
+
+PipeMonitor* pipemon_create(const Pipeline* pl);
+
+/*
+ * Stands in for pipe() on edge i (between stage i and i + 1): *write_fd
+ * goes to the producer, *read_fd to the consumer, and the caller closes
+ * them exactly as it would a pipe's ends.
+ */
+bool pipemon_edge(PipeMonitor* mon, size_t i, int* write_fd, int* read_fd);
+
+/* In a forked stage: drop the relay's ends inherited from the shell */
+void pipemon_child(PipeMonitor* mon);
+
+/* Start the relays once every stage is forked */
+void pipemon_start(PipeMonitor* mon);
+
+/* Wait for the relays to drain, print the summary and free mon */
+void pipemon_finish(PipeMonitor* mon);
+
+#endif
@@ -1,10 +1,78 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "redirection.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
+#include "exec/wait.h"
+#include "util/trace.h"
+
+static int open_redirection_target(const Redirection* r) {
+    int64_t start = trace_enabled() ? monotonic_ns() : 0;
+    int flags = O_RDONLY;
+    if (r->mode != READ) {
+        flags = O_WRONLY | O_CREAT;
+        if (r->mode == TRUNC) {
+            flags |= O_TRUNC;
+        } else {
+            flags |= O_APPEND;
+        }
+    }
+    int fd = open(r->filename, flags | O_CLOEXEC, 0644);
+    if (trace_enabled()) {
+        trace_span("redirect", r->filename, start, monotonic_ns(), 0);
+    }
+    return fd;
+}
+
+// N>&M: a copy of fd M. Where 0-2 are only being redirected (fds set,
+// for builtins), M = 0-2 means wherever that fd is going.
+static int dup_source(const Redirection* r, const int fds[3]) {
+    char* end;
+    long fd = strtol(r->filename, &end, 10);
+    if (end == r->filename || *end || fd < 0 || fd > INT_MAX) {
+        errno = EBADF;
+        return -1;
+    }
+    if (fds && fd <= STDERR_FILENO) fd = fds[fd];
+    return fcntl((int)fd, F_DUPFD_CLOEXEC, 0);
+}
+
+void close_redirections(int fds[3]) {
+    for (int i = 0; i < 3; i++) {
+        if (fds[i] > STDERR_FILENO) close(fds[i]);
+        fds[i] = i;
+    }
+}
+
+int open_redirections(const Command* cmd, int fds[3]) {
+    fds[0] = STDIN_FILENO;
+    fds[1] = STDOUT_FILENO;
+    fds[2] = STDERR_FILENO;
+
+    for (int i = 0; i < cmd->redirc; ++i) {
+        const Redirection* r = &cmd->redirections[i];
+        int fd = r->mode == DUP ? dup_source(r, fds)
+                                : open_redirection_target(r);
+        if (fd < 0) {
+            perror(r->filename);
+            close_redirections(fds);
+            return -1;
+        }
+        // a later redirection of the same fd wins
+        if (fds[r->target_fd] > STDERR_FILENO) close(fds[r->target_fd]);
+        fds[r->target_fd] = fd;
+    }
+
+    return 0;
+}
+
 void restore_fds(int saved_fds[3]) {
     dup2(saved_fds[0], STDIN_FILENO);
     dup2(saved_fds[1], STDOUT_FILENO);
@@ -29,17 +97,8 @@ int apply_redirections(const Command* cmd, int saved_fds[3]) {
 
     for (int i = 0; i < cmd->redirc; ++i) {
         const Redirection* r = &cmd->redirections[i];
-        int flags = O_RDONLY;
-        if (r->mode != READ) {
-            flags = O_WRONLY | O_CREAT;
-            if (r->mode == TRUNC) {
-                flags |= O_TRUNC;
-            } else {
-                flags |= O_APPEND;
-            }
-        }
-
-        int fd = open(r->filename, flags, 0644);
+        int fd = r->mode == DUP ? dup_source(r, NULL)
+                                : open_redirection_target(r);
         if (fd < 0) {
             perror(r->filename);
             if (saved_fds != NULL) restore_fds(saved_fds);
@@ -6,4 +6,8 @@
 int apply_redirections(const Command*, int saved_fds[3]);
 void restore_fds(int saved_fds[3]);
 
+/* Open redirection targets into fds[0..2] without dup2'ing over 0/1/2 */
+int open_redirections(const Command*, int fds[3]);
+void close_redirections(int fds[3]);
+
 #endif
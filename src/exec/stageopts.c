@@ -0,0 +1,195 @@
+#define _GNU_SOURCE
+
+#include "stageopts.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+// linux/ioprio.h
+enum { IOPRIO_WHO_PROCESS = 1, IOPRIO_CLASS_SHIFT = 13 };
+enum {
+    IOPRIO_CLASS_NONE,
+    IOPRIO_CLASS_RT,
+    IOPRIO_CLASS_BE,
+    IOPRIO_CLASS_IDLE,
+};
+
+_Static_assert(sizeof(((StageOptions*)0)->cpus) == sizeof(cpu_set_t),
+              "StageOptions.cpus must hold a cpu_set_t");
+
+/* ------------------------------------------------------------ */
+/* Values                                                       */
+/* ------------------------------------------------------------ */
+
+static bool parse_number(const char* s, const char** end, long* value) {
+    char* e;
+    errno = 0;
+    *value = strtol(s, &e, 10);
+    if (e == s || errno == ERANGE) return false;
+    *end = e;
+    return true;
+}
+
+// 0-3,8,10-11
+static bool parse_cpus(const char* s, StageOptions* opts) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    while (1) {
+        long first, last;
+        if (*s == '-' || !parse_number(s, &s, &first)) return false;
+        last = first;
+        if (*s == '-' && !parse_number(s + 1, &s, &last)) return false;
+        if (first < 0 || last < first || last >= STAGEOPTS_MAX_CPUS) {
+            return false;
+        }
+        for (long cpu = first; cpu <= last; cpu++) CPU_SET(cpu, &set);
+
+        if (*s == '\0') break;
+        if (*s++ != ',') return false;
+    }
+    memcpy(opts->cpus, &set, sizeof(set));
+    opts->has_cpus = true;
+    return true;
+}
+
+static bool parse_nice(const char* s, StageOptions* opts) {
+    long n;
+    if (!parse_number(s, &s, &n) || *s || n < -20 || n > 19) return false;
+    opts->nice = n;
+    opts->has_nice = true;
+    return true;
+}
+
+// idle | none | be[:N] | rt[:N]
+static bool parse_ionice(const char* s, StageOptions* opts) {
+    int class;
+    if (strncmp(s, "idle", 4) == 0) {
+        class = IOPRIO_CLASS_IDLE;
+        s += 4;
+    } else if (strncmp(s, "none", 4) == 0) {
+        class = IOPRIO_CLASS_NONE;
+        s += 4;
+    } else if (strncmp(s, "be", 2) == 0) {
+        class = IOPRIO_CLASS_BE;
+        s += 2;
+    } else if (strncmp(s, "rt", 2) == 0) {
+        class = IOPRIO_CLASS_RT;
+        s += 2;
+    } else {
+        return false;
+    }
+
+    long level = class == IOPRIO_CLASS_BE || class == IOPRIO_CLASS_RT ? 4 : 0;
+    if (*s == ':') {
+        if (class != IOPRIO_CLASS_BE && class != IOPRIO_CLASS_RT) return false;
+        if (!parse_number(s + 1, &s, &level) || level < 0 || level > 7) {
+            return false;
+        }
+    }
+    if (*s) return false;
+
+    opts->ioprio = class << IOPRIO_CLASS_SHIFT | (int)level;
+    opts->has_ionice = true;
+    return true;
+}
+
+static bool parse_cgroup(const char* s, StageOptions* opts) {
+    opts->cgroup = s;
+    return *s != '\0';
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+static const struct {
+    const char* name;  // including @ and =
+    bool (*parse)(const char*, StageOptions*);
+} options[] = {
+    {"@cpus=", parse_cpus},
+    {"@nice=", parse_nice},
+    {"@ionice=", parse_ionice},
+    {"@cgroup=", parse_cgroup},
+};
+
+bool stage_options_parse(Command* cmd, StageOptions* opts) {
+    while (cmd->argc > 0) {
+        const char* word = cmd->argv[0];
+        size_t i = 0, n = sizeof(options) / sizeof(options[0]);
+        while (i < n && strncmp(word, options[i].name,
+                                strlen(options[i].name)) != 0) {
+            i++;
+        }
+        if (i == n) break;
+
+        const char* value = word + strlen(options[i].name);
+        if (!options[i].parse(value, opts)) {
+            fprintf(stderr, "%.*s: invalid value '%s'\n",
+                    (int)strlen(options[i].name) - 1, word, value);
+            return false;
+        }
+        cmd->argv++;
+        cmd->argc--;
+    }
+    return true;
+}
+
+bool stage_options_any(const StageOptions* opts) {
+    return opts->has_cpus || opts->has_nice || opts->has_ionice ||
+           opts->cgroup;
+}
+
+static bool join_cgroup(const char* dir) {
+    char path[4096];
+    int n = snprintf(path, sizeof(path), "%s%s/cgroup.procs",
+                     dir[0] == '/' ? "" : CGROUP_ROOT "/", dir);
+    if (n < 0 || (size_t)n >= sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char pid[32];
+    int len = snprintf(pid, sizeof(pid), "%d\n", (int)getpid());
+    bool ok = write(fd, pid, len) == len;
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return ok;
+}
+
+bool stage_options_apply(const StageOptions* opts) {
+    // the cgroup first: its own cpuset may narrow the affinity asked for
+    if (opts->cgroup && !join_cgroup(opts->cgroup)) {
+        fprintf(stderr, "@cgroup=%s: %s\n", opts->cgroup, strerror(errno));
+        return false;
+    }
+    if (opts->has_cpus) {
+        cpu_set_t set;
+        memcpy(&set, opts->cpus, sizeof(set));
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            perror("@cpus");
+            return false;
+        }
+    }
+    if (opts->has_nice && setpriority(PRIO_PROCESS, 0, opts->nice) != 0) {
+        perror("@nice");
+        return false;
+    }
+    if (opts->has_ionice &&
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, opts->ioprio) != 0) {
+        perror("@ionice");
+        return false;
+    }
+    return true;
+}
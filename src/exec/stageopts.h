@@ -0,0 +1,47 @@
+#ifndef STAGEOPTS_H
+#define STAGEOPTS_H
+
+#include <stdbool.h>
+
+#include "shell.h"
+
+/*
+ * Per-stage process placement, written as words in front of a stage:
+ *
+ *   @cpus=0-3,8      CPU affinity (sched_setaffinity)
+ *   @nice=N          scheduling priority, -20..19 (setpriority)
+ *   @ionice=CLASS    idle, be[:0-7], rt[:0-7] or none (ioprio_set)
+ *   @cgroup=DIR      join a cgroup v2 directory, absolute or relative to
+ *                    /sys/fs/cgroup; it must be delegated to the user
+ *
+ *   @cpus=0-3 @nice=5 zstd -dc big.zst | @cpus=4-7 parse | aggregate
+ *
+ * They are applied in the stage's own process just before it runs, so a
+ * stage with any of them is always forked, builtins included.
+ */
+
+#define STAGEOPTS_MAX_CPUS 1024
+
+typedef struct {
+    bool has_cpus;
+    unsigned long cpus[STAGEOPTS_MAX_CPUS / (8 * sizeof(unsigned long))];
+    bool has_nice;
+    int nice;
+    bool has_ionice;
+    int ioprio;  // class << 13 | level, as ioprio_set takes it
+    const char* cgroup;  // points into the command's words
+} StageOptions;
+
+/*
+ * Moves leading @name=value words of cmd into *opts, adding to what is
+ * already there. Other words, @-words included, end the prefix. Returns
+ * false after reporting a malformed value.
+ */
+bool stage_options_parse(Command* cmd, StageOptions* opts);
+
+bool stage_options_any(const StageOptions* opts);
+
+/* In the stage's process; false after reporting what failed */
+bool stage_options_apply(const StageOptions* opts);
+
+#endif
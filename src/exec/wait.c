@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+
+#include "wait.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// time between SIGTERM and SIGKILL once a deadline has passed
+#define KILL_GRACE_NS (2LL * 1000000000)
+
+int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int wait_status_code(int raw_status) {
+    if (WIFEXITED(raw_status)) return WEXITSTATUS(raw_status);
+    if (WIFSIGNALED(raw_status)) return 128 + WTERMSIG(raw_status);
+    return -1;
+}
+
+static int pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static pid_t reap(pid_t pid, int* status) {
+    pid_t r;
+    do {
+        r = waitpid(pid, status, 0);
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+/* ------------------------------------------------------------ */
+/* Deadline handling                                            */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    const pid_t* pids;
+    const bool* done;
+    size_t n;
+    pid_t pgid;
+    int64_t deadline_ns;
+    int stage;  // 0: running, 1: SIGTERM sent, 2: SIGKILL sent
+    int64_t* reaped_ns;
+    bool fail_fast;
+} Escalation;
+
+static void signal_stages(const Escalation* e, int sig) {
+    if (e->pgid > 0) {
+        kill(-e->pgid, sig);
+        return;
+    }
+    for (size_t i = 0; i < e->n; i++) {
+        if (!e->done[i]) kill(e->pids[i], sig);
+    }
+}
+
+// Called when the current deadline has passed; moves to the next step
+static void escalate(Escalation* e, WaitResult* result) {
+    if (e->stage == 0) {
+        if (result) result->timed_out = true;
+        signal_stages(e, SIGTERM);
+        e->deadline_ns = monotonic_ns() + KILL_GRACE_NS;
+        e->stage = 1;
+    } else if (e->stage == 1) {
+        signal_stages(e, SIGKILL);
+        e->deadline_ns = 0;
+        e->stage = 2;
+    }
+}
+
+// fail_fast: a stage failed, so the ones still running get SIGTERM now
+// and SIGKILL after the same grace period as a timeout
+static void cut_short(Escalation* e, WaitResult* result) {
+    bool running = false;
+    for (size_t i = 0; i < e->n && !running; i++) {
+        // an exited stage that is not reaped yet was not cut short
+        siginfo_t info = {0};
+        running = !e->done[i] &&
+                  waitid(P_PID, (id_t)e->pids[i], &info,
+                         WEXITED | WNOHANG | WNOWAIT) == 0 &&
+                  info.si_pid == 0;
+    }
+    if (!running) return;
+
+    if (result) result->cut_short = true;
+    signal_stages(e, SIGTERM);
+    e->deadline_ns = monotonic_ns() + KILL_GRACE_NS;
+    e->stage = 1;
+}
+
+// Milliseconds until the deadline for epoll_wait/sleeping, -1 for none
+static int timeout_ms(const Escalation* e) {
+    if (e->deadline_ns == 0) return -1;
+    int64_t left = e->deadline_ns - monotonic_ns();
+    if (left <= 0) return 0;
+    return (int)((left + 999999) / 1000000);
+}
+
+/* ------------------------------------------------------------ */
+/* Strategies                                                   */
+/* ------------------------------------------------------------ */
+
+// Called with done[i] already set
+static void record(Escalation* e, size_t i, int status, int* raw_statuses,
+                   WaitResult* result) {
+    raw_statuses[i] = status;
+    if (e->reaped_ns) e->reaped_ns[i] = monotonic_ns();
+    if (wait_status_code(status) == 0) return;
+    if (result && result->first_failed < 0) result->first_failed = (int)i;
+    // SIGPIPE means a reader downstream is done, not that this stage
+    // failed: that reader may still be writing what it read
+    bool broken_pipe = WIFSIGNALED(status) && WTERMSIG(status) == SIGPIPE;
+    if (e->fail_fast && e->stage == 0 && !broken_pipe) cut_short(e, result);
+}
+
+// Without pidfds: poll with WNOHANG, sleeping in short steps
+static void wait_polling(Escalation* e, bool* done, int* raw_statuses,
+                         WaitResult* result) {
+    size_t remaining = 0;
+    for (size_t i = 0; i < e->n; i++) remaining += !done[i];
+
+    while (remaining > 0) {
+        if (e->deadline_ns == 0 && !e->fail_fast) {
+            // nothing left to enforce: block on each stage in turn
+            for (size_t i = 0; i < e->n; i++) {
+                int status = 0;
+                if (done[i]) continue;
+                reap(e->pids[i], &status);
+                done[i] = true;
+                record(e, i, status, raw_statuses, result);
+            }
+            return;
+        }
+
+        bool progress = false;
+        for (size_t i = 0; i < e->n; i++) {
+            int status;
+            if (done[i] || waitpid(e->pids[i], &status, WNOHANG) <= 0) continue;
+            done[i] = true;
+            remaining--;
+            progress = true;
+            record(e, i, status, raw_statuses, result);
+        }
+        if (remaining == 0 || progress) continue;
+
+        int ms = timeout_ms(e);
+        if (ms == 0) {
+            escalate(e, result);
+            continue;
+        }
+        struct timespec step = {0, 5 * 1000000};  // 5ms
+        nanosleep(&step, NULL);
+    }
+}
+
+static void wait_epoll(Escalation* e, bool* done, int* pidfds,
+                       int* raw_statuses, WaitResult* result) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        wait_polling(e, done, raw_statuses, result);
+        return;
+    }
+
+    size_t remaining = e->n;
+    for (size_t i = 0; i < e->n; i++) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (uint32_t)i};
+        epoll_ctl(ep, EPOLL_CTL_ADD, pidfds[i], &ev);
+    }
+
+    struct epoll_event events[16];
+    while (remaining > 0) {
+        int ready = epoll_wait(ep, events, 16, timeout_ms(e));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ready == 0) {
+            escalate(e, result);
+            continue;
+        }
+
+        for (int k = 0; k < ready; k++) {
+            size_t i = events[k].data.u32;
+            int status = 0;
+            reap(e->pids[i], &status);
+            epoll_ctl(ep, EPOLL_CTL_DEL, pidfds[i], NULL);
+            done[i] = true;
+            remaining--;
+            record(e, i, status, raw_statuses, result);
+        }
+    }
+
+    close(ep);
+
+    // epoll failure: fall back to blocking waits for the rest
+    for (size_t i = 0; i < e->n; i++) {
+        int status = 0;
+        if (done[i]) continue;
+        reap(e->pids[i], &status);
+        done[i] = true;
+        record(e, i, status, raw_statuses, result);
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+void wait_stages(const pid_t* pids, size_t n, int* raw_statuses,
+                 const WaitOptions* opts, WaitResult* result) {
+    if (result) *result = (WaitResult){.first_failed = -1};
+    if (n == 0) return;
+
+    bool done[n];
+    Escalation e = {pids,
+                    done,
+                    n,
+                    opts ? opts->pgid : 0,
+                    opts ? opts->deadline_ns : 0,
+                    0,
+                    opts ? opts->reaped_ns : NULL,
+                    opts && opts->fail_fast && n > 1};
+
+    // a single child without a deadline needs nothing fancier
+    if (n == 1 && e.deadline_ns == 0) {
+        int status = 0;
+        reap(pids[0], &status);
+        done[0] = true;
+        record(&e, 0, status, raw_statuses, result);
+        return;
+    }
+
+    int pidfds[n];
+    bool have_pidfds = true;
+    for (size_t i = 0; i < n; i++) {
+        done[i] = false;
+        pidfds[i] = have_pidfds ? pidfd_open(pids[i]) : -1;
+        if (pidfds[i] < 0) have_pidfds = false;
+    }
+
+    if (have_pidfds) {
+        wait_epoll(&e, done, pidfds, raw_statuses, result);
+    } else {
+        wait_polling(&e, done, raw_statuses, result);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (pidfds[i] >= 0) close(pidfds[i]);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef WAIT_H
+#define WAIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Pipeline wait engine.
+ *
+ * Reaps a set of children in the order they finish, using one pidfd per
+ * child multiplexed through epoll (falling back to waitpid() where pidfds
+ * are unavailable). An optional deadline escalates SIGTERM -> SIGKILL to
+ * the stages' process group. With fail_fast (pipefail), the first stage to
+ * exit non-zero starts the same escalation for the stages still running.
+ */
+
+typedef struct {
+    int64_t deadline_ns;  // CLOCK_MONOTONIC, 0 means no deadline
+    pid_t pgid;           // group signalled on timeout, 0 = each pid
+    int64_t* reaped_ns;   // optional: when each pid was reaped
+    bool fail_fast;       // stop the rest once one stage fails
+} WaitOptions;
+
+typedef struct {
+    int first_failed;  // stage that exited non-zero first, -1 if none
+    bool timed_out;
+    bool cut_short;  // fail_fast signalled stages that were still running
+} WaitResult;
+
+/*
+ * Wait for all n pids. raw_statuses[i] receives the waitpid() status of
+ * pids[i]. opts and result may be NULL.
+ */
+void wait_stages(const pid_t* pids, size_t n, int* raw_statuses,
+                 const WaitOptions* opts, WaitResult* result);
+
+/* Translate a waitpid() status into a shell exit code */
+int wait_status_code(int raw_status);
+
+int64_t monotonic_ns(void);
+
+#endif
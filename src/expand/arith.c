@@ -0,0 +1,647 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "arith.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds/strpool.h"
+#include "expand/vars.h"
+
+#define ARITH_CACHE_SIZE 256     // power of two
+#define ARITH_MAX_DEPTH 32       // nesting of variables holding expressions
+#define ARITH_MAX_NESTING 10000  // parser and evaluator recursion
+
+typedef enum {
+    N_NUM,
+    N_VAR,
+    N_NEG,
+    N_NOT,
+    N_BITNOT,
+    N_PREINC,
+    N_PREDEC,
+    N_POSTINC,
+    N_POSTDEC,
+    N_BINARY,
+    N_AND,
+    N_OR,
+    N_COND,
+    N_ASSIGN,
+    N_COMMA
+} NodeKind;
+
+typedef enum {
+    OP_NONE,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_ADD,
+    OP_SUB,
+    OP_SHL,
+    OP_SHR,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_BITAND,
+    OP_BITXOR,
+    OP_BITOR,
+    OP_POW,
+    OP_LAND,
+    OP_LOR
+} BinOp;
+
+typedef struct {
+    uint8_t kind;   // NodeKind
+    uint8_t op;     // BinOp, also the compound operator of N_ASSIGN
+    int32_t a, b, c;
+    int64_t value;  // N_NUM: the number; variables: name offset in names
+} Node;
+
+typedef struct {
+    Node* nodes;
+    size_t count;
+    size_t capacity;
+    StrPool names;
+    int32_t root;  // -1 for the empty expression
+} ArithExpr;
+
+/* ------------------------------------------------------------ */
+/* Parser                                                       */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    const char* p;
+    ArithExpr* e;
+    const char* error;
+    int depth;  // recursion, bounded by ARITH_MAX_NESTING
+} Parser;
+
+typedef struct {
+    const char* text;
+    uint8_t op;
+    uint8_t prec;
+} OpInfo;
+
+// longest first, so a prefix never shadows a longer operator
+static const OpInfo binary_ops[] = {
+    {"**", OP_POW, 11},   {"<<", OP_SHL, 8},    {">>", OP_SHR, 8},
+    {"<=", OP_LE, 7},     {">=", OP_GE, 7},     {"==", OP_EQ, 6},
+    {"!=", OP_NE, 6},     {"&&", OP_LAND, 2},   {"||", OP_LOR, 1},
+    {"*", OP_MUL, 10},    {"/", OP_DIV, 10},    {"%", OP_MOD, 10},
+    {"+", OP_ADD, 9},     {"-", OP_SUB, 9},     {"<", OP_LT, 7},
+    {">", OP_GT, 7},      {"&", OP_BITAND, 5},  {"^", OP_BITXOR, 4},
+    {"|", OP_BITOR, 3},
+};
+
+static const OpInfo assign_ops[] = {
+    {"<<=", OP_SHL, 0}, {">>=", OP_SHR, 0},    {"*=", OP_MUL, 0},
+    {"/=", OP_DIV, 0},  {"%=", OP_MOD, 0},     {"+=", OP_ADD, 0},
+    {"-=", OP_SUB, 0},  {"&=", OP_BITAND, 0},  {"^=", OP_BITXOR, 0},
+    {"|=", OP_BITOR, 0}, {"=", OP_NONE, 0},
+};
+
+static void skip_blanks(Parser* ps) {
+    while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n') ps->p++;
+}
+
+static int32_t fail(Parser* ps, const char* error) {
+    if (!ps->error) ps->error = error;
+    return -1;
+}
+
+// Every cycle in the grammar passes through parse_unary, parse_assign or
+// the right operand of parse_binary, which count it here so that
+// `((((...` or `!!!!...` cannot exhaust the stack
+static bool nest(Parser* ps) {
+    if (ps->depth == ARITH_MAX_NESTING) {
+        fail(ps, "expression nested too deeply");
+        return false;
+    }
+    ps->depth++;
+    return true;
+}
+
+static int32_t add_node(Parser* ps, NodeKind kind, uint8_t op, int32_t a,
+                        int32_t b, int32_t c, int64_t value) {
+    ArithExpr* e = ps->e;
+    if (e->count == e->capacity) {
+        size_t new_capacity = e->capacity ? e->capacity * 2 : 16;
+        Node* tmp = realloc(e->nodes, sizeof(Node) * new_capacity);
+        if (!tmp) return fail(ps, "out of memory");
+        e->nodes = tmp;
+        e->capacity = new_capacity;
+    }
+    e->nodes[e->count] = (Node){kind, op, a, b, c, value};
+    return (int32_t)e->count++;
+}
+
+// Variable name at ps->p ($name and ${name} included); its length or 0
+static size_t scan_name(Parser* ps, const char** name) {
+    const char* p = ps->p;
+    bool braced = false;
+    if (*p == '$') {
+        p++;
+        if (*p == '{') {
+            braced = true;
+            p++;
+        }
+    }
+    if (!isalpha((unsigned char)*p) && *p != '_') return 0;
+
+    const char* start = p;
+    while (isalnum((unsigned char)*p) || *p == '_') p++;
+    size_t n = p - start;
+    if (braced) {
+        if (*p != '}') return 0;
+        p++;
+    }
+
+    *name = start;
+    ps->p = p;
+    return n;
+}
+
+static int64_t intern_name(Parser* ps, const char* name, size_t n) {
+    uint32_t off = strpool_intern(&ps->e->names, name, n, NULL);
+    if (off == STRPOOL_NONE) fail(ps, "out of memory");
+    return off;
+}
+
+static int32_t parse_comma(Parser* ps);
+static int32_t parse_assign(Parser* ps);
+static int32_t parse_unary(Parser* ps);
+
+static int32_t parse_primary(Parser* ps) {
+    skip_blanks(ps);
+    char c = *ps->p;
+
+    if (c == '(') {
+        ps->p++;
+        int32_t inner = parse_comma(ps);
+        skip_blanks(ps);
+        if (*ps->p != ')') return fail(ps, "missing `)'");
+        ps->p++;
+        return inner;
+    }
+
+    if (isdigit((unsigned char)c)) {
+        char* end;
+        errno = 0;
+        long long v = strtoll(ps->p, &end, 0);
+        if (errno == ERANGE || isalnum((unsigned char)*end) || *end == '_')
+            return fail(ps, "invalid number");
+        ps->p = end;
+        return add_node(ps, N_NUM, OP_NONE, -1, -1, -1, v);
+    }
+
+    const char* name;
+    size_t n = scan_name(ps, &name);
+    if (n > 0) {
+        int64_t var = intern_name(ps, name, n);
+        skip_blanks(ps);
+        if (strncmp(ps->p, "++", 2) == 0 || strncmp(ps->p, "--", 2) == 0) {
+            NodeKind kind = ps->p[0] == '+' ? N_POSTINC : N_POSTDEC;
+            ps->p += 2;
+            return add_node(ps, kind, OP_NONE, -1, -1, -1, var);
+        }
+        return add_node(ps, N_VAR, OP_NONE, -1, -1, -1, var);
+    }
+
+    return fail(ps, c ? "syntax error: operand expected"
+                      : "syntax error: unexpected end of expression");
+}
+
+static int32_t unary_expr(Parser* ps) {
+    skip_blanks(ps);
+    const char* p = ps->p;
+
+    if ((p[0] == '+' || p[0] == '-') && p[1] == p[0]) {
+        // ++name / --name; otherwise two unary operators
+        ps->p += 2;
+        skip_blanks(ps);
+        const char* name;
+        const char* save = ps->p;
+        size_t n = scan_name(ps, &name);
+        if (n > 0) {
+            return add_node(ps, p[0] == '+' ? N_PREINC : N_PREDEC, OP_NONE,
+                            -1, -1, -1, intern_name(ps, name, n));
+        }
+        // a doubled sign cancels out
+        ps->p = save;
+        return parse_unary(ps);
+    }
+
+    switch (p[0]) {
+        case '+':
+            ps->p++;
+            return parse_unary(ps);
+        case '-': {
+            ps->p++;
+            int32_t operand = parse_unary(ps);
+            if (operand < 0) return -1;
+            return add_node(ps, N_NEG, OP_NONE, operand, -1, -1, 0);
+        }
+        case '!':
+        case '~': {
+            ps->p++;
+            int32_t operand = parse_unary(ps);
+            if (operand < 0) return -1;
+            return add_node(ps, p[0] == '!' ? N_NOT : N_BITNOT, OP_NONE,
+                            operand, -1, -1, 0);
+        }
+    }
+    return parse_primary(ps);
+}
+
+static int32_t parse_unary(Parser* ps) {
+    if (!nest(ps)) return -1;
+    int32_t node = unary_expr(ps);
+    ps->depth--;
+    return node;
+}
+
+static const OpInfo* match_binary(Parser* ps) {
+    skip_blanks(ps);
+    for (size_t i = 0; i < sizeof(binary_ops) / sizeof(binary_ops[0]); i++) {
+        const OpInfo* op = &binary_ops[i];
+        size_t n = strlen(op->text);
+        if (strncmp(ps->p, op->text, n) != 0) continue;
+
+        // `+=` and friends end the operand: they belong to parse_assign
+        bool comparison = op->op == OP_LE || op->op == OP_GE ||
+                          op->op == OP_EQ || op->op == OP_NE;
+        if (!comparison && ps->p[n] == '=') return NULL;
+        return op;
+    }
+    return NULL;
+}
+
+// Precedence climbing over binary_ops; ** is right-associative
+static int32_t parse_binary(Parser* ps, int min_prec) {
+    int32_t lhs = parse_unary(ps);
+    while (lhs >= 0) {
+        const OpInfo* op = match_binary(ps);
+        if (!op || op->prec < min_prec) break;
+        ps->p += strlen(op->text);
+
+        if (!nest(ps)) return -1;
+        int32_t rhs =
+            parse_binary(ps, op->op == OP_POW ? op->prec : op->prec + 1);
+        ps->depth--;
+        if (rhs < 0) return -1;
+
+        NodeKind kind = op->op == OP_LAND  ? N_AND
+                        : op->op == OP_LOR ? N_OR
+                                           : N_BINARY;
+        lhs = add_node(ps, kind, op->op, lhs, rhs, -1, 0);
+    }
+    return lhs;
+}
+
+static int32_t parse_cond(Parser* ps) {
+    int32_t cond = parse_binary(ps, 1);
+    if (cond < 0) return -1;
+
+    skip_blanks(ps);
+    if (*ps->p != '?') return cond;
+    ps->p++;
+
+    int32_t then = parse_comma(ps);
+    if (then < 0) return -1;
+    skip_blanks(ps);
+    if (*ps->p != ':') return fail(ps, "`:' expected for conditional");
+    ps->p++;
+
+    int32_t otherwise = parse_assign(ps);
+    if (otherwise < 0) return -1;
+    return add_node(ps, N_COND, OP_NONE, cond, then, otherwise, 0);
+}
+
+static int32_t assign_expr(Parser* ps) {
+    skip_blanks(ps);
+    const char* start = ps->p;
+
+    const char* name;
+    size_t n = scan_name(ps, &name);
+    if (n > 0) {
+        skip_blanks(ps);
+        for (size_t i = 0; i < sizeof(assign_ops) / sizeof(assign_ops[0]);
+             i++) {
+            const OpInfo* op = &assign_ops[i];
+            size_t len = strlen(op->text);
+            if (strncmp(ps->p, op->text, len) != 0) continue;
+            if (op->op == OP_NONE && ps->p[1] == '=') break;  // ==
+
+            ps->p += len;
+            int64_t var = intern_name(ps, name, n);
+            int32_t value = parse_assign(ps);
+            if (value < 0) return -1;
+            return add_node(ps, N_ASSIGN, op->op, value, -1, -1, var);
+        }
+    }
+
+    ps->p = start;
+    return parse_cond(ps);
+}
+
+static int32_t parse_assign(Parser* ps) {
+    if (!nest(ps)) return -1;
+    int32_t node = assign_expr(ps);
+    ps->depth--;
+    return node;
+}
+
+static int32_t parse_comma(Parser* ps) {
+    int32_t lhs = parse_assign(ps);
+    while (lhs >= 0) {
+        skip_blanks(ps);
+        if (*ps->p != ',') break;
+        ps->p++;
+        int32_t rhs = parse_assign(ps);
+        if (rhs < 0) return -1;
+        lhs = add_node(ps, N_COMMA, OP_NONE, lhs, rhs, -1, 0);
+    }
+    return lhs;
+}
+
+static void expr_free(ArithExpr* e) {
+    if (!e) return;
+    free(e->nodes);
+    strpool_free(&e->names);
+    free(e);
+}
+
+static ArithExpr* compile(const char* src, const char** error) {
+    ArithExpr* e = calloc(1, sizeof(ArithExpr));
+    if (!e) {
+        *error = "out of memory";
+        return NULL;
+    }
+    strpool_init(&e->names, 64);
+
+    Parser ps = {src, e, NULL, 0};
+    skip_blanks(&ps);
+    if (*ps.p == '\0') {
+        e->root = -1;  // $(( )) is 0
+        return e;
+    }
+
+    e->root = parse_comma(&ps);
+    skip_blanks(&ps);
+    if (!ps.error && *ps.p != '\0') {
+        ps.error = *ps.p == '=' ? "attempted assignment to non-variable"
+                                : "syntax error in expression";
+    }
+    if (ps.error) {
+        *error = ps.error;
+        expr_free(e);
+        return NULL;
+    }
+    return e;
+}
+
+/* ------------------------------------------------------------ */
+/* Evaluation                                                   */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    const ArithExpr* e;
+    const char* error;
+    int depth;
+} Evaluator;
+
+static bool eval_source(const char* src, int64_t* result, const char** error,
+                        int depth);
+
+static bool read_var(Evaluator* ev, const char* name, int64_t* out) {
+    if (vars_get_int(name, out)) return true;
+
+    // unset and empty are 0; anything else is evaluated as an expression
+    const char* value = vars_get(name);
+    if (!value || !*value) {
+        *out = 0;
+        return true;
+    }
+    return eval_source(value, out, &ev->error, ev->depth + 1);
+}
+
+static bool apply_binary(Evaluator* ev, uint8_t op, int64_t a, int64_t b,
+                         int64_t* out) {
+    uint64_t ua = (uint64_t)a, ub = (uint64_t)b;
+    switch (op) {
+        case OP_MUL: *out = (int64_t)(ua * ub); break;
+        case OP_ADD: *out = (int64_t)(ua + ub); break;
+        case OP_SUB: *out = (int64_t)(ua - ub); break;
+        case OP_DIV:
+        case OP_MOD:
+            if (b == 0) {
+                ev->error = "division by zero";
+                return false;
+            }
+            if (b == -1) {  // INT64_MIN / -1 overflows
+                *out = op == OP_DIV ? (int64_t)(0 - ua) : 0;
+            } else {
+                *out = op == OP_DIV ? a / b : a % b;
+            }
+            break;
+        case OP_SHL: *out = (int64_t)(ua << (b & 63)); break;
+        case OP_SHR: *out = a >> (b & 63); break;
+        case OP_LT: *out = a < b; break;
+        case OP_LE: *out = a <= b; break;
+        case OP_GT: *out = a > b; break;
+        case OP_GE: *out = a >= b; break;
+        case OP_EQ: *out = a == b; break;
+        case OP_NE: *out = a != b; break;
+        case OP_BITAND: *out = a & b; break;
+        case OP_BITXOR: *out = a ^ b; break;
+        case OP_BITOR: *out = a | b; break;
+        case OP_POW: {
+            if (b < 0) {
+                ev->error = "exponent less than 0";
+                return false;
+            }
+            uint64_t r = 1;
+            while (b) {
+                if (b & 1) r *= ua;
+                ua *= ua;
+                b >>= 1;
+            }
+            *out = (int64_t)r;
+            break;
+        }
+        default:
+            *out = b;  // plain `=`
+    }
+    return true;
+}
+
+static bool eval(Evaluator* ev, int32_t idx, int64_t* out);
+
+static bool eval_node(Evaluator* ev, int32_t idx, int64_t* out) {
+    const Node* n = &ev->e->nodes[idx];
+    const char* name = "";
+    int64_t a, b;
+
+    if (n->kind == N_VAR || n->kind == N_ASSIGN ||
+        (n->kind >= N_PREINC && n->kind <= N_POSTDEC)) {
+        name = strpool_get(&ev->e->names, (uint32_t)n->value);
+    }
+
+    switch (n->kind) {
+        case N_NUM:
+            *out = n->value;
+            return true;
+        case N_VAR:
+            return read_var(ev, name, out);
+        case N_NEG:
+            if (!eval(ev, n->a, &a)) return false;
+            *out = (int64_t)(0 - (uint64_t)a);
+            return true;
+        case N_NOT:
+            if (!eval(ev, n->a, &a)) return false;
+            *out = !a;
+            return true;
+        case N_BITNOT:
+            if (!eval(ev, n->a, &a)) return false;
+            *out = ~a;
+            return true;
+        case N_PREINC:
+        case N_PREDEC:
+        case N_POSTINC:
+        case N_POSTDEC: {
+            if (!read_var(ev, name, &a)) return false;
+            bool inc = n->kind == N_PREINC || n->kind == N_POSTINC;
+            b = (int64_t)((uint64_t)a + (inc ? 1 : -1));
+            vars_set_int(name, b);
+            *out = n->kind == N_PREINC || n->kind == N_PREDEC ? b : a;
+            return true;
+        }
+        case N_BINARY:
+            if (!eval(ev, n->a, &a) || !eval(ev, n->b, &b)) return false;
+            return apply_binary(ev, n->op, a, b, out);
+        case N_AND:
+            if (!eval(ev, n->a, &a)) return false;
+            if (!a) {
+                *out = 0;
+                return true;
+            }
+            if (!eval(ev, n->b, &b)) return false;
+            *out = b != 0;
+            return true;
+        case N_OR:
+            if (!eval(ev, n->a, &a)) return false;
+            if (a) {
+                *out = 1;
+                return true;
+            }
+            if (!eval(ev, n->b, &b)) return false;
+            *out = b != 0;
+            return true;
+        case N_COND:
+            if (!eval(ev, n->a, &a)) return false;
+            return eval(ev, a ? n->b : n->c, out);
+        case N_ASSIGN:
+            if (!eval(ev, n->a, &b)) return false;
+            a = 0;
+            if (n->op != OP_NONE && !read_var(ev, name, &a)) return false;
+            if (!apply_binary(ev, n->op, a, b, out)) return false;
+            vars_set_int(name, *out);
+            return true;
+        case N_COMMA:
+            if (!eval(ev, n->a, &a)) return false;
+            return eval(ev, n->b, out);
+    }
+    return false;
+}
+
+// Tree depth, across the expressions of variables too: a long `1+1+...`
+// nests to the left without nesting in the parser
+static int eval_depth;
+
+static bool eval(Evaluator* ev, int32_t idx, int64_t* out) {
+    if (eval_depth == ARITH_MAX_NESTING) {
+        ev->error = "expression nested too deeply";
+        return false;
+    }
+    eval_depth++;
+    bool ok = eval_node(ev, idx, out);
+    eval_depth--;
+    return ok;
+}
+
+static bool run(const ArithExpr* e, int64_t* result, const char** error,
+                int depth) {
+    if (e->root < 0) {
+        *result = 0;
+        return true;
+    }
+    Evaluator ev = {e, NULL, depth};
+    if (!eval(&ev, e->root, result)) {
+        *error = ev.error ? ev.error : "invalid expression";
+        return false;
+    }
+    return true;
+}
+
+// Variables holding expressions: compiled on the spot, never cached, so an
+// outer expression's cache slot cannot be replaced while it is evaluated
+static bool eval_source(const char* src, int64_t* result, const char** error,
+                        int depth) {
+    if (depth > ARITH_MAX_DEPTH) {
+        *error = "expression recursion level exceeded";
+        return false;
+    }
+    ArithExpr* e = compile(src, error);
+    if (!e) return false;
+    bool ok = run(e, result, error, depth);
+    expr_free(e);
+    return ok;
+}
+
+/* ------------------------------------------------------------ */
+/* Compiled expression cache                                    */
+/* ------------------------------------------------------------ */
+
+// Direct-mapped by hash of the source text
+static struct {
+    uint64_t hash;
+    char* source;
+    ArithExpr* expr;
+} cache[ARITH_CACHE_SIZE];
+
+static uint64_t hash_source(const char* s) {
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool arith_eval(const char* expr, int64_t* result, const char** error) {
+    uint64_t h = hash_source(expr);
+    size_t slot = h & (ARITH_CACHE_SIZE - 1);
+
+    if (!cache[slot].expr || cache[slot].hash != h ||
+        strcmp(cache[slot].source, expr) != 0) {
+        ArithExpr* e = compile(expr, error);
+        if (!e) return false;
+        char* source = strdup(expr);
+        if (!source) {
+            expr_free(e);
+            return eval_source(expr, result, error, 0);
+        }
+
+        expr_free(cache[slot].expr);
+        free(cache[slot].source);
+        cache[slot].hash = h;
+        cache[slot].source = source;
+        cache[slot].expr = e;
+    }
+    return run(cache[slot].expr, result, error, 0);
+}
@@ -0,0 +1,23 @@
+#ifndef ARITH_H
+#define ARITH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Integer arithmetic for $(( )) and `let`.
+ *
+ * 64-bit signed integers with C operators and precedence, `**`, variables
+ * (bare or as $name / ${name}), assignment operators and ++/--. Overflow
+ * wraps. An expression is compiled once and the compiled form is cached by
+ * its source text, so re-evaluating the same expression (a loop counter)
+ * only walks the compiled tree.
+ */
+
+/*
+ * Evaluate expr into *result. On failure returns false and points *error
+ * at a static message.
+ */
+bool arith_eval(const char* expr, int64_t* result, const char** error);
+
+#endif
@@ -0,0 +1,472 @@
+#define _GNU_SOURCE
+
+#include "expand.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "exec/exec.h"
+#include "expand/arith.h"
+#include "expand/vars.h"
+#include "parse/lexer.h"
+#include "parse/parser.h"
+#include "util/trace.h"
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} Buf;
+
+static bool buf_append(Buf* b, const char* s, size_t n) {
+    if (b->len + n + 1 > b->capacity) {
+        size_t new_capacity = b->capacity ? b->capacity * 2 : 64;
+        while (new_capacity < b->len + n + 1) new_capacity *= 2;
+        char* tmp = realloc(b->data, new_capacity);
+        if (!tmp) return false;
+        b->data = tmp;
+        b->capacity = new_capacity;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+    return true;
+}
+
+static bool append_int(Buf* b, int64_t value) {
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%" PRId64, value);
+    return buf_append(b, num, (size_t)n);
+}
+
+static bool append_var(Buf* b, const char* name, size_t n) {
+    char key[n + 1];
+    memcpy(key, name, n);
+    key[n] = '\0';
+    const char* value = vars_get(key);
+    return !value || buf_append(b, value, strlen(value));
+}
+
+static bool append_param(Buf* b, int i) {
+    const char* value = vars_positional(i);
+    return !value || buf_append(b, value, strlen(value));
+}
+
+// $* and $@ outside "$@" words: the parameters joined by spaces
+static bool append_params(Buf* b) {
+    int count = vars_positional_count();
+    for (int i = 1; i <= count; i++) {
+        if (i > 1 && !buf_append(b, " ", 1)) return false;
+        if (!append_param(b, i)) return false;
+    }
+    return true;
+}
+
+static bool all_digits(const char* s, size_t n) {
+    if (n == 0) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (!isdigit((unsigned char)s[i])) return false;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------ */
+/* Process substitution                                         */
+/* ------------------------------------------------------------ */
+
+// A running <(...) or >(...): its end of the pipe stays open in the shell
+// (and in everything forked meanwhile) until the pipeline is done
+typedef struct {
+    int fd;
+    pid_t pid;
+    unsigned depth;  // expand_pipeline() nesting it belongs to
+} ProcSub;
+
+static ProcSub* procsubs;
+static size_t procsub_count;
+static size_t procsub_capacity;
+static unsigned expand_depth;
+
+// Runs the inner list of a substitution in a forked child. Never returns.
+static void procsub_child(CommandList* list, int fds[2], bool reader) {
+    trace_child_init();
+
+    // other substitutions' ends would keep their pipes from reaching EOF
+    for (size_t i = 0; i < procsub_count; i++) close(procsubs[i].fd);
+    procsub_count = 0;
+    expand_depth = 0;
+
+    int target = reader ? STDIN_FILENO : STDOUT_FILENO;
+    dup2(fds[reader ? 0 : 1], target);
+    close(fds[0]);
+    close(fds[1]);
+    int status = execute_list(list, true);
+    trace_flush();
+    _exit(status);
+}
+
+// Expands the `<(...)` or `>(...)` at p into b as /dev/fd/N. Returns the
+// position after it, or NULL after printing an error.
+static const char* expand_procsub(Buf* b, const char* p, const char* end) {
+    size_t n = lex_procsub_length(p, end);
+    bool reader = p[0] == '>';  // >(cmd) reads what the command writes
+    char text[n - 2];
+    memcpy(text, p + 2, n - 3);
+    text[n - 3] = '\0';
+
+    if (procsub_count == procsub_capacity) {
+        size_t capacity = procsub_capacity ? procsub_capacity * 2 : 8;
+        ProcSub* tmp = realloc(procsubs, sizeof(ProcSub) * capacity);
+        if (!tmp) return NULL;
+        procsubs = tmp;
+        procsub_capacity = capacity;
+    }
+
+    CommandList* list = parse_command_list(text);
+    if (!list) return NULL;
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        perror("pipe");
+        command_list_release(list);
+        return NULL;
+    }
+    pid_t pid = fork();
+    if (pid == 0) procsub_child(list, fds, reader);
+    command_list_release(list);
+
+    int keep = reader ? fds[1] : fds[0];
+    close(reader ? fds[0] : fds[1]);
+    if (pid < 0) {
+        perror("fork");
+        close(keep);
+        return NULL;
+    }
+
+    // the command gets it by path, so it has to survive exec
+    fcntl(keep, F_SETFD, 0);
+    procsubs[procsub_count++] = (ProcSub){keep, pid, expand_depth};
+
+    char path[32];
+    int len = snprintf(path, sizeof(path), "/dev/fd/%d", keep);
+    buf_append(b, path, (size_t)len);
+    return p + n;
+}
+
+// Closes the shell's ends of this expansion's substitutions, then reaps
+// them: readers see EOF, writers still blocked get SIGPIPE
+static void procsub_finish(void) {
+    size_t first = procsub_count;
+    while (first > 0 && procsubs[first - 1].depth == expand_depth) first--;
+
+    for (size_t i = first; i < procsub_count; i++) close(procsubs[i].fd);
+    for (size_t i = first; i < procsub_count; i++) {
+        while (waitpid(procsubs[i].pid, NULL, 0) < 0 && errno == EINTR);
+    }
+    procsub_count = first;
+}
+
+/* ------------------------------------------------------------ */
+/* Single expansions                                            */
+/* ------------------------------------------------------------ */
+
+// ${name[@]} outside a "${name[@]}" word: the elements joined by spaces
+static bool append_elements(Buf* b, const char* name) {
+    size_t count = vars_array_count(name);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && !buf_append(b, " ", 1)) return false;
+        const char* item = vars_array_get(name, i);
+        if (!buf_append(b, item, strlen(item))) return false;
+    }
+    return true;
+}
+
+// The inside of ${...} (s up to close): name, #name, name[index],
+// name[@], #name[@] or #name[index]. An index is an arithmetic
+// expression; negative ones count from the end. False if malformed.
+static bool expand_braced(Buf* b, const char* s, const char* close) {
+    bool length = *s == '#';
+    if (length) s++;
+    const char* bracket = memchr(s, '[', close - s);
+    const char* name_end = bracket ? bracket : close;
+    if (!vars_valid_name(s, name_end - s)) return false;
+
+    char name[name_end - s + 1];
+    memcpy(name, s, name_end - s);
+    name[name_end - s] = '\0';
+
+    if (!bracket) {
+        if (!length) return append_var(b, s, name_end - s);
+        const char* value = vars_get(name);
+        return append_int(b, value ? (int64_t)strlen(value) : 0);
+    }
+    if (close[-1] != ']' || close - 1 == bracket + 1) return false;
+
+    const char* index = bracket + 1;
+    size_t n = close - 1 - index;
+    if (n == 1 && (*index == '@' || *index == '*')) {
+        if (length) return append_int(b, (int64_t)vars_array_count(name));
+        return append_elements(b, name);
+    }
+
+    // ${name[$i + 1]}: the index is expanded before it is evaluated
+    char text[n + 1];
+    memcpy(text, index, n);
+    text[n] = '\0';
+    char* expr = expand_word(text);
+    if (!expr) return false;
+    int64_t i;
+    const char* error;
+    bool ok = arith_eval(expr, &i, &error);
+    if (!ok) fprintf(stderr, "%s: %s\n", expr, error);
+    if (expr != text) free(expr);
+    if (!ok) return false;
+    if (i < 0) i += (int64_t)vars_array_count(name);
+    const char* item = i >= 0 ? vars_array_get(name, (size_t)i) : NULL;
+    if (length) return append_int(b, item ? (int64_t)strlen(item) : 0);
+    return !item || buf_append(b, item, strlen(item));
+}
+
+// Expands the `$...` at p (just past the marker) into b. Returns the
+// position after it, or NULL after printing an error.
+static const char* expand_dollar(Buf* b, const char* p, const char* end) {
+    size_t n = lex_arith_length(p, end);
+    if (n > 0) {
+        char expr[n - 4];  // between "$((" and "))"
+        memcpy(expr, p + 3, n - 5);
+        expr[n - 5] = '\0';
+
+        int64_t value;
+        const char* error;
+        if (!arith_eval(expr, &value, &error)) {
+            fprintf(stderr, "%s: %s\n", expr, error);
+            return NULL;
+        }
+        append_int(b, value);
+        return p + n;
+    }
+
+    const char* q = p + 1;
+    if (*q == '?') {
+        append_int(b, shell_last_status);
+        return q + 1;
+    }
+    if (*q == '$') {
+        append_int(b, getpid());
+        return q + 1;
+    }
+    if (*q == '#') {
+        append_int(b, vars_positional_count());
+        return q + 1;
+    }
+    if (*q == '@' || *q == '*') {
+        append_params(b);
+        return q + 1;
+    }
+    if (isdigit((unsigned char)*q)) {
+        append_param(b, *q - '0');
+        return q + 1;
+    }
+    if (*q == '{') {
+        const char* close = memchr(q, '}', end - q);
+        if (close && all_digits(q + 1, close - q - 1)) {
+            append_param(b, atoi(q + 1));
+            return close + 1;
+        }
+        if (!close || !expand_braced(b, q + 1, close)) {
+            fprintf(stderr, "%.*s: bad substitution\n",
+                    close ? (int)(close - p + 1) : (int)(end - p), p);
+            return NULL;
+        }
+        return close + 1;
+    }
+
+    const char* name_end = q;
+    if (isalpha((unsigned char)*q) || *q == '_') {
+        while (isalnum((unsigned char)*name_end) || *name_end == '_')
+            name_end++;
+    }
+    if (name_end == q) {
+        buf_append(b, "$", 1);  // nothing expandable follows
+        return q;
+    }
+    append_var(b, q, name_end - q);
+    return name_end;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+char* expand_word(const char* word) {
+    const char* mark = strchr(word, EXPAND_MARKER);
+    if (!mark) return (char*)word;
+
+    const char* end = word + strlen(word);
+    Buf b = {0};
+    buf_append(&b, word, mark - word);
+
+    const char* p = mark;
+    while (p) {
+        if (p[1] == '$') {
+            p = expand_dollar(&b, p + 1, end);
+        } else {
+            p = expand_procsub(&b, p + 1, end);
+        }
+        if (!p) {
+            free(b.data);
+            return NULL;
+        }
+        mark = memchr(p, EXPAND_MARKER, end - p);
+        buf_append(&b, p, (mark ? mark : end) - p);
+        p = mark;
+    }
+
+    if (!b.data) return strdup("");
+    return b.data;
+}
+
+// Whether word is one of orig's own (unexpanded) words
+static bool is_parsed_word(const Command* orig, const char* word) {
+    if (word == orig->argv[0]) return true;  // the usual case: the name
+    for (int k = 1; k < orig->argc; k++) {
+        if (word == orig->argv[k]) return true;
+    }
+    return false;
+}
+
+void expand_free(const Pipeline* pl, Command* cmds) {
+    for (size_t i = 0; i < pl->count; i++) {
+        const Command* orig = &pl->cmds[i];
+        Command* c = &cmds[i];
+
+        if (c->argv != orig->argv) {
+            // a splice may have moved the parsed words; only those aren't ours
+            for (int k = 0; k < c->argc; k++) {
+                if (!is_parsed_word(orig, c->argv[k])) free(c->argv[k]);
+            }
+            free(c->argv);
+        }
+        for (int k = 0; k < c->redirc; k++) {
+            if (c->redirections[k].filename != orig->redirections[k].filename)
+                free(c->redirections[k].filename);
+        }
+    }
+
+    procsub_finish();
+    expand_depth--;
+}
+
+/* ------------------------------------------------------------ */
+/* "$@" and "${name[@]}"                                        */
+/* ------------------------------------------------------------ */
+
+#define LIST_NAME_MAX 256
+
+// "$@" or "${name[@]}" as a whole word: one word per element. The array
+// name goes to name, empty for the positional parameters.
+static bool is_list_word(const char* word, char name[LIST_NAME_MAX]) {
+    if (word[0] != EXPAND_MARKER) return false;
+    const char* p = word + 1;
+    if (strcmp(p, "$@") == 0) {
+        name[0] = '\0';
+        return true;
+    }
+
+    size_t n = strlen(p);
+    if (n < 7 || strncmp(p, "${", 2) != 0 || strcmp(p + n - 4, "[@]}") != 0)
+        return false;
+    size_t len = n - 6;
+    if (len >= LIST_NAME_MAX || !vars_valid_name(p + 2, len)) return false;
+    memcpy(name, p + 2, len);
+    name[len] = '\0';
+    return true;
+}
+
+static size_t list_count(const char* name) {
+    return *name ? vars_array_count(name) : (size_t)vars_positional_count();
+}
+
+static const char* list_item(const char* name, size_t i) {
+    return *name ? vars_array_get(name, i) : vars_positional((int)i + 1);
+}
+
+// Replaces each list word of c by its elements
+static bool splice_lists(const Command* orig, Command* c) {
+    char name[LIST_NAME_MAX];
+    size_t argc = 0;
+    for (int k = 0; k < c->argc; k++) {
+        argc += is_list_word(c->argv[k], name) ? list_count(name) : 1;
+    }
+
+    char** argv = malloc(sizeof(char*) * (argc + 1));
+    if (!argv) return false;
+    size_t n = 0;
+    for (int k = 0; k < c->argc; k++) {
+        if (!is_list_word(c->argv[k], name)) {
+            argv[n++] = c->argv[k];
+            continue;
+        }
+        size_t count = list_count(name);
+        for (size_t i = 0; i < count; i++) {
+            argv[n++] = strdup(list_item(name, i));
+        }
+    }
+    argv[n] = NULL;
+
+    if (c->argv != orig->argv) free(c->argv);
+    c->argv = argv;
+    c->argc = (int)argc;
+    return true;
+}
+
+static bool expand_command(const Command* orig, Command* c) {
+    char name[LIST_NAME_MAX];
+    bool lists = false;
+    for (int k = 0; k < c->argc; k++) {
+        if (!strchr(c->argv[k], EXPAND_MARKER)) continue;
+        if (is_list_word(c->argv[k], name)) {
+            lists = true;
+            continue;
+        }
+
+        // first expansion in this command: give it its own argv
+        if (c->argv == orig->argv) {
+            char** argv = malloc(sizeof(char*) * (c->argc + 1));
+            if (!argv) return false;
+            memcpy(argv, c->argv, sizeof(char*) * (c->argc + 1));
+            c->argv = argv;
+        }
+        char* word = expand_word(c->argv[k]);
+        if (!word) return false;
+        c->argv[k] = word;
+    }
+    if (lists && !splice_lists(orig, c)) return false;
+
+    for (int k = 0; k < c->redirc; k++) {
+        char* target = expand_word(c->redirections[k].filename);
+        if (!target) return false;
+        c->redirections[k].filename = target;
+    }
+    return true;
+}
+
+bool expand_pipeline(const Pipeline* pl, Command* cmds) {
+    memcpy(cmds, pl->cmds, sizeof(Command) * pl->count);
+    expand_depth++;
+
+    for (size_t i = 0; i < pl->count; i++) {
+        if (!expand_command(&pl->cmds[i], &cmds[i])) {
+            expand_free(pl, cmds);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef EXPAND_H
+#define EXPAND_H
+
+#include <stdbool.h>
+
+#include "shell.h"
+
+/*
+ * Parameter and arithmetic expansion.
+ *
+ * Runs in the shell process right before a pipeline executes, so side
+ * effects ($((i++))) persist and forked stages receive finished argv.
+ * Only `$` the lexer marked with EXPAND_MARKER are expanded: $name,
+ * ${name}, $?, $$, $((expr)) and the positional parameters $0..$9, ${N},
+ * $#, $* and $@. Results are not field-split or globbed; only a word that
+ * is exactly "$@" becomes one word per parameter.
+ *
+ * <(list) and >(list) start list on a pipe and expand to /dev/fd/N, the
+ * shell's end of it, which stays open across the pipeline's forks and
+ * execs. expand_free() closes it and reaps list.
+ */
+
+/*
+ * Expanded copy of word. Returns word itself when it contains nothing to
+ * expand, a malloc'd string otherwise, or NULL after printing an error.
+ */
+char* expand_word(const char* word);
+
+/*
+ * Fills cmds[0..pl->count) with pl's commands, argv and redirection
+ * targets expanded. Unchanged words are shared with pl. Returns false
+ * after printing an error; cmds then needs no freeing.
+ */
+bool expand_pipeline(const Pipeline* pl, Command* cmds);
+
+/* Releases what expand_pipeline() allocated for cmds */
+void expand_free(const Pipeline* pl, Command* cmds);
+
+#endif
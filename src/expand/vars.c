@@ -0,0 +1,288 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "vars.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds/hashmap.h"
+
+typedef struct {
+    char* value;       // formatted lazily when only the integer is current
+    size_t value_cap;
+    int64_t ivalue;
+    bool is_int;       // ivalue holds the value
+    bool str_current;  // value holds the value
+    char** items;      // array elements, NULL for a scalar
+    size_t item_count;
+    char* storage;     // the block items point into
+} var_entry;
+
+// name -> var_entry*
+static HashMap store;
+
+typedef struct {
+    char* name;
+    var_entry* shadowed;  // the caller's entry, NULL if it had none
+} local_var;
+
+typedef struct {
+    int count;  // positional parameters
+    char* const* params;
+    local_var* locals;
+    size_t local_count;
+    size_t local_capacity;
+} scope;
+
+static const char* arg0 = "shell";
+static scope global_scope;
+static scope* scopes;  // function calls, innermost last
+static size_t scope_count;
+static size_t scope_capacity;
+
+static scope* current_scope(void) {
+    return scope_count ? &scopes[scope_count - 1] : &global_scope;
+}
+
+static void drop_array(var_entry* e) {
+    free(e->items);
+    free(e->storage);
+    e->items = NULL;
+    e->item_count = 0;
+    e->storage = NULL;
+}
+
+static void free_entry(var_entry* e) {
+    if (!e) return;
+    drop_array(e);
+    free(e->value);
+    free(e);
+}
+
+static var_entry* find_entry(const char* name) {
+    void* e;
+    return hashmap_get(&store, name, &e) ? e : NULL;
+}
+
+static var_entry* get_or_create(const char* name) {
+    var_entry* e = find_entry(name);
+    if (e) return e;
+
+    e = calloc(1, sizeof(var_entry));
+    if (!e || !hashmap_put(&store, name, e, NULL)) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+static bool store_string(var_entry* e, const char* s, size_t n) {
+    if (n + 1 > e->value_cap) {
+        size_t cap = e->value_cap ? e->value_cap : 16;
+        while (cap < n + 1) cap *= 2;
+        char* tmp = realloc(e->value, cap);
+        if (!tmp) return false;
+        e->value = tmp;
+        e->value_cap = cap;
+    }
+    memcpy(e->value, s, n);
+    e->value[n] = '\0';
+    e->str_current = true;
+    return true;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+bool vars_valid_name(const char* s, size_t n) {
+    if (n == 0 || isdigit((unsigned char)s[0])) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (!isalnum((unsigned char)s[i]) && s[i] != '_') return false;
+    }
+    return true;
+}
+
+bool vars_parse_int(const char* s, int64_t* value) {
+    while (*s == ' ' || *s == '\t') s++;
+    if (!*s) return false;
+
+    char* end;
+    errno = 0;
+    long long v = strtoll(s, &end, 0);
+    if (end == s || errno == ERANGE) return false;
+    while (*end == ' ' || *end == '\t') end++;
+    if (*end) return false;
+
+    *value = v;
+    return true;
+}
+
+const char* vars_get(const char* name) {
+    var_entry* e = find_entry(name);
+    if (!e) return getenv(name);
+
+    if (!e->str_current) {
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%" PRId64, e->ivalue);
+        if (!store_string(e, buf, (size_t)n)) return "";
+    }
+    return e->value;
+}
+
+bool vars_get_int(const char* name, int64_t* value) {
+    var_entry* e = find_entry(name);
+    if (!e) {
+        const char* env = getenv(name);
+        return env && vars_parse_int(env, value);
+    }
+    if (e->is_int) {
+        *value = e->ivalue;
+        return true;
+    }
+    return false;
+}
+
+bool vars_set(const char* name, const char* value) {
+    var_entry* e = get_or_create(name);
+    if (!e || !store_string(e, value, strlen(value))) return false;
+    drop_array(e);
+    e->is_int = vars_parse_int(value, &e->ivalue);
+    return true;
+}
+
+bool vars_set_int(const char* name, int64_t value) {
+    var_entry* e = get_or_create(name);
+    if (!e) return false;
+    drop_array(e);
+    e->ivalue = value;
+    e->is_int = true;
+    e->str_current = false;
+    return true;
+}
+
+void vars_unset(const char* name) {
+    void* e;
+    if (hashmap_remove(&store, name, &e)) free_entry(e);
+}
+
+/* ------------------------------------------------------------ */
+/* Arrays                                                       */
+/* ------------------------------------------------------------ */
+
+bool vars_set_array(const char* name, char** items, size_t count,
+                    char* storage) {
+    var_entry* e = get_or_create(name);
+    const char* first = count ? items[0] : "";
+    if (!e || !store_string(e, first, strlen(first))) {
+        free(items);
+        free(storage);
+        return false;
+    }
+    drop_array(e);
+    e->items = items;
+    e->item_count = count;
+    e->storage = storage;
+    e->is_int = vars_parse_int(first, &e->ivalue);
+    return true;
+}
+
+const char* vars_array_get(const char* name, size_t i) {
+    var_entry* e = find_entry(name);
+    if (e && e->items) return i < e->item_count ? e->items[i] : NULL;
+    return i == 0 ? vars_get(name) : NULL;
+}
+
+size_t vars_array_count(const char* name) {
+    var_entry* e = find_entry(name);
+    if (e && e->items) return e->item_count;
+    return vars_get(name) ? 1 : 0;
+}
+
+/* ------------------------------------------------------------ */
+/* Positional parameters and scopes                             */
+/* ------------------------------------------------------------ */
+
+void vars_set_arg0(const char* name) { arg0 = name; }
+
+void vars_set_positional(int count, char* const* params) {
+    scope* sc = current_scope();
+    sc->count = count;
+    sc->params = params;
+}
+
+const char* vars_positional(int i) {
+    if (i == 0) return arg0;
+    const scope* sc = current_scope();
+    return i > 0 && i <= sc->count ? sc->params[i - 1] : NULL;
+}
+
+int vars_positional_count(void) { return current_scope()->count; }
+
+bool vars_push_scope(int count, char* const* params) {
+    if (scope_count == scope_capacity) {
+        size_t capacity = scope_capacity ? scope_capacity * 2 : 16;
+        scope* tmp = realloc(scopes, sizeof(scope) * capacity);
+        if (!tmp) return false;
+        scopes = tmp;
+        scope_capacity = capacity;
+    }
+    scopes[scope_count++] = (scope){.count = count, .params = params};
+    return true;
+}
+
+void vars_pop_scope(void) {
+    if (scope_count == 0) return;
+    scope* sc = &scopes[--scope_count];
+
+    // newest first, so the caller's entries come back as they were
+    for (size_t i = sc->local_count; i-- > 0;) {
+        local_var* l = &sc->locals[i];
+        void* own = NULL;
+        if (l->shadowed) {
+            hashmap_get(&store, l->name, &own);
+            hashmap_put(&store, l->name, l->shadowed, NULL);
+        } else {
+            hashmap_remove(&store, l->name, &own);
+        }
+        free_entry(own);
+        free(l->name);
+    }
+    free(sc->locals);
+}
+
+bool vars_make_local(const char* name) {
+    if (scope_count == 0) return false;
+    scope* sc = &scopes[scope_count - 1];
+    for (size_t i = 0; i < sc->local_count; i++) {
+        if (strcmp(sc->locals[i].name, name) == 0) return true;
+    }
+
+    if (sc->local_count == sc->local_capacity) {
+        size_t capacity = sc->local_capacity ? sc->local_capacity * 2 : 4;
+        local_var* tmp = realloc(sc->locals, sizeof(local_var) * capacity);
+        if (!tmp) return false;
+        sc->locals = tmp;
+        sc->local_capacity = capacity;
+    }
+
+    var_entry* e = calloc(1, sizeof(var_entry));
+    char* copy = strdup(name);
+    if (!e || !copy || !store_string(e, "", 0)) {
+        free_entry(e);
+        free(copy);
+        return false;
+    }
+    var_entry* shadowed = find_entry(name);
+    if (!hashmap_put(&store, name, e, NULL)) {
+        free_entry(e);
+        free(copy);
+        return false;
+    }
+    sc->locals[sc->local_count++] = (local_var){copy, shadowed};
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef VARS_H
+#define VARS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Shell variables.
+ *
+ * Values are strings; variables last assigned by arithmetic also keep
+ * their integer value so `$(( i + 1 ))` in a loop does not re-parse it.
+ * Lookups of names that were never assigned fall back to the environment.
+ */
+
+/* Value of name, or NULL if it is unset */
+const char* vars_get(const char* name);
+
+/* Integer value of name if it holds a plain integer */
+bool vars_get_int(const char* name, int64_t* value);
+
+/* Setting a scalar replaces an array of the same name */
+bool vars_set(const char* name, const char* value);
+bool vars_set_int(const char* name, int64_t value);
+
+/* Forgets name (a local one until its function returns) */
+void vars_unset(const char* name);
+
+/*
+ * Indexed arrays (`mapfile`, `${name[i]}`).
+ *
+ * An array is count strings that all point into one storage block, so a
+ * million-element array is two allocations. $name is its first element; a
+ * scalar reads as an array of one.
+ */
+
+/*
+ * Makes name an array of items[0..count). Takes ownership of items and of
+ * storage, which holds the strings (freed together with the array).
+ */
+bool vars_set_array(const char* name, char** items, size_t count,
+                    char* storage);
+
+/* Element i of name, or NULL when out of range or unset */
+const char* vars_array_get(const char* name, size_t i);
+
+/* ${#name[@]} */
+size_t vars_array_count(const char* name);
+
+/*
+ * Positional parameters and function scopes.
+ *
+ * A function call pushes a scope holding its arguments as $1..$n (the
+ * strings must outlive the scope). `local` variables shadow the caller's
+ * until the scope is popped, so scoping is dynamic as in other shells.
+ */
+
+/* $0 */
+void vars_set_arg0(const char* name);
+
+/* Replaces $1..$count of the current scope */
+void vars_set_positional(int count, char* const* params);
+
+/* $i (i = 0 is $0), or NULL when i > $# */
+const char* vars_positional(int i);
+
+/* $# */
+int vars_positional_count(void);
+
+bool vars_push_scope(int count, char* const* params);
+void vars_pop_scope(void);
+
+/* Makes name local to the current scope, unset; false at top level */
+bool vars_make_local(const char* name);
+
+/* Whether s[0..n) is a valid variable name */
+bool vars_valid_name(const char* s, size_t n);
+
+/*
+ * Parses a whole string as an integer (decimal, 0x hex or 0 octal, with
+ * optional sign and surrounding blanks). Empty strings are not integers.
+ */
+bool vars_parse_int(const char* s, int64_t* value);
+
+#endif
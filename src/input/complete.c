@@ -0,0 +1,170 @@
+#define _GNU_SOURCE
+
+#include "complete.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "builtin/builtin.h"
+#include "util/dircache.h"
+#include "util/scanners.h"
+
+static void add(Completions* c, const char* text, size_t len, bool is_dir) {
+    if (c->count == c->capacity) {
+        size_t capacity = c->capacity ? c->capacity * 2 : 32;
+        Completion* tmp = realloc(c->items, sizeof(Completion) * capacity);
+        if (!tmp) return;
+        c->items = tmp;
+        c->capacity = capacity;
+    }
+    c->items[c->count++] = (Completion){text, len, is_dir};
+}
+
+static bool has_prefix(const char* s, size_t len, const char* prefix,
+                       size_t prefix_len) {
+    return len >= prefix_len && memcmp(s, prefix, prefix_len) == 0;
+}
+
+// hidden entries only when explicitly asked for
+static bool shown(const char* name, const char* base) {
+    return name[0] != '.' || base[0] == '.';
+}
+
+/* ------------------------------------------------------------ */
+/* Sources                                                      */
+/* ------------------------------------------------------------ */
+
+static void add_builtins(Completions* c, const char* word, size_t len) {
+    const char* name;
+    for (size_t i = 0; (name = builtin_name_at(i)); i++) {
+        size_t n = strlen(name);
+        if (has_prefix(name, n, word, len)) add(c, name, n, false);
+    }
+}
+
+static void add_path_commands(Completions* c, const char* word, size_t len) {
+    const StringList* cache = get_path_cache();
+    for (size_t i = 0; i < cache->count; i++) {
+        size_t n = list_length(cache, i);
+        const char* name = list_get(cache, i);
+        if (has_prefix(name, n, word, len)) add(c, name, n, false);
+    }
+}
+
+// Executables and directories, from the cached listing of dir
+static void add_listing(Completions* c, const char* dir, const char* base,
+                        size_t base_len) {
+    const DirListing* listing = dircache_get(dir);
+    if (!listing) return;
+    for (size_t i = 0; i < listing->names.count; i++) {
+        size_t n = list_length(&listing->names, i);
+        const char* name = list_get(&listing->names, i);
+        if (shown(name, base) && has_prefix(name, n, base, base_len)) {
+            add(c, name, n, listing->is_dir[i]);
+        }
+    }
+}
+
+// Any file in dir. The names are copied into c->names; the pool may
+// still move while it grows, so candidates are added once it is done.
+static void add_files(Completions* c, const char* dir, const char* base,
+                      size_t base_len) {
+    int dfd = open(*dir ? dir : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* d = dfd >= 0 ? fdopendir(dfd) : NULL;
+    if (!d) {
+        if (dfd >= 0) close(dfd);
+        return;
+    }
+
+    list_init(&c->names, 0);
+    bool* is_dir = NULL;
+    size_t dirs_capacity = 0;
+    struct dirent* e;
+    while ((e = readdir(d))) {
+        const char* name = e->d_name;
+        size_t n = strlen(name);
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+        if (!shown(name, base) || !has_prefix(name, n, base, base_len)) {
+            continue;
+        }
+
+        bool dir_entry = e->d_type == DT_DIR;
+        if (e->d_type == DT_LNK || e->d_type == DT_UNKNOWN) {
+            struct stat st;
+            dir_entry = fstatat(dfd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (c->names.count == dirs_capacity) {
+            dirs_capacity = dirs_capacity ? dirs_capacity * 2 : 32;
+            bool* tmp = realloc(is_dir, sizeof(bool) * dirs_capacity);
+            if (!tmp) break;
+            is_dir = tmp;
+        }
+        is_dir[c->names.count] = dir_entry;
+        list_append(&c->names, name);
+    }
+    closedir(d);
+
+    for (size_t i = 0; i < c->names.count; i++) {
+        add(c, list_get(&c->names, i), list_length(&c->names, i), is_dir[i]);
+    }
+    free(is_dir);
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+static int compare(const void* a, const void* b) {
+    const Completion* x = a;
+    const Completion* y = b;
+    int r = memcmp(x->text, y->text, x->len < y->len ? x->len : y->len);
+    return r ? r : (x->len > y->len) - (x->len < y->len);
+}
+
+void complete_word(const char* word, size_t len, bool command,
+                   Completions* out) {
+    completions_free(out);
+
+    size_t keep = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (word[i] == '/') keep = i + 1;
+    }
+    out->keep = keep;
+
+    char dir[keep + 1];
+    memcpy(dir, word, keep);
+    dir[keep] = '\0';
+    char base[len - keep + 1];
+    memcpy(base, word + keep, len - keep);
+    base[len - keep] = '\0';
+
+    if (!command) {
+        add_files(out, dir, base, len - keep);
+    } else {
+        if (keep == 0) {
+            add_builtins(out, word, len);
+            add_path_commands(out, word, len);
+        }
+        add_listing(out, dir, base, len - keep);
+    }
+    if (out->count == 0) return;
+
+    qsort(out->items, out->count, sizeof(Completion), compare);
+    size_t n = 1;
+    for (size_t i = 1; i < out->count; i++) {
+        if (compare(&out->items[i], &out->items[n - 1]) != 0) {
+            out->items[n++] = out->items[i];
+        }
+    }
+    out->count = n;
+}
+
+void completions_free(Completions* c) {
+    free(c->items);
+    free_string_list(&c->names);
+    *c = (Completions){0};
+}
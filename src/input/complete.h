@@ -0,0 +1,43 @@
+#ifndef COMPLETE_H
+#define COMPLETE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "shell.h"
+
+/*
+ * Tab completion candidates, shared by both line editors.
+ *
+ * Candidates are ranges into storage that already exists (the builtin
+ * table, the PATH cache's string pool, a cached directory listing), so
+ * collecting them copies nothing; only argument completion, which lists
+ * a directory directly, owns its names. A candidate replaces the word
+ * after its first `keep` bytes, the directory part ("src/ex" keeps "src/").
+ */
+
+typedef struct {
+    const char* text;  // not NUL-terminated
+    size_t len;
+    bool is_dir;  // completes with '/' rather than a space
+} Completion;
+
+typedef struct {
+    Completion* items;  // sorted, no duplicates
+    size_t count;
+    size_t capacity;
+    size_t keep;
+    StringList names;  // owned names behind argument candidates
+} Completions;
+
+/*
+ * Candidates for the word[0..len) prefix: builtins, PATH commands and
+ * executables below the cwd in command position, any file otherwise.
+ * The ranges stay valid until completions_free() or the next call.
+ */
+void complete_word(const char* word, size_t len, bool command,
+                   Completions* out);
+
+void completions_free(Completions* c);
+
+#endif
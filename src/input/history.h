@@ -0,0 +1,33 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+
+/*
+ * Command history, kept by whichever line editor the shell was built with
+ * (history_readline.c or history_editor.c). The file format is one line
+ * per entry in both, so a history file survives switching between them.
+ * A NULL path means ~/.history.
+ */
+
+void hist_add(const char* line);
+
+size_t hist_count(void);
+
+/* Entry i, oldest first; NULL past the end */
+const char* hist_get(size_t i);
+
+/* Number shown for entry 0 by `history` */
+int hist_base(void);
+
+/* Text bytes held */
+size_t hist_bytes(void);
+
+/* These return 0 or an errno value */
+int hist_read(const char* path);
+int hist_write(const char* path);
+
+/* Appends the last n entries to path */
+int hist_append(const char* path, size_t n);
+
+#endif
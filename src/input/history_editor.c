@@ -0,0 +1,96 @@
+#define _GNU_SOURCE
+
+#include "history.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIST_DEFAULT_FILE ".history"
+
+static struct {
+    char** lines;
+    size_t count;
+    size_t capacity;
+    size_t bytes;
+} history;
+
+// The file to use for path; the caller frees it
+static char* file_name(const char* path) {
+    if (path) return strdup(path);
+    const char* home = getenv("HOME");
+    char* name;
+    if (asprintf(&name, "%s/" HIST_DEFAULT_FILE, home ? home : ".") < 0) {
+        return NULL;
+    }
+    return name;
+}
+
+static FILE* open_file(const char* path, const char* mode) {
+    char* name = file_name(path);
+    if (!name) return NULL;
+    FILE* f = fopen(name, mode);
+    free(name);
+    return f;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+void hist_add(const char* line) {
+    if (history.count == history.capacity) {
+        size_t capacity = history.capacity ? history.capacity * 2 : 256;
+        char** tmp = realloc(history.lines, sizeof(char*) * capacity);
+        if (!tmp) return;
+        history.lines = tmp;
+        history.capacity = capacity;
+    }
+    char* copy = strdup(line);
+    if (!copy) return;
+    history.lines[history.count++] = copy;
+    history.bytes += strlen(line);
+}
+
+size_t hist_count(void) { return history.count; }
+
+const char* hist_get(size_t i) {
+    return i < history.count ? history.lines[i] : NULL;
+}
+
+int hist_base(void) { return 1; }
+
+size_t hist_bytes(void) { return history.bytes; }
+
+int hist_read(const char* path) {
+    FILE* f = open_file(path, "re");
+    if (!f) return errno;
+
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t n;
+    while ((n = getline(&line, &capacity, f)) >= 0) {
+        if (n > 0 && line[n - 1] == '\n') line[n - 1] = '\0';
+        hist_add(line);
+    }
+    free(line);
+    fclose(f);
+    return 0;
+}
+
+static int write_entries(const char* path, const char* mode, size_t first) {
+    FILE* f = open_file(path, mode);
+    if (!f) return errno;
+    for (size_t i = first; i < history.count; i++) {
+        fputs(history.lines[i], f);
+        fputc('\n', f);
+    }
+    return fclose(f) == 0 ? 0 : errno;
+}
+
+int hist_write(const char* path) { return write_entries(path, "we", 0); }
+
+int hist_append(const char* path, size_t n) {
+    return write_entries(path, "ae", n < history.count ? history.count - n : 0);
+}
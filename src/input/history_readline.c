@@ -0,0 +1,25 @@
+#include "history.h"
+
+#include <readline/history.h>
+
+void hist_add(const char* line) { add_history(line); }
+
+size_t hist_count(void) { return history_length; }
+
+const char* hist_get(size_t i) {
+    HIST_ENTRY** list = history_list();
+    if (!list || i >= (size_t)history_length || !list[i]) return NULL;
+    return list[i]->line;
+}
+
+int hist_base(void) { return history_base; }
+
+size_t hist_bytes(void) { return history_total_bytes(); }
+
+int hist_read(const char* path) { return read_history(path); }
+
+int hist_write(const char* path) { return write_history(path); }
+
+int hist_append(const char* path, size_t n) {
+    return append_history((int)n, path);
+}
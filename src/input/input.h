@@ -1,7 +1,8 @@
 #ifndef INPUT_H
 #define INPUT_H
-// done with GNU Readline library for the moment
+// GNU Readline (input_readline.c), or the built-in editor (input_editor.c)
+// when configured with -DSHELL_LINE_EDITOR=ON
 char* read_command_line(void);
 void readline_init();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,630 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "input.h"
+#include "input/complete.h"
+#include "input/history.h"
+
+/*
+ * A small line editor for interactive use without GNU Readline.
+ *
+ * The terminal is in raw mode only while a line is being edited. Each key
+ * produces at most one write(): typing or erasing at the end of the line
+ * and moving the cursor by one character send just those few bytes, and
+ * anything else redraws the single line from the prompt. A line wider
+ * than the terminal scrolls horizontally. UTF-8 sequences move and erase
+ * as one column; wide characters are not measured.
+ *
+ * Keys: arrows, Home/End, Delete, Backspace, Ctrl-A/E/B/F/D/H/K/U/W/L/C,
+ * Ctrl-P/N and Up/Down for history, Alt-B/F by word, Tab to complete
+ * (twice to list the candidates).
+ */
+
+#define EDITOR_PROMPT "$ "
+#define EDITOR_PROMPT_COLS 2
+#define EDITOR_LIST_ASK 100  // list more candidates only when asked
+
+enum {
+    KEY_CTRL_A = 1,
+    KEY_CTRL_B = 2,
+    KEY_CTRL_C = 3,
+    KEY_CTRL_D = 4,
+    KEY_CTRL_E = 5,
+    KEY_CTRL_F = 6,
+    KEY_CTRL_H = 8,
+    KEY_TAB = 9,
+    KEY_CTRL_K = 11,
+    KEY_CTRL_L = 12,
+    KEY_ENTER = 13,
+    KEY_CTRL_N = 14,
+    KEY_CTRL_P = 16,
+    KEY_CTRL_U = 21,
+    KEY_CTRL_W = 23,
+    KEY_ESC = 27,
+    KEY_BACKSPACE = 127,
+
+    // decoded escape sequences
+    KEY_UP = 256,
+    KEY_DOWN,
+    KEY_LEFT,
+    KEY_RIGHT,
+    KEY_HOME,
+    KEY_END,
+    KEY_DELETE,
+    KEY_WORD_LEFT,
+    KEY_WORD_RIGHT,
+    KEY_IGNORED,
+};
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} Text;
+
+typedef struct {
+    Text line;
+    size_t pos;     // cursor, a byte offset into line
+    size_t offset;  // first byte on screen when the line scrolls
+    size_t cols;
+    size_t hist_index;  // entry shown; hist_count() for the new line
+    char* draft;        // the new line while browsing history
+    bool listed;        // the last key was a Tab that completed nothing
+    Text out;           // pending terminal output
+} Editor;
+
+static struct termios cooked;
+
+/* ------------------------------------------------------------ */
+/* Text                                                         */
+/* ------------------------------------------------------------ */
+
+// Room for extra more bytes and the terminator
+static bool text_reserve(Text* t, size_t extra) {
+    if (t->len + extra + 1 <= t->capacity) return true;
+    size_t capacity = t->capacity ? t->capacity * 2 : 256;
+    while (capacity < t->len + extra + 1) capacity *= 2;
+    char* data = realloc(t->data, capacity);
+    if (!data) return false;
+    if (!t->data) data[0] = '\0';
+    t->data = data;
+    t->capacity = capacity;
+    return true;
+}
+
+static void text_insert(Text* t, size_t at, const char* s, size_t n) {
+    if (!text_reserve(t, n)) return;
+    memmove(t->data + at + n, t->data + at, t->len - at);
+    memcpy(t->data + at, s, n);
+    t->len += n;
+    t->data[t->len] = '\0';
+}
+
+static void text_erase(Text* t, size_t at, size_t n) {
+    memmove(t->data + at, t->data + at + n, t->len - at - n);
+    t->len -= n;
+    t->data[t->len] = '\0';
+}
+
+static void text_set(Text* t, const char* s) {
+    t->len = 0;
+    text_insert(t, 0, s, strlen(s));
+}
+
+static void emit(Editor* ed, const char* s, size_t n) {
+    text_insert(&ed->out, ed->out.len, s, n);
+}
+
+static void emits(Editor* ed, const char* s) { emit(ed, s, strlen(s)); }
+
+static void flush(Editor* ed) {
+    size_t done = 0;
+    while (done < ed->out.len) {
+        ssize_t n = write(STDOUT_FILENO, ed->out.data + done,
+                          ed->out.len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    ed->out.len = 0;
+}
+
+/* ------------------------------------------------------------ */
+/* UTF-8                                                        */
+/* ------------------------------------------------------------ */
+
+static bool is_continuation(char c) {
+    return ((unsigned char)c & 0xC0) == 0x80;
+}
+
+static size_t prev_char(const Text* t, size_t pos) {
+    if (pos > 0) pos--;
+    while (pos > 0 && is_continuation(t->data[pos])) pos--;
+    return pos;
+}
+
+static size_t next_char(const Text* t, size_t pos) {
+    if (pos < t->len) pos++;
+    while (pos < t->len && is_continuation(t->data[pos])) pos++;
+    return pos;
+}
+
+static size_t columns(const char* s, size_t n) {
+    size_t cols = 0;
+    for (size_t i = 0; i < n; i++) cols += !is_continuation(s[i]);
+    return cols;
+}
+
+/* ------------------------------------------------------------ */
+/* Terminal                                                     */
+/* ------------------------------------------------------------ */
+
+static bool raw_mode(void) {
+    if (tcgetattr(STDIN_FILENO, &cooked) != 0) return false;
+    struct termios raw = cooked;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    return tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == 0;
+}
+
+static void cooked_mode(void) { tcsetattr(STDIN_FILENO, TCSAFLUSH, &cooked); }
+
+static size_t terminal_columns(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_col == 0) {
+        return 80;
+    }
+    return ws.ws_col;
+}
+
+static int read_byte(void) {
+    unsigned char c;
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, &c, 1);
+    } while (n < 0 && errno == EINTR);
+    return n == 1 ? c : -1;
+}
+
+// One key: a byte, or an escape sequence decoded to KEY_*
+static int read_key(void) {
+    int c = read_byte();
+    if (c != KEY_ESC) return c;
+
+    int next = read_byte();
+    if (next == 'b' || next == 'B') return KEY_WORD_LEFT;
+    if (next == 'f' || next == 'F') return KEY_WORD_RIGHT;
+    if (next == 'O') {
+        switch (read_byte()) {
+            case 'H': return KEY_HOME;
+            case 'F': return KEY_END;
+            default: return KEY_IGNORED;
+        }
+    }
+    if (next != '[') return next < 0 ? -1 : KEY_IGNORED;
+
+    // CSI: parameters, then a final byte in @..~
+    int param = 0;
+    int final;
+    while ((final = read_byte()) >= '0' && final <= ';') {
+        if (final >= '0' && final <= '9') param = param * 10 + final - '0';
+    }
+    switch (final) {
+        case 'A': return KEY_UP;
+        case 'B': return KEY_DOWN;
+        case 'C': return KEY_RIGHT;
+        case 'D': return KEY_LEFT;
+        case 'H': return KEY_HOME;
+        case 'F': return KEY_END;
+        case '~':
+            switch (param) {
+                case 1: case 7: return KEY_HOME;
+                case 4: case 8: return KEY_END;
+                case 3: return KEY_DELETE;
+            }
+    }
+    return final < 0 ? -1 : KEY_IGNORED;
+}
+
+/* ------------------------------------------------------------ */
+/* Drawing                                                      */
+/* ------------------------------------------------------------ */
+
+// Room for the line: the last column stays free for the cursor
+static size_t line_room(const Editor* ed) {
+    return ed->cols > EDITOR_PROMPT_COLS + 1
+               ? ed->cols - EDITOR_PROMPT_COLS - 1
+               : 1;
+}
+
+// Whether the whole line fits without scrolling
+static bool fits(const Editor* ed) {
+    return columns(ed->line.data, ed->line.len) <= line_room(ed);
+}
+
+static void refresh(Editor* ed) {
+    ed->cols = terminal_columns();
+    const Text* t = &ed->line;
+    size_t room = line_room(ed);
+
+    // scroll just enough to keep the cursor on screen
+    if (fits(ed)) {
+        ed->offset = 0;
+    } else if (ed->pos < ed->offset) {
+        ed->offset = ed->pos;
+    }
+    while (columns(t->data + ed->offset, ed->pos - ed->offset) > room) {
+        ed->offset = next_char(t, ed->offset);
+    }
+    size_t end = ed->offset, shown = 0;
+    while (end < t->len && shown < room) {
+        end = next_char(t, end);
+        shown++;
+    }
+
+    emits(ed, "\r" EDITOR_PROMPT);
+    emit(ed, t->data + ed->offset, end - ed->offset);
+    emits(ed, "\x1b[K\r");
+    size_t cursor = EDITOR_PROMPT_COLS +
+                    columns(t->data + ed->offset, ed->pos - ed->offset);
+    char move[32];
+    snprintf(move, sizeof(move), "\x1b[%zuC", cursor);
+    emits(ed, move);
+}
+
+/* ------------------------------------------------------------ */
+/* Editing                                                      */
+/* ------------------------------------------------------------ */
+
+static void insert(Editor* ed, const char* s, size_t n) {
+    bool at_end = ed->pos == ed->line.len;
+    text_insert(&ed->line, ed->pos, s, n);
+    ed->pos += n;
+    if (at_end && ed->offset == 0 && fits(ed)) {
+        emit(ed, s, n);
+    } else {
+        refresh(ed);
+    }
+}
+
+static void erase(Editor* ed, size_t from, size_t to) {
+    bool at_end = to == ed->line.len && ed->pos == to;
+    size_t cols = columns(ed->line.data + from, to - from);
+    text_erase(&ed->line, from, to - from);
+    ed->pos = from;
+    if (at_end && ed->offset == 0 && fits(ed)) {
+        char move[32];
+        snprintf(move, sizeof(move), "\x1b[%zuD\x1b[K", cols);
+        if (cols > 0) emits(ed, move);
+    } else {
+        refresh(ed);
+    }
+}
+
+static void move_to(Editor* ed, size_t pos) {
+    size_t old = ed->pos;
+    ed->pos = pos;
+    if (ed->offset != 0 || !fits(ed)) {
+        refresh(ed);
+    } else if (pos < old) {
+        char move[32];
+        snprintf(move, sizeof(move), "\x1b[%zuD",
+                 columns(ed->line.data + pos, old - pos));
+        emits(ed, move);
+    } else if (pos > old) {
+        emit(ed, ed->line.data + old, pos - old);  // retype to move right
+    }
+}
+
+static bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+static size_t word_left(const Editor* ed) {
+    size_t pos = ed->pos;
+    while (pos > 0 && is_blank(ed->line.data[pos - 1])) pos--;
+    while (pos > 0 && !is_blank(ed->line.data[pos - 1])) pos--;
+    return pos;
+}
+
+static size_t word_right(const Editor* ed) {
+    size_t pos = ed->pos;
+    while (pos < ed->line.len && is_blank(ed->line.data[pos])) pos++;
+    while (pos < ed->line.len && !is_blank(ed->line.data[pos])) pos++;
+    return pos;
+}
+
+static void show_history(Editor* ed, size_t index) {
+    size_t count = hist_count();
+    if (index > count) {
+        emits(ed, "\a");
+        return;
+    }
+    if (ed->hist_index == count) {
+        free(ed->draft);
+        ed->draft = strdup(ed->line.data);
+    }
+    ed->hist_index = index;
+    const char* text = index == count ? ed->draft : hist_get(index);
+    text_set(&ed->line, text ? text : "");
+    ed->pos = ed->line.len;
+    refresh(ed);
+}
+
+/* ------------------------------------------------------------ */
+/* Completion                                                   */
+/* ------------------------------------------------------------ */
+
+static bool ends_word(char c) {
+    return is_blank(c) || strchr("|;&<>(){}", c);
+}
+
+static void list_candidates(Editor* ed, const Completions* c) {
+    emits(ed, "\r\n");
+    if (c->count > EDITOR_LIST_ASK) {
+        char ask[64];
+        snprintf(ask, sizeof(ask), "Display all %zu possibilities? (y or n)",
+                 c->count);
+        emits(ed, ask);
+        flush(ed);
+        int key = read_key();
+        emits(ed, "\r\n");
+        if (key != 'y' && key != 'Y') {
+            refresh(ed);
+            return;
+        }
+    }
+
+    size_t width = 0;
+    for (size_t i = 0; i < c->count; i++) {
+        size_t w = columns(c->items[i].text, c->items[i].len) +
+                   c->items[i].is_dir;
+        if (w > width) width = w;
+    }
+    width += 2;
+    size_t per_row = ed->cols / width ? ed->cols / width : 1;
+    size_t rows = (c->count + per_row - 1) / per_row;
+
+    // down the columns, as ls does
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t k = r; k < c->count; k += rows) {
+            const Completion* item = &c->items[k];
+            emit(ed, item->text, item->len);
+            if (item->is_dir) emits(ed, "/");
+            if (k + rows >= c->count) break;
+            size_t pad = width - columns(item->text, item->len) - item->is_dir;
+            for (size_t p = 0; p < pad; p++) emits(ed, " ");
+        }
+        emits(ed, "\r\n");
+    }
+    refresh(ed);
+}
+
+static void complete(Editor* ed) {
+    const char* data = ed->line.data;
+    size_t start = ed->pos;
+    while (start > 0 && !ends_word(data[start - 1])) start--;
+
+    // command position: first on the line or after an operator
+    size_t before = start;
+    while (before > 0 && is_blank(data[before - 1])) before--;
+    bool command = before == 0 || strchr("|;&({", data[before - 1]);
+
+    Completions c = {0};
+    complete_word(data + start, ed->pos - start, command, &c);
+    if (c.count == 0) {
+        emits(ed, "\a");
+        completions_free(&c);
+        return;
+    }
+
+    // the longest prefix all candidates share
+    size_t common = c.items[0].len;
+    for (size_t i = 1; i < c.count; i++) {
+        size_t n = 0;
+        while (n < common && n < c.items[i].len &&
+               c.items[i].text[n] == c.items[0].text[n]) {
+            n++;
+        }
+        common = n;
+    }
+
+    size_t typed = ed->pos - start - c.keep;
+    if (common > typed) {
+        insert(ed, c.items[0].text + typed, common - typed);
+        ed->listed = false;
+    } else if (c.count > 1) {
+        if (ed->listed) {
+            list_candidates(ed, &c);
+        } else {
+            emits(ed, "\a");
+        }
+        ed->listed = !ed->listed;
+    }
+    if (c.count == 1) insert(ed, c.items[0].is_dir ? "/" : " ", 1);
+    completions_free(&c);
+}
+
+/* ------------------------------------------------------------ */
+/* Reading a line                                               */
+/* ------------------------------------------------------------ */
+
+// Returns false at end of input
+static bool edit(Editor* ed) {
+    ed->cols = terminal_columns();
+    emits(ed, EDITOR_PROMPT);
+    flush(ed);
+
+    while (1) {
+        int key = read_key();
+        if (key != KEY_TAB) ed->listed = false;
+
+        switch (key) {
+            case -1:
+                return false;
+            case KEY_ENTER:
+            case '\n':
+                emits(ed, "\r\n");
+                return true;
+            case KEY_CTRL_C:
+                emits(ed, "^C\r\n" EDITOR_PROMPT);
+                text_set(&ed->line, "");
+                ed->pos = ed->offset = 0;
+                ed->hist_index = hist_count();
+                free(ed->draft);
+                ed->draft = NULL;
+                break;
+            case KEY_CTRL_D:
+                if (ed->line.len == 0) {
+                    emits(ed, "\r\n");
+                    flush(ed);
+                    return false;
+                }
+                // fall through
+            case KEY_DELETE:
+                if (ed->pos < ed->line.len) {
+                    erase(ed, ed->pos, next_char(&ed->line, ed->pos));
+                }
+                break;
+            case KEY_BACKSPACE:
+            case KEY_CTRL_H:
+                if (ed->pos > 0) {
+                    erase(ed, prev_char(&ed->line, ed->pos), ed->pos);
+                }
+                break;
+            case KEY_CTRL_W:
+                erase(ed, word_left(ed), ed->pos);
+                break;
+            case KEY_CTRL_U:
+                erase(ed, 0, ed->pos);
+                break;
+            case KEY_CTRL_K:
+                text_erase(&ed->line, ed->pos, ed->line.len - ed->pos);
+                emits(ed, "\x1b[K");
+                break;
+            case KEY_CTRL_A:
+            case KEY_HOME:
+                move_to(ed, 0);
+                break;
+            case KEY_CTRL_E:
+            case KEY_END:
+                move_to(ed, ed->line.len);
+                break;
+            case KEY_CTRL_B:
+            case KEY_LEFT:
+                move_to(ed, prev_char(&ed->line, ed->pos));
+                break;
+            case KEY_CTRL_F:
+            case KEY_RIGHT:
+                move_to(ed, next_char(&ed->line, ed->pos));
+                break;
+            case KEY_WORD_LEFT:
+                move_to(ed, word_left(ed));
+                break;
+            case KEY_WORD_RIGHT:
+                move_to(ed, word_right(ed));
+                break;
+            case KEY_CTRL_P:
+            case KEY_UP:
+                if (ed->hist_index > 0) {
+                    show_history(ed, ed->hist_index - 1);
+                } else {
+                    emits(ed, "\a");
+                }
+                break;
+            case KEY_CTRL_N:
+            case KEY_DOWN:
+                show_history(ed, ed->hist_index + 1);
+                break;
+            case KEY_CTRL_L:
+                emits(ed, "\x1b[H\x1b[2J");
+                refresh(ed);
+                break;
+            case KEY_TAB:
+                complete(ed);
+                break;
+            default:
+                if (key >= 0x20 && key < 0x7f) {
+                    char c = (char)key;
+                    insert(ed, &c, 1);
+                } else if (key >= 0xc0 && key < 0xf8) {
+                    // a whole UTF-8 sequence, inserted as one
+                    char seq[4] = {(char)key};
+                    size_t n = key >= 0xf0 ? 4 : key >= 0xe0 ? 3 : 2;
+                    size_t got = 1;
+                    while (got < n) {
+                        int b = read_byte();
+                        if (b < 0 || !is_continuation((char)b)) break;
+                        seq[got++] = (char)b;
+                    }
+                    insert(ed, seq, got);
+                }
+                break;
+        }
+        flush(ed);
+    }
+}
+
+// Without a terminal: the prompt, then the line echoed after it, as
+// readline does
+static char* read_plain(void) {
+    Editor ed = {0};
+    emits(&ed, EDITOR_PROMPT);
+    flush(&ed);
+
+    int c;
+    bool any = false;
+    while ((c = read_byte()) >= 0) {
+        any = true;
+        if (c == '\n') break;
+        char ch = (char)c;
+        text_insert(&ed.line, ed.line.len, &ch, 1);
+    }
+    if (!any || !text_reserve(&ed.line, 0)) {
+        free(ed.line.data);
+        free(ed.out.data);
+        return NULL;
+    }
+    emit(&ed, ed.line.data, ed.line.len);
+    emits(&ed, "\n");
+    flush(&ed);
+    free(ed.out.data);
+    return ed.line.data;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+void readline_init() {}
+
+char* read_command_line(void) {
+    fflush(stdout);
+    fflush(stderr);
+    char* line;
+    if (!isatty(STDIN_FILENO) || !raw_mode()) {
+        line = read_plain();
+    } else {
+        Editor ed = {.hist_index = hist_count()};
+        text_reserve(&ed.line, 0);
+        bool ok = ed.line.data && edit(&ed);
+        flush(&ed);
+        cooked_mode();
+        free(ed.draft);
+        free(ed.out.data);
+        line = ok ? ed.line.data : NULL;
+        if (!ok) free(ed.line.data);
+    }
+
+    if (line && *line) hist_add(line);
+    return line;  // caller owns it
+}
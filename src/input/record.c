@@ -0,0 +1,385 @@
+#define _GNU_SOURCE
+
+#include "record.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "exec/exec.h"
+#include "exec/wait.h"
+#include "parse/parsecache.h"
+#include "parse/parser.h"
+#include "util/scanners.h"
+
+#define RECORD_HEADER "# shell recording v1: offset_us<TAB>line\n"
+#define SLOWEST_SHOWN 5
+
+/* ------------------------------------------------------------ */
+/* Recording                                                    */
+/* ------------------------------------------------------------ */
+
+static FILE* recording;
+static int64_t recording_start;
+
+bool record_open(const char* path) {
+    recording = fopen(path, "we");
+    if (!recording) {
+        perror(path);
+        return false;
+    }
+    fputs(RECORD_HEADER, recording);
+    fflush(recording);
+    recording_start = monotonic_ns();
+    return true;
+}
+
+void record_line(const char* line) {
+    if (!recording) return;
+    // flushed per line: a session that crashes keeps what it ran
+    fprintf(recording, "%lld\t%s\n",
+            (long long)((monotonic_ns() - recording_start) / 1000), line);
+    fflush(recording);
+}
+
+void record_close(void) {
+    if (!recording) return;
+    fclose(recording);
+    recording = NULL;
+}
+
+/* ------------------------------------------------------------ */
+/* Loading                                                      */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    int64_t offset_ns;
+    char* text;
+} Line;
+
+typedef struct {
+    int64_t parse_ns;
+    int64_t exec_ns;
+} Timing;
+
+static void free_lines(Line* lines, size_t count) {
+    for (size_t i = 0; i < count; i++) free(lines[i].text);
+    free(lines);
+}
+
+static bool load(const char* path, Line** out, size_t* count) {
+    FILE* f = fopen(path, "re");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    Line* lines = NULL;
+    size_t n = 0, capacity = 0;
+    char* buf = NULL;
+    size_t size = 0;
+    ssize_t len;
+    bool ok = true;
+    for (size_t lineno = 1; (len = getline(&buf, &size, f)) >= 0; lineno++) {
+        if (len > 0 && buf[len - 1] == '\n') buf[--len] = '\0';
+        if (len == 0 || buf[0] == '#') continue;
+
+        char* tab;
+        long long offset_us = strtoll(buf, &tab, 10);
+        if (tab == buf || *tab != '\t') {
+            fprintf(stderr, "%s:%zu: expected offset_us<TAB>line\n", path,
+                    lineno);
+            ok = false;
+            break;
+        }
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            Line* tmp = realloc(lines, sizeof(Line) * capacity);
+            if (!tmp) {
+                ok = false;
+                break;
+            }
+            lines = tmp;
+        }
+        lines[n].offset_ns = offset_us * 1000;
+        lines[n].text = strdup(tab + 1);
+        if (!lines[n++].text) {
+            ok = false;
+            break;
+        }
+    }
+    free(buf);
+    fclose(f);
+
+    if (!ok) {
+        free_lines(lines, n);
+        return false;
+    }
+    *out = lines;
+    *count = n;
+    return true;
+}
+
+/* ------------------------------------------------------------ */
+/* Replayers                                                    */
+/* ------------------------------------------------------------ */
+
+// A replayer's results go to the parent when it exits, even through an
+// `exit` in the recording
+static struct {
+    pid_t pid;
+    int fd;
+    Timing* timings;
+    size_t done;
+} replayer;
+
+static void send_results(void) {
+    // not from stages the replayer forked
+    if (getpid() != replayer.pid) return;
+
+    const char* p = (const char*)replayer.timings;
+    size_t left = replayer.done * sizeof(Timing);
+    while (left > 0) {
+        ssize_t n = write(replayer.fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        p += n;
+        left -= n;
+    }
+    close(replayer.fd);
+}
+
+static void sleep_until(int64_t deadline_ns) {
+    struct timespec ts = {deadline_ns / 1000000000, deadline_ns % 1000000000};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+           EINTR);
+}
+
+static void quiet_stdio(void) {
+    int null = open("/dev/null", O_RDWR);
+    if (null < 0) return;
+    dup2(null, STDIN_FILENO);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    if (null > STDERR_FILENO) close(null);
+}
+
+// In a forked child: runs every line, timing parse and execution. Never
+// returns.
+static void run_replayer(const Line* lines, size_t count, bool fast, int fd) {
+    replayer.pid = getpid();
+    replayer.fd = fd;
+    replayer.timings = calloc(count ? count : 1, sizeof(Timing));
+    if (!replayer.timings) _exit(1);
+    atexit(send_results);
+    quiet_stdio();
+
+    int64_t start = monotonic_ns();
+    for (size_t i = 0; i < count; i++) {
+        if (!fast) sleep_until(start + lines[i].offset_ns);
+
+        int64_t t0 = monotonic_ns();
+        CommandList* list = parse_cache_get(lines[i].text);
+        int64_t t1 = monotonic_ns();
+        if (list) {
+            execute_list(list, false);
+            command_list_release(list);
+        }
+        int64_t t2 = monotonic_ns();
+
+        replayer.timings[i] = (Timing){t1 - t0, t2 - t1};
+        replayer.done = i + 1;
+    }
+    exit(0);
+}
+
+// Reads everything one replayer sent; returns the number of lines it ran
+static size_t collect(int fd, Timing* timings, size_t count) {
+    char* p = (char*)timings;
+    size_t got = 0, want = count * sizeof(Timing);
+    while (got < want) {
+        ssize_t n = read(fd, p + got, want - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fd);
+    return got / sizeof(Timing);
+}
+
+/* ------------------------------------------------------------ */
+/* Report                                                       */
+/* ------------------------------------------------------------ */
+
+static int compare_ns(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+static int64_t percentile(const int64_t* sorted, size_t n, double p) {
+    size_t rank = (size_t)(p / 100.0 * n + 0.999999);
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static const char* format_ns(int64_t ns, char* buf, size_t size) {
+    if (ns < 1000) {
+        snprintf(buf, size, "%lld ns", (long long)ns);
+    } else if (ns < 1000000) {
+        snprintf(buf, size, "%.1f us", ns / 1e3);
+    } else if (ns < 1000000000) {
+        snprintf(buf, size, "%.2f ms", ns / 1e6);
+    } else {
+        snprintf(buf, size, "%.3f s", ns / 1e9);
+    }
+    return buf;
+}
+
+static void print_row(const char* label, int64_t* values, size_t n) {
+    qsort(values, n, sizeof(int64_t), compare_ns);
+    static const double points[] = {50, 90, 99, 100};
+    printf("%-8s", label);
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+        char buf[32];
+        printf(" %10s", format_ns(percentile(values, n, points[i]), buf,
+                                  sizeof(buf)));
+    }
+    printf("\n");
+}
+
+typedef struct {
+    size_t line;
+    int64_t median_ns;
+} LineCost;
+
+static int by_cost(const void* a, const void* b) {
+    return compare_ns(&((const LineCost*)b)->median_ns,
+                      &((const LineCost*)a)->median_ns);
+}
+
+// results[j * count + i]: line i in replayer j, which ran done[j] lines
+static void report(const Line* lines, size_t count, int jobs,
+                   const Timing* results, const size_t* done,
+                   int64_t wall_ns) {
+    size_t total = 0;
+    for (int j = 0; j < jobs; j++) total += done[j];
+    printf("replay: %zu lines x %d replayer%s, %zu run in %.3f s "
+           "(%.1f lines/s)\n",
+           count, jobs, jobs == 1 ? "" : "s", total, wall_ns / 1e9,
+           total / (wall_ns / 1e9));
+    if (total == 0) return;
+
+    int64_t* parse = malloc(sizeof(int64_t) * total);
+    int64_t* exec = malloc(sizeof(int64_t) * total);
+    int64_t* sum = malloc(sizeof(int64_t) * total);
+    LineCost* costs = malloc(sizeof(LineCost) * count);
+    int64_t* per_line = malloc(sizeof(int64_t) * jobs);
+    if (!parse || !exec || !sum || !costs || !per_line) goto out;
+
+    size_t k = 0;
+    for (int j = 0; j < jobs; j++) {
+        for (size_t i = 0; i < done[j]; i++, k++) {
+            const Timing* t = &results[j * count + i];
+            parse[k] = t->parse_ns;
+            exec[k] = t->exec_ns;
+            sum[k] = t->parse_ns + t->exec_ns;
+        }
+    }
+    printf("%-8s %10s %10s %10s %10s\n", "", "p50", "p90", "p99", "max");
+    print_row("parse", parse, total);
+    print_row("execute", exec, total);
+    print_row("total", sum, total);
+
+    // the lines to look at first when a total regresses
+    size_t ranked = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t n = 0;
+        for (int j = 0; j < jobs; j++) {
+            if (i >= done[j]) continue;
+            const Timing* t = &results[j * count + i];
+            per_line[n++] = t->parse_ns + t->exec_ns;
+        }
+        if (n == 0) continue;
+        qsort(per_line, n, sizeof(int64_t), compare_ns);
+        costs[ranked++] = (LineCost){i, percentile(per_line, n, 50)};
+    }
+    qsort(costs, ranked, sizeof(LineCost), by_cost);
+    printf("slowest lines (median):\n");
+    for (size_t i = 0; i < ranked && i < SLOWEST_SHOWN; i++) {
+        char buf[32];
+        printf("  %10s  %.60s\n", format_ns(costs[i].median_ns, buf,
+                                            sizeof(buf)),
+               lines[costs[i].line].text);
+    }
+
+out:
+    free(parse);
+    free(exec);
+    free(sum);
+    free(costs);
+    free(per_line);
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+int replay_main(const char* path, int jobs, bool fast) {
+    Line* lines;
+    size_t count;
+    if (!load(path, &lines, &count)) return 1;
+
+    // the state an interactive session has before its first line
+    build_path_cache();
+    fflush(NULL);
+
+    Timing* results = calloc(count * jobs + 1, sizeof(Timing));
+    size_t done[jobs];
+    int fds[jobs];
+    pid_t pids[jobs];
+    if (!results) {
+        free_lines(lines, count);
+        return 1;
+    }
+
+    int64_t start = monotonic_ns();
+    int started = 0;
+    for (; started < jobs; started++) {
+        int p[2];
+        if (pipe2(p, O_CLOEXEC) != 0) break;
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(p[0]);
+            close(p[1]);
+            break;
+        }
+        if (pid == 0) {
+            for (int j = 0; j < started; j++) close(fds[j]);
+            close(p[0]);
+            run_replayer(lines, count, fast, p[1]);
+        }
+        close(p[1]);
+        fds[started] = p[0];
+        pids[started] = pid;
+    }
+    if (started < jobs) perror("replay");
+
+    // replayers send only at the end, so reading them in turn stalls none
+    // of them while they are being timed
+    for (int j = 0; j < started; j++) {
+        done[j] = collect(fds[j], results + j * count, count);
+        while (waitpid(pids[j], NULL, 0) < 0 && errno == EINTR);
+    }
+    int64_t wall_ns = monotonic_ns() - start;
+
+    if (started > 0) report(lines, count, started, results, done, wall_ns);
+    free(results);
+    free_lines(lines, count);
+    return started == jobs ? 0 : 1;
+}
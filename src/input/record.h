@@ -0,0 +1,30 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+
+/*
+ * Session recording and replay, for benchmarking the shell on real
+ * workloads.
+ *
+ * `shell --record FILE` is an interactive session that also writes every
+ * accepted line to FILE, each with its offset from the start of the
+ * session. `shell --replay FILE [-j N] [--fast]` runs a recording through
+ * the parser and executor in N forked replayers at once, at the recorded
+ * pace or back to back, with the commands' output sent to /dev/null. It
+ * then prints per-line latency percentiles (parse, execute, total) and the
+ * overall throughput.
+ */
+
+/* Starts recording into path (truncated); false if it can't be opened */
+bool record_open(const char* path);
+
+/* Appends one accepted line; no-op unless recording */
+void record_line(const char* line);
+
+void record_close(void);
+
+/* Runs the replay and prints the report; returns the exit status */
+int replay_main(const char* path, int jobs, bool fast);
+
+#endif
@@ -0,0 +1,98 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "script.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "exec/exec.h"
+#include "parse/parser.h"
+
+// Next line worth parsing, without its newline, or NULL at the end
+static char* next_line(FILE* in) {
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while ((n = getline(&line, &cap, in)) >= 0) {
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+            line[--n] = '\0';
+        }
+        const char* p = line + strspn(line, " \t");
+        if (*p && *p != '#') return line;
+    }
+    free(line);
+    return NULL;
+}
+
+// text + "; " + more, freeing both
+static char* join_lines(char* text, char* more) {
+    size_t a = strlen(text), b = strlen(more);
+    char* joined = realloc(text, a + b + 3);
+    if (joined) {
+        memcpy(joined + a, "; ", 2);
+        memcpy(joined + a + 2, more, b + 1);
+    }
+    free(more);
+    return joined;
+}
+
+static int run_lines(FILE* in, const char* name) {
+    int status = 0;
+    char* text = next_line(in);
+
+    while (text) {
+        bool incomplete;
+        CommandList* list;
+        while (!(list = parse_command_list_partial(text, &incomplete)) &&
+               incomplete) {
+            char* more = next_line(in);
+            if (!more) {
+                fprintf(stderr, "%s: syntax error: missing '}'\n", name);
+                break;
+            }
+            text = join_lines(text, more);
+            if (!text) break;
+        }
+        free(text);
+        if (!list) {
+            shell_last_status = 2;
+            return 2;
+        }
+
+        // read ahead: with nothing after it, the list is the last action
+        text = next_line(in);
+        status = execute_list(list, text == NULL);
+        command_list_release(list);
+    }
+    return status;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+int run_script(const char* path) {
+    bool use_stdin = strcmp(path, "-") == 0;
+    FILE* in = use_stdin ? stdin : fopen(path, "re");
+    if (!in) {
+        perror(path);
+        return 127;
+    }
+    int status = run_lines(in, path);
+    if (!use_stdin) fclose(in);
+    return status;
+}
+
+int run_command_string(const char* text) {
+    if (!*text) return 0;
+    FILE* in = fmemopen((void*)text, strlen(text), "r");
+    if (!in) {
+        perror("fmemopen");
+        return 1;
+    }
+    int status = run_lines(in, "-c");
+    fclose(in);
+    return status;
+}
@@ -0,0 +1,20 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+/*
+ * Non-interactive input: `shell -c LINE` and `shell FILE`.
+ *
+ * Input is read a line at a time (blank lines and `#` comment lines are
+ * skipped); a function body may span lines. The shell looks one line
+ * ahead, so the last command knows it is the last and can replace the
+ * shell instead of being forked. A syntax error stops the input with
+ * status 2.
+ */
+
+/* Runs FILE ("-" for stdin); returns the last status */
+int run_script(const char* path);
+
+/* Runs the text of `-c`, which may hold several lines */
+int run_command_string(const char* text);
+
+#endif
@@ -1,19 +1,114 @@
 #define _DEFAULT_SOURCE
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "builtin/builtin.h"
 #include "exec/exec.h"
+#include "expand/vars.h"
 #include "input/input.h"
+#include "input/record.h"
+#include "input/script.h"
+#include "parse/parsecache.h"
 #include "parse/parser.h"
+#include "server/server.h"
 #include "util/scanners.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 
-static void shell_cleanup() { save_history(); }
+static void shell_cleanup() {
+    save_history();
+    record_close();
+    telemetry_flush();
+    trace_stop();
+}
+
+// Scripts and -c keep no history
+static void script_cleanup(void) {
+    telemetry_flush();
+    trace_stop();
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: shell\n"
+            "       shell -c LINE [NAME [ARG...]]\n"
+            "       shell FILE [ARG...]\n"
+            "       shell --record FILE\n"
+            "       shell --replay FILE [-j N] [--fast]\n"
+            "       shell --server SOCKET\n"
+            "       shell --client SOCKET LINE\n");
+}
+
+// shell -c LINE [NAME [ARG...]] and shell FILE [ARG...]: no readline, no
+// history and no PATH scan, since nothing will be completed
+static int run_noninteractive(int argc, char** argv) {
+    telemetry_init();
+    atexit(script_cleanup);
+
+    if (strcmp(argv[1], "-c") == 0) {
+        vars_set_arg0(argv[0]);
+        if (argc > 3) {
+            vars_set_arg0(argv[3]);
+            vars_set_positional(argc - 4, argv + 4);
+        }
+        return run_command_string(argv[2]);
+    }
+
+    vars_set_arg0(argv[1]);
+    vars_set_positional(argc - 2, argv + 2);
+    return run_script(argv[1]);
+}
+
+// shell --replay FILE [-j N] [--fast]
+static int replay_command(int argc, char** argv) {
+    int jobs = 1;
+    bool fast = false;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--fast") == 0) {
+            fast = true;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc &&
+                   (jobs = atoi(argv[i + 1])) > 0) {
+            i++;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    return replay_main(argv[2], jobs, fast);
+}
 
 // sample line: cat < in.txt | grep foo | wc -l >> out.txt
-int main(void) {
+int main(int argc, char** argv) {
+    bool recording = argc == 3 && strcmp(argv[1], "--record") == 0;
+    if (argc > 1 && !recording) {
+        if (strcmp(argv[1], "--client") == 0 && argc == 4) {
+            // the client never builds any shell state
+            return client_main(argv[2], argv[3]);
+        }
+        if (strcmp(argv[1], "--server") == 0 && argc == 3) {
+            telemetry_init();
+            atexit(telemetry_flush);
+            build_path_cache();
+            return server_main(argv[2]);
+        }
+        if (strcmp(argv[1], "--replay") == 0 && argc >= 3) {
+            return replay_command(argc, argv);
+        }
+        bool is_file = argv[1][0] != '-' || strcmp(argv[1], "-") == 0;
+        if (strcmp(argv[1], "-c") == 0 ? argc >= 3 : is_file) {
+            return run_noninteractive(argc, argv);
+        }
+        usage();
+        return 2;
+    }
+
+    if (recording && !record_open(argv[2])) return 1;
+    vars_set_arg0(argv[0]);
+    telemetry_init();
     build_path_cache();
     readline_init();
     initialize_history();
@@ -25,9 +120,14 @@ int main(void) {
         if (!line) break;
 
         if (*line) {
-            Pipeline pipeline = parse_pipeline(line);
-            execute_pipeline(&pipeline);
-            free_pipeline(&pipeline);
+            record_line(line);
+            CommandList* list = parse_cache_get(line);
+            if (list) {
+                execute_list(list, false);
+                command_list_release(list);
+            } else {
+                shell_last_status = 2;
+            }
         }
 
         free(line);
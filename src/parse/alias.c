@@ -0,0 +1,65 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "alias.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds/hashmap.h"
+
+// name -> malloc'd text
+static HashMap aliases;
+static unsigned long generation;
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+const char* alias_get(const char* name) {
+    void* value;
+    return hashmap_get(&aliases, name, &value) ? value : NULL;
+}
+
+bool alias_set(const char* name, const char* value) {
+    char* copy = strdup(value);
+    if (!copy) return false;
+
+    void* old = NULL;
+    hashmap_get(&aliases, name, &old);
+    if (!hashmap_put(&aliases, name, copy, NULL)) {
+        free(copy);
+        return false;
+    }
+    free(old);
+    generation++;
+    return true;
+}
+
+bool alias_remove(const char* name) {
+    void* value;
+    if (!hashmap_remove(&aliases, name, &value)) return false;
+    free(value);
+    generation++;
+    return true;
+}
+
+void alias_clear(void) {
+    size_t iter = 0;
+    void* value;
+    while (hashmap_next(&aliases, &iter, NULL, &value)) free(value);
+    hashmap_free(&aliases);
+    generation++;
+}
+
+unsigned long alias_generation(void) { return generation; }
+
+bool alias_valid_name(const char* name) {
+    return *name && !strpbrk(name, " \t\n'\"\\|;()<>$/=");
+}
+
+bool alias_next(size_t* iter, const char** name, const char** value) {
+    void* v;
+    if (!hashmap_next(&aliases, iter, name, &v)) return false;
+    *value = v;
+    return true;
+}
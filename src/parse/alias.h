@@ -0,0 +1,34 @@
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Aliases, expanded by the lexer when a word in command position (first
+ * word, or after |, ; or {) names one. Expansion happens as the line is
+ * lexed, so an alias costs nothing once the line is parsed.
+ */
+
+/* Text of alias name, or NULL */
+const char* alias_get(const char* name);
+
+bool alias_set(const char* name, const char* value);
+
+/* Returns false if name was not an alias */
+bool alias_remove(const char* name);
+void alias_clear(void);
+
+/* Changes whenever an alias is set or removed */
+unsigned long alias_generation(void);
+
+/* Whether name can be an alias (no quotes, blanks, operators, '/' or '=') */
+bool alias_valid_name(const char* name);
+
+/*
+ * Iteration in no particular order: start with *iter = 0 and call until it
+ * returns false.
+ */
+bool alias_next(size_t* iter, const char** name, const char** value);
+
+#endif
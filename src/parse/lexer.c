@@ -1,52 +1,406 @@
 #include "lexer.h"
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "parse/alias.h"
+
+#if !defined(LEXER_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define LEXER_AVX2 1
+#elif !defined(LEXER_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define LEXER_SSE2 1
+#endif
+
 typedef enum { ST_NORMAL, ST_SQUOTE, ST_DQUOTE, ST_ESCAPE } ParseState;
 
-static void emit_token(char*** tokens, int* ntokens, char* buffer, int* bi) {
-    buffer[*bi] = '\0';
+#define ALIAS_MAX_DEPTH 16
+
+// Values of the aliases being expanded, innermost last. An alias is not
+// expanded again inside its own text, so `alias ls='ls -F'` terminates.
+typedef struct {
+    const char* values[ALIAS_MAX_DEPTH];
+    size_t depth;
+} AliasStack;
+
+/* ------------------------------------------------------------ */
+/* Growable token storage                                       */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    Token* items;
+    size_t count;
+    size_t capacity;
+} TokenVec;
 
-    (*tokens)[*ntokens] = strdup(buffer);
-    (*ntokens)++;
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} WordBuf;
 
-    *bi = 0;
+static bool tokens_push(TokenVec* tv, char* text, TokenType type) {
+    // keep one slot free for the terminator
+    if (tv->count + 1 >= tv->capacity) {
+        size_t new_capacity = tv->capacity * 2;
+        Token* tmp = realloc(tv->items, sizeof(Token) * new_capacity);
+        if (!tmp) return false;
+        tv->items = tmp;
+        tv->capacity = new_capacity;
+    }
+    tv->items[tv->count++] = (Token){text, type};
+    return true;
 }
 
-// tokens array must be freed by caller
-// token strings are owned by caller or transferred
-char** lex_tokens(char* line) {
-    char** tokens = calloc(32, sizeof(char*));
-    if (tokens == NULL) return NULL;
+static bool word_append(WordBuf* w, const char* s, size_t n) {
+    if (w->len + n + 1 > w->capacity) {
+        size_t new_capacity = w->capacity * 2;
+        while (new_capacity < w->len + n + 1) new_capacity *= 2;
+        char* tmp = realloc(w->data, new_capacity);
+        if (!tmp) return false;
+        w->data = tmp;
+        w->capacity = new_capacity;
+    }
+    memcpy(w->data + w->len, s, n);
+    w->len += n;
+    return true;
+}
+
+static void emit_token(TokenVec* tv, WordBuf* w, TokenType type) {
+    char* text = malloc(w->len + 1);
+    if (text) {
+        memcpy(text, w->data, w->len);
+        text[w->len] = '\0';
+        if (!tokens_push(tv, text, type)) free(text);
+    }
+    w->len = 0;
+}
+
+/* ------------------------------------------------------------ */
+/* Run scanning                                                 */
+/* ------------------------------------------------------------ */
+
+// Bytes that end a run of ordinary characters in ST_NORMAL
+static bool is_special(unsigned char c) {
+    return c == ' ' || c == '\'' || c == '"' || c == '\\' || c == '|' ||
+           c == '<' || c == '>' || c == '$' || c == ';' || c == '(' ||
+           c == ')';
+}
+
+// First byte in [p, end) that needs the state machine, or end
+static const char* find_special(const char* p, const char* end) {
+#if defined(LEXER_AVX2)
+    const __m256i sp = _mm256_set1_epi8(' '), sq = _mm256_set1_epi8('\''),
+                  dq = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\'),
+                  pi = _mm256_set1_epi8('|'), lt = _mm256_set1_epi8('<'),
+                  gt = _mm256_set1_epi8('>'), dl = _mm256_set1_epi8('$'),
+                  sc = _mm256_set1_epi8(';'), po = _mm256_set1_epi8('('),
+                  pc = _mm256_set1_epi8(')');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, sp),
+                                _mm256_cmpeq_epi8(v, sq)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, dq),
+                                _mm256_cmpeq_epi8(v, bs))),
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, pi),
+                                _mm256_cmpeq_epi8(v, lt)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, gt),
+                                _mm256_cmpeq_epi8(v, dl))));
+        m = _mm256_or_si256(
+            m, _mm256_or_si256(_mm256_cmpeq_epi8(v, sc),
+                               _mm256_or_si256(_mm256_cmpeq_epi8(v, po),
+                                               _mm256_cmpeq_epi8(v, pc))));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#elif defined(LEXER_SSE2)
+    const __m128i sp = _mm_set1_epi8(' '), sq = _mm_set1_epi8('\''),
+                  dq = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\'),
+                  pi = _mm_set1_epi8('|'), lt = _mm_set1_epi8('<'),
+                  gt = _mm_set1_epi8('>'), dl = _mm_set1_epi8('$'),
+                  sc = _mm_set1_epi8(';'), po = _mm_set1_epi8('('),
+                  pc = _mm_set1_epi8(')');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, sq)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs))),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, pi), _mm_cmpeq_epi8(v, lt)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, dl))));
+        m = _mm_or_si128(
+            m, _mm_or_si128(_mm_cmpeq_epi8(v, sc),
+                            _mm_or_si128(_mm_cmpeq_epi8(v, po),
+                                         _mm_cmpeq_epi8(v, pc))));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && !is_special((unsigned char)*p)) p++;
+    return p;
+}
+
+// First '"', '\\' or '$' in [p, end), or end
+static const char* find_dquote_special(const char* p, const char* end) {
+#if defined(LEXER_AVX2)
+    const __m256i dq = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\'),
+                  dl = _mm256_set1_epi8('$');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, dq), _mm256_cmpeq_epi8(v, bs)),
+            _mm256_cmpeq_epi8(v, dl)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#elif defined(LEXER_SSE2)
+    const __m128i dq = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\'),
+                  dl = _mm_set1_epi8('$');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs)),
+            _mm_cmpeq_epi8(v, dl)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && *p != '$') p++;
+    return p;
+}
+
+/* ------------------------------------------------------------ */
+/* Expansions                                                   */
+/* ------------------------------------------------------------ */
+
+size_t lex_arith_length(const char* s, const char* end) {
+    if (end - s < 3 || s[0] != '$' || s[1] != '(' || s[2] != '(') return 0;
+
+    // the expression's own parentheses must balance before the final "))"
+    int depth = 2;
+    for (const char* p = s + 3; p < end; p++) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')') {
+            depth--;
+            if (depth == 1) {
+                if (p + 1 < end && p[1] == ')') return (size_t)(p + 2 - s);
+                return 0;
+            }
+        }
+    }
+    return 0;
+}
+
+size_t lex_procsub_length(const char* s, const char* end) {
+    if (end - s < 3 || (s[0] != '<' && s[0] != '>') || s[1] != '(') return 0;
+
+    // the inner pipeline's quotes may hold parentheses of their own
+    int depth = 1;
+    for (const char* p = s + 2; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '\'') {
+            p = memchr(p + 1, '\'', end - p - 1);
+            if (!p) return 0;
+        } else if (*p == '"') {
+            for (p++; p < end && *p != '"'; p++) {
+                if (*p == '\\') p++;
+            }
+            if (p >= end) return 0;
+        } else if (*p == '(') {
+            depth++;
+        } else if (*p == ')' && --depth == 0) {
+            return (size_t)(p + 1 - s);
+        }
+    }
+    return 0;
+}
+
+// Copies n bytes at p into the word behind EXPAND_MARKER
+static void append_marked(WordBuf* w, const char* p, size_t n) {
+    char mark = EXPAND_MARKER;
+    word_append(w, &mark, 1);
+    word_append(w, p, n);
+}
 
-    int ntokens = 0;
-    char buffer[512];
-    int bi = 0;
+// Copies the `$` at p into the word behind EXPAND_MARKER. $((...)) is
+// taken whole, blanks and operators included, and so is $$. Returns the
+// new position.
+static const char* lex_dollar(WordBuf* w, const char* p, const char* end) {
+    size_t n = lex_arith_length(p, end);
+    if (n == 0) n = p + 1 < end && p[1] == '$' ? 2 : 1;  // $$ is one name
+
+    append_marked(w, p, n);
+    return p + n;
+}
+
+/* ------------------------------------------------------------ */
+/* Lexer                                                        */
+/* ------------------------------------------------------------ */
+
+static bool lex_text(TokenVec* tv, const char* p, const char* end,
+                     AliasStack* aliases, bool* cmd_pos);
+
+static bool alias_active(const AliasStack* aliases, const char* value) {
+    for (size_t i = 0; i < aliases->depth; i++) {
+        if (aliases->values[i] == value) return true;
+    }
+    return false;
+}
+
+// Offset in the word of its first quote or escape, or UNQUOTED
+#define UNQUOTED SIZE_MAX
+
+static void note_quote(size_t* quote_at, const WordBuf* w) {
+    if (*quote_at == UNQUOTED) *quote_at = w->len;
+}
+
+// Redirection operators, which the parser maps to modes. The fd
+// duplications may have their source fd joined on, as in `2>&1`.
+static const char* const redirect_ops[] = {
+    "<", ">", "1>", ">>", "1>>", "2>", "2>>",
+};
+static const char* const dup_ops[] = {">&", "1>&", "2>&", "<&", "0<&"};
+
+// Whether the word is a redirection operator, written before any quote:
+// `">"` and `\<` are words
+static bool is_redirect(const WordBuf* w, size_t quote_at) {
+    size_t count = sizeof(redirect_ops) / sizeof(*redirect_ops);
+    for (size_t i = 0; i < count; i++) {
+        size_t n = strlen(redirect_ops[i]);
+        if (w->len == n && quote_at >= n &&
+            memcmp(w->data, redirect_ops[i], n) == 0) {
+            return true;
+        }
+    }
+    count = sizeof(dup_ops) / sizeof(*dup_ops);
+    for (size_t i = 0; i < count; i++) {
+        size_t n = strlen(dup_ops[i]);
+        if (w->len >= n && quote_at >= n &&
+            memcmp(w->data, dup_ops[i], n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Ends the word in w. An unquoted word in command position that names an
+// alias is replaced by the tokens of the alias text. Returns whether the
+// next word is in command position.
+static bool end_word(TokenVec* tv, WordBuf* w, size_t quote_at, bool cmd_pos,
+                     AliasStack* aliases) {
+    bool quoted = quote_at != UNQUOTED;
+    if (w->len == 0 && !quoted) return cmd_pos;
+
+    if (cmd_pos && !quoted && aliases->depth < ALIAS_MAX_DEPTH) {
+        w->data[w->len] = '\0';
+        const char* value = alias_get(w->data);
+        if (value && !alias_active(aliases, value)) {
+            w->len = 0;
+            aliases->values[aliases->depth++] = value;
+            bool next = true;
+            size_t n = strlen(value);
+            lex_text(tv, value, value + n, aliases, &next);
+            aliases->depth--;
+            // a trailing blank makes the following word a candidate too
+            return next || (n > 0 && value[n - 1] == ' ');
+        }
+    }
+
+    // unquoted `{` and `}` delimit a function body, whose first word is a
+    // command
+    bool brace = !quoted && w->len == 1 &&
+                 (w->data[0] == '{' || w->data[0] == '}');
+    bool open = brace && w->data[0] == '{';
+    TokenType type = TOKEN_WORD;
+    if (brace) {
+        type = TOKEN_OPERATOR;
+    } else if (is_redirect(w, quote_at)) {
+        type = TOKEN_REDIRECT;
+    }
+    emit_token(tv, w, type);
+    return open;
+}
+
+// Appends the tokens of [p, end) to tv. *cmd_pos tells whether the first
+// word is in command position and receives the same for the word after.
+static bool lex_text(TokenVec* tv, const char* p, const char* end,
+                     AliasStack* aliases, bool* cmd_pos) {
+    WordBuf w = {malloc(512), 0, 512};
+    if (w.data == NULL) return false;
 
     ParseState st = ST_NORMAL;
     ParseState prev = ST_NORMAL;
-    char* p = line;
+    size_t quote_at = UNQUOTED;  // so '' is a word too
+
+    while (p < end) {
+        // bulk-copy runs of ordinary characters
+        if (st == ST_NORMAL || st == ST_SQUOTE || st == ST_DQUOTE) {
+            const char* q;
+            if (st == ST_NORMAL) {
+                q = find_special(p, end);
+            } else if (st == ST_SQUOTE) {
+                q = memchr(p, '\'', end - p);
+                if (!q) q = end;
+            } else {
+                q = find_dquote_special(p, end);
+            }
+            if (q > p) {
+                word_append(&w, p, q - p);
+                p = q;
+                if (p == end) break;
+            }
+        }
 
-    while (*p != '\0') {
         char c = *p++;
 
         switch (st) {
             case ST_NORMAL:
                 if (c == ' ') {
-                    if (bi > 0) emit_token(&tokens, &ntokens, buffer, &bi);
-                } else if (c == '|') {
-                    if (bi > 0) emit_token(&tokens, &ntokens, buffer, &bi);
-                    tokens[ntokens++] = strdup("|");
+                    *cmd_pos = end_word(tv, &w, quote_at, *cmd_pos, aliases);
+                    quote_at = UNQUOTED;
+                } else if (c == '|' || c == ';' || c == '(' || c == ')') {
+                    end_word(tv, &w, quote_at, *cmd_pos, aliases);
+                    quote_at = UNQUOTED;
+                    char op[2] = {c, '\0'};
+                    char* text = strdup(op);
+                    if (text && !tokens_push(tv, text, TOKEN_OPERATOR)) {
+                        free(text);
+                    }
+                    *cmd_pos = true;
                 } else if (c == '\'') {
                     st = ST_SQUOTE;
+                    note_quote(&quote_at, &w);
                 } else if (c == '"') {
                     st = ST_DQUOTE;
+                    note_quote(&quote_at, &w);
                 } else if (c == '\\') {
                     prev = ST_NORMAL;
                     st = ST_ESCAPE;
+                    note_quote(&quote_at, &w);  // \ls is not an alias
+                } else if (c == '$') {
+                    p = lex_dollar(&w, p - 1, end);
+                } else if ((c == '<' || c == '>') && *p == '(') {
+                    // <(...) and >(...) are taken whole, like $((...))
+                    size_t n = lex_procsub_length(p - 1, end);
+                    if (n > 0) {
+                        append_marked(&w, p - 1, n);
+                        p += n - 1;
+                    } else {
+                        word_append(&w, &c, 1);
+                    }
                 } else {
-                    buffer[bi++] = c;
+                    word_append(&w, &c, 1);
                 }
                 break;
 
@@ -54,7 +408,7 @@ char** lex_tokens(char* line) {
                 if (c == '\'') {
                     st = ST_NORMAL;
                 } else {
-                    buffer[bi++] = c;
+                    word_append(&w, &c, 1);
                 }
                 break;
 
@@ -66,27 +420,43 @@ char** lex_tokens(char* line) {
                     if (next == '"' || next == '\\' || next == '`' ||
                         next == '$' || next == '*' || next == '?' ||
                         next == '\n') {
-                        buffer[bi++] = next;
+                        word_append(&w, &next, 1);
                         p++;
                     } else {
-                        buffer[bi++] = '\\';
+                        word_append(&w, "\\", 1);
                     }
+                } else if (c == '$') {
+                    p = lex_dollar(&w, p - 1, end);
                 } else {
-                    buffer[bi++] = c;
+                    word_append(&w, &c, 1);
                 }
                 break;
 
             case ST_ESCAPE:
-                buffer[bi++] = c;
+                word_append(&w, &c, 1);
                 st = prev;
                 break;
         }
     }
 
-    if (bi > 0) {
-        emit_token(&tokens, &ntokens, buffer, &bi);
+    *cmd_pos = end_word(tv, &w, quote_at, *cmd_pos, aliases);
+    free(w.data);
+    return true;
+}
+
+// tokens array must be freed by caller
+// token strings are owned by caller or transferred
+Token* lex_tokens(char* line) {
+    TokenVec tv = {calloc(32, sizeof(Token)), 0, 32};
+    if (tv.items == NULL) return NULL;
+
+    AliasStack aliases = {.depth = 0};
+    bool cmd_pos = true;
+    if (!lex_text(&tv, line, line + strlen(line), &aliases, &cmd_pos)) {
+        free(tv.items);
+        return NULL;
     }
 
-    tokens[ntokens] = NULL;
-    return tokens;
-}
\ No newline at end of file
+    tv.items[tv.count] = (Token){NULL, TOKEN_WORD};
+    return tv.items;
+}
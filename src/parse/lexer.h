@@ -1,6 +1,47 @@
 #ifndef LEXER_H
 #define LEXER_H
 
-char** lex_tokens(char* line);
+#include <stddef.h>
 
-#endif
\ No newline at end of file
+/*
+ * Precedes every `$` in a token that is subject to expansion (unquoted or
+ * in double quotes), and every unquoted `<(` / `>(`. Quoted and escaped
+ * ones are left unmarked, so the expander never has to know about quoting.
+ */
+#define EXPAND_MARKER '\x01'
+
+typedef enum {
+    TOKEN_WORD,
+    TOKEN_OPERATOR,  // |, ;, ( and ), and unquoted { and }
+    TOKEN_REDIRECT,  // <, >, 2>>, >& ..., and `2>&1`-style joined dups
+} TokenType;
+
+/*
+ * A quoted or escaped `;` or `<` is a TOKEN_WORD with the same text as
+ * the operator, so the parser matches operators by type as well as text.
+ */
+typedef struct {
+    char* text;
+    TokenType type;
+} Token;
+
+/*
+ * Splits line into words and operators, terminated by a token whose text
+ * is NULL. A word in command position naming an alias is replaced by the
+ * alias text.
+ */
+Token* lex_tokens(char* line);
+
+/*
+ * Length of the arithmetic expansion "$((...))" starting at s, or 0 if s
+ * does not start a complete one.
+ */
+size_t lex_arith_length(const char* s, const char* end);
+
+/*
+ * Length of the process substitution "<(...)" or ">(...)" starting at s,
+ * or 0 if s does not start a complete one.
+ */
+size_t lex_procsub_length(const char* s, const char* end);
+
+#endif
@@ -0,0 +1,169 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parsecache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds/hashmap.h"
+#include "parse/alias.h"
+#include "parse/parser.h"
+
+#define PARSE_CACHE_DEFAULT_BYTES (256 * 1024)
+
+// One cached line, on the LRU list (most recent first)
+typedef struct Entry {
+    struct Entry* prev;
+    struct Entry* next;
+    CommandList* list;
+    size_t bytes;
+    char line[];
+} Entry;
+
+static struct {
+    bool ready;
+    HashMap lines;  // line -> Entry*
+    Entry* newest;
+    Entry* oldest;
+    unsigned long alias_generation;
+    ParseCacheStats stats;
+} cache;
+
+/* ------------------------------------------------------------ */
+/* Sizes                                                        */
+/* ------------------------------------------------------------ */
+
+static size_t command_bytes(const Command* cmd) {
+    size_t n = sizeof(char*) * (cmd->argc + 1);
+    for (int i = 0; i < cmd->argc; i++) n += strlen(cmd->argv[i]) + 1;
+    for (int i = 0; i < cmd->redirc; i++) {
+        n += strlen(cmd->redirections[i].filename) + 1;
+    }
+    return n;
+}
+
+// Heap memory the list holds, function bodies included
+static size_t list_bytes(const CommandList* list) {
+    size_t n = sizeof(CommandList) + sizeof(ListItem) * list->count;
+    for (size_t i = 0; i < list->count; i++) {
+        const ListItem* item = &list->items[i];
+        if (item->function) {
+            n += strlen(item->function) + 1 + list_bytes(item->body);
+            continue;
+        }
+        n += sizeof(Command) * item->pipeline.count;
+        for (size_t k = 0; k < item->pipeline.count; k++) {
+            n += command_bytes(&item->pipeline.cmds[k]);
+        }
+    }
+    return n;
+}
+
+/* ------------------------------------------------------------ */
+/* LRU list                                                     */
+/* ------------------------------------------------------------ */
+
+static void unlink_entry(Entry* e) {
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        cache.newest = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        cache.oldest = e->prev;
+    }
+    e->prev = e->next = NULL;
+}
+
+static void push_newest(Entry* e) {
+    e->next = cache.newest;
+    if (cache.newest) cache.newest->prev = e;
+    cache.newest = e;
+    if (!cache.oldest) cache.oldest = e;
+}
+
+static void drop_entry(Entry* e) {
+    unlink_entry(e);
+    hashmap_remove(&cache.lines, e->line, NULL);
+    cache.stats.entries--;
+    cache.stats.bytes -= e->bytes;
+    command_list_release(e->list);
+    free(e);
+}
+
+static void init(void) {
+    cache.ready = true;
+    hashmap_init(&cache.lines);
+    cache.alias_generation = alias_generation();
+    cache.stats.budget = PARSE_CACHE_DEFAULT_BYTES;
+    const char* budget = getenv("SHELL_PARSE_CACHE_BYTES");
+    if (budget && *budget) {
+        char* end;
+        unsigned long long v = strtoull(budget, &end, 10);
+        if (!*end) cache.stats.budget = v;
+    }
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+CommandList* parse_cache_get(char* line) {
+    if (!cache.ready) init();
+    if (cache.stats.budget == 0) return parse_command_list(line);
+
+    // lists parsed under other aliases may have expanded them differently
+    if (cache.alias_generation != alias_generation()) {
+        parse_cache_clear();
+        cache.alias_generation = alias_generation();
+    }
+
+    void* found;
+    if (hashmap_get(&cache.lines, line, &found)) {
+        Entry* e = found;
+        cache.stats.hits++;
+        unlink_entry(e);
+        push_newest(e);
+        return command_list_retain(e->list);
+    }
+
+    cache.stats.misses++;
+    CommandList* list = parse_command_list(line);
+    if (!list) return NULL;
+
+    size_t len = strlen(line);
+    // the line twice: the map keeps its own copy of the key
+    size_t bytes = sizeof(Entry) + 2 * (len + 1) + list_bytes(list);
+    if (bytes > cache.stats.budget / 4) return list;  // would crowd out others
+    Entry* e = malloc(sizeof(Entry) + len + 1);
+    if (!e) return list;
+    memcpy(e->line, line, len + 1);
+    e->list = command_list_retain(list);
+    e->bytes = bytes;
+    e->prev = e->next = NULL;
+    if (!hashmap_put(&cache.lines, e->line, e, NULL)) {
+        command_list_release(e->list);
+        free(e);
+        return list;
+    }
+    push_newest(e);
+    cache.stats.entries++;
+    cache.stats.bytes += bytes;
+
+    while (cache.stats.bytes > cache.stats.budget) {
+        drop_entry(cache.oldest);
+        cache.stats.evictions++;
+    }
+    return list;
+}
+
+void parse_cache_clear(void) {
+    while (cache.oldest) drop_entry(cache.oldest);
+}
+
+ParseCacheStats parse_cache_stats(void) {
+    if (!cache.ready) init();
+    return cache.stats;
+}
@@ -0,0 +1,40 @@
+#ifndef PARSECACHE_H
+#define PARSECACHE_H
+
+#include <stddef.h>
+
+#include "shell.h"
+
+/*
+ * Parsed lines, kept by their raw text so that re-running a line (history
+ * recall, a replayed session) skips lexing and parsing.
+ *
+ * A parsed CommandList holds no expanded values: `$x`, `${...}`, `$((...))`
+ * and `<(...)` stay in its words as written until the pipeline runs, so
+ * one list serves every run of its line. Lists are shared by reference count; a cached list
+ * stays valid for its holder after eviction. Alias expansion does happen
+ * while lexing, so any alias change empties the cache.
+ *
+ * The cache keeps the most recently used lines within a memory budget of
+ * SHELL_PARSE_CACHE_BYTES (default 256 KiB, 0 disables it).
+ */
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    size_t entries;
+    size_t bytes;
+    size_t budget;
+} ParseCacheStats;
+
+/*
+ * Like parse_command_list(): a new reference to line's list, or NULL after
+ * printing a syntax error. Release it with command_list_release().
+ */
+CommandList* parse_cache_get(char* line);
+
+void parse_cache_clear(void);
+ParseCacheStats parse_cache_stats(void);
+
+#endif
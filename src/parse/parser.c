@@ -1,5 +1,6 @@
 #include "parser.h"
 
+#include <ctype.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -16,6 +17,8 @@ void free_parsed_command(Command* pc) {
         free(pc->argv[i]);
     }
 
+    free(pc->argv);
+
     for (int i = 0; i < pc->redirc; i++) {
         free_redirection(&(pc->redirections[i]));
     }
@@ -28,14 +31,47 @@ void free_pipeline(Pipeline* pl) {
     free(pl->cmds);
 }
 
-bool is_redirection(const char* token) {
-    if (token == NULL) {
+// fd duplication, N>&M and N<&M: the operator, then the fd it copies
+static const struct {
+    const char* op;
+    int target_fd;
+} dup_ops[] = {
+    {">&", 1}, {"1>&", 1}, {"2>&", 2}, {"<&", 0}, {"0<&", 0},
+};
+
+// Length of the dup operator token starts with, or 0
+static size_t dup_operator(const char* token, int* target_fd) {
+    for (size_t i = 0; i < sizeof(dup_ops) / sizeof(dup_ops[0]); i++) {
+        size_t n = strlen(dup_ops[i].op);
+        if (strncmp(token, dup_ops[i].op, n) == 0) {
+            *target_fd = dup_ops[i].target_fd;
+            return n;
+        }
+    }
+    return 0;
+}
+
+// An operator that takes the next token as its target. Only the lexer
+// makes redirection tokens, so a quoted `<` is a word.
+bool is_redirection(const Token* t) {
+    if (t->type != TOKEN_REDIRECT) {
         return false;
     }
 
-    return strcmp(token, ">") == 0 || strcmp(token, "1>") == 0 ||
-           strcmp(token, ">>") == 0 || strcmp(token, "1>>") == 0 ||
-           strcmp(token, "2>") == 0 || strcmp(token, "2>>") == 0;
+    int fd;
+    size_t dup = dup_operator(t->text, &fd);
+    return dup == 0 || t->text[dup] == '\0';
+}
+
+// `>&2` or `<&${C[0]}`: operator and source fd in one word, as usually
+// written
+static bool is_joined_dup(const Token* t, Redirection* out) {
+    if (t->type != TOKEN_REDIRECT) return false;
+    int fd;
+    size_t n = dup_operator(t->text, &fd);
+    if (n == 0 || t->text[n] == '\0') return false;
+    *out = (Redirection){fd, DUP, strdup(t->text + n)};
+    return true;
 }
 
 Redirection parse_redirection(const char* token, char* next_token, bool* ok) {
@@ -62,6 +98,9 @@ Redirection parse_redirection(const char* token, char* next_token, bool* ok) {
     } else if (strcmp(token, "2>>") == 0) {
         out.target_fd = 2;
         out.mode = APPEND;
+    } else {
+        dup_operator(token, &out.target_fd);
+        out.mode = DUP;
     }
 
     out.filename = strdup(next_token);
@@ -69,23 +108,35 @@ Redirection parse_redirection(const char* token, char* next_token, bool* ok) {
     return out;
 }
 
-Command parse_command_tokens(char** tokens, int start, int end) {
+// check_pipeline has already bounded the stage's redirections by MAX_REDIR
+// and given each operator a target
+Command parse_command_tokens(Token* tokens, int start, int end) {
     Command out = {0};
+    out.argv = malloc(sizeof(char*) * (end - start + 1));
+    if (!out.argv) return out;
 
     int i = start;
-    while (i < end && tokens[i] != NULL) {
-        if (is_redirection(tokens[i])) {
+    Redirection joined;
+    while (i < end && tokens[i].text != NULL) {
+        if (is_redirection(&tokens[i])) {
             bool ok;
-            Redirection r = parse_redirection(tokens[i], tokens[i + 1], &ok);
+            Redirection r = parse_redirection(tokens[i].text,
+                                              tokens[i + 1].text, &ok);
 
             if (!ok) {
                 break;
             }
 
             out.redirections[out.redirc++] = r;
+            free(tokens[i].text);
+            free(tokens[i + 1].text);
             i += 2;  // skip operator + filename
+        } else if (is_joined_dup(&tokens[i], &joined)) {
+            out.redirections[out.redirc++] = joined;
+            free(tokens[i].text);
+            i += 1;
         } else {
-            out.argv[out.argc++] = tokens[i];
+            out.argv[out.argc++] = tokens[i].text;
             i += 1;
         }
     }
@@ -95,45 +146,245 @@ Command parse_command_tokens(char** tokens, int start, int end) {
     return out;
 }
 
-// parsed pipeline should be freed by caller using free_pipeline
-Pipeline parse_pipeline(char* line) {
-    Pipeline out = {0};
-    char** tokens = lex_tokens(line);
-    if (!tokens) return out;
+// Only the lexer makes operators: a quoted or escaped `;` is a word. The
+// terminating token is a word, so this is safe to call on it.
+static bool is_token(const Token* t, const char* op) {
+    return t->type == TOKEN_OPERATOR && strcmp(t->text, op) == 0;
+}
+
+static void free_tokens(Token* tokens, size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) free(tokens[i].text);
+}
 
-    int start = 0;
+/* ------------------------------------------------------------ */
+/* Pipelines                                                    */
+/* ------------------------------------------------------------ */
 
-    for (int i = 0;; i++) {
-        if (tokens[i] == NULL || strcmp(tokens[i], "|") == 0) {
-            // syntax error: empty command
-            if (i == start) {
-                fprintf(stderr, "syntax error near '|'\n");
-                free_pipeline(&out);
-                free(tokens);
-                return (Pipeline){0};
+// Validates tokens[start, end) before any of them changes hands
+static bool check_pipeline(Token* tokens, size_t start, size_t end) {
+    bool empty = true;  // no token in the current stage yet
+    int redirs = 0;     // in the current stage
+    for (size_t i = start; i < end; i++) {
+        const Token* t = &tokens[i];
+        if (is_token(t, "|")) {
+            if (empty) break;
+            empty = true;
+            redirs = 0;
+            continue;
+        }
+        if (is_token(t, "(") || is_token(t, ")")) {
+            fprintf(stderr, "syntax error near '%s'\n", t->text);
+            return false;
+        }
+        if (t->type == TOKEN_REDIRECT && ++redirs > MAX_REDIR) {
+            fprintf(stderr, "syntax error: too many redirections\n");
+            return false;
+        }
+        if (is_redirection(t)) {
+            if (i + 1 == end || is_token(&tokens[i + 1], "|")) {
+                fprintf(stderr, "syntax error: redirection without target\n");
+                return false;
             }
+            i++;  // the target is a word whatever it looks like
+        }
+        empty = false;
+    }
+    if (empty) {
+        fprintf(stderr, "syntax error near '|'\n");
+        return false;
+    }
+    return true;
+}
+
+// Parses tokens[start, end) into out. Those tokens are consumed either
+// way; on failure nothing needs freeing.
+static bool parse_pipeline(Token* tokens, size_t start, size_t end,
+                           Pipeline* out) {
+    *out = (Pipeline){0};
+    if (!check_pipeline(tokens, start, end)) {
+        free_tokens(tokens, start, end);
+        return false;
+    }
 
+    size_t stage = start;
+    for (size_t i = start;; i++) {
+        if (i == end || is_token(&tokens[i], "|")) {
             // grow command array
-            Command* tmp = realloc(out.cmds, sizeof(Command) * (out.count + 1));
+            Command* tmp = realloc(out->cmds, sizeof(Command) * (out->count + 1));
             if (!tmp) {
                 perror("realloc");
-                free_pipeline(&out);
-                free(tokens);
-                return (Pipeline){0};
+                free_tokens(tokens, stage, end);
+                free_pipeline(out);
+                return false;
             }
-            out.cmds = tmp;
+            out->cmds = tmp;
 
             // parse one command segment
-            out.cmds[out.count++] = parse_command_tokens(tokens, start, i);
+            out->cmds[out->count++] = parse_command_tokens(tokens, stage, i);
 
             // end of input → stop
-            if (tokens[i] == NULL) break;
+            if (i == end) break;
 
             // skip '|'
-            start = i + 1;
+            free(tokens[i].text);
+            stage = i + 1;
+        }
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------ */
+/* Lists and function definitions                               */
+/* ------------------------------------------------------------ */
+
+static CommandList* command_list_new(void) {
+    CommandList* list = calloc(1, sizeof(CommandList));
+    if (list) list->refs = 1;
+    return list;
+}
+
+static bool append_item(CommandList* list, ListItem item) {
+    ListItem* tmp = realloc(list->items, sizeof(ListItem) * (list->count + 1));
+    if (!tmp) return false;
+    list->items = tmp;
+    list->items[list->count++] = item;
+    return true;
+}
+
+static bool is_function_name(const char* s) {
+    if (!*s || isdigit((unsigned char)*s)) return false;
+    for (; *s; s++) {
+        if (!isalnum((unsigned char)*s) && !strchr("_-.:", *s)) return false;
+    }
+    return true;
+}
+
+static bool parse_list(Token* tokens, size_t* i, bool in_body,
+                       CommandList* list, bool* incomplete);
+
+// tokens[*i] starts `name ( ) { list; }`
+static bool parse_function(Token* tokens, size_t* i, bool in_body,
+                           CommandList* list, bool* incomplete) {
+    char* name = tokens[*i].text;
+    free(tokens[*i + 1].text);
+    free(tokens[*i + 2].text);
+    *i += 3;
+    if (!is_token(&tokens[*i], "{")) {
+        fprintf(stderr, "syntax error: expected '{' after %s()\n", name);
+        free(name);
+        return false;
+    }
+    free(tokens[(*i)++].text);
+
+    CommandList* body = command_list_new();
+    bool ok = body && parse_list(tokens, i, true, body, incomplete);
+
+    // the definition must end its item
+    const Token* next = &tokens[*i];
+    if (ok && next->text && !is_token(next, ";") &&
+        !(in_body && is_token(next, "}"))) {
+        fprintf(stderr, "syntax error near '%s'\n", next->text);
+        ok = false;
+    }
+    if (!ok || !append_item(list, (ListItem){.function = name, .body = body})) {
+        free(name);
+        command_list_release(body);
+        return false;
+    }
+    return true;
+}
+
+// Parses `;`-separated items into list, up to the end of tokens or, in a
+// function body, the closing `}`. *i moves past every consumed token; on
+// failure the caller frees the tokens from *i on. Running out of tokens
+// inside a body sets *incomplete if given, and is an error otherwise.
+static bool parse_list(Token* tokens, size_t* i, bool in_body,
+                       CommandList* list, bool* incomplete) {
+    while (1) {
+        while (is_token(&tokens[*i], ";")) free(tokens[(*i)++].text);
+
+        const Token* t = &tokens[*i];
+        if (t->text == NULL) {
+            if (!in_body) return true;
+            if (incomplete) {
+                *incomplete = true;
+            } else {
+                fprintf(stderr, "syntax error: missing '}'\n");
+            }
+            return false;
+        }
+        if (is_token(t, "}")) {
+            if (!in_body) {
+                fprintf(stderr, "syntax error near '}'\n");
+                return false;
+            }
+            free(tokens[(*i)++].text);
+            return true;
+        }
+
+        if (t->type == TOKEN_WORD && is_function_name(t->text) &&
+            is_token(&tokens[*i + 1], "(") && is_token(&tokens[*i + 2], ")")) {
+            if (!parse_function(tokens, i, in_body, list, incomplete)) {
+                return false;
+            }
+            continue;
+        }
+
+        size_t end = *i;
+        while (tokens[end].text && !is_token(&tokens[end], ";")) end++;
+
+        Pipeline pl;
+        size_t start = *i;
+        *i = end;
+        if (!parse_pipeline(tokens, start, end, &pl)) return false;
+        if (!append_item(list, (ListItem){.pipeline = pl})) {
+            free_pipeline(&pl);
+            return false;
         }
     }
+}
 
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+CommandList* parse_command_list(char* line) {
+    return parse_command_list_partial(line, NULL);
+}
+
+CommandList* parse_command_list_partial(char* line, bool* incomplete) {
+    if (incomplete) *incomplete = false;
+    Token* tokens = lex_tokens(line);
+    if (!tokens) return NULL;
+
+    CommandList* list = command_list_new();
+    size_t i = 0;
+    if (!list || !parse_list(tokens, &i, false, list, incomplete)) {
+        for (; tokens[i].text; i++) free(tokens[i].text);
+        command_list_release(list);
+        list = NULL;
+    }
     free(tokens);
-    return out;
+    return list;
+}
+
+CommandList* command_list_retain(CommandList* list) {
+    list->refs++;
+    return list;
+}
+
+void command_list_release(CommandList* list) {
+    if (!list || --list->refs > 0) return;
+
+    for (size_t i = 0; i < list->count; i++) {
+        ListItem* item = &list->items[i];
+        if (item->function) {
+            free(item->function);
+            command_list_release(item->body);
+        } else {
+            free_pipeline(&item->pipeline);
+        }
+    }
+    free(list->items);
+    free(list);
 }
@@ -3,7 +3,23 @@
 
 #include "shell.h"
 
-Pipeline parse_pipeline(char* line);
+/*
+ * Parses a line of `;`-separated pipelines and `name() { list; }`
+ * function definitions. Returns NULL after printing a syntax error; the
+ * result is released with command_list_release().
+ */
+CommandList* parse_command_list(char* line);
+
+/*
+ * Like parse_command_list(), but a line ending inside a function body is
+ * not an error: NULL comes back with *incomplete set, and the caller can
+ * retry with the following input appended.
+ */
+CommandList* parse_command_list_partial(char* line, bool* incomplete);
+
+CommandList* command_list_retain(CommandList* list);
+void command_list_release(CommandList* list);
+
 void free_pipeline(Pipeline* pl);
 
 #endif
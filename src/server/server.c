@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+
+#include "server.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "exec/exec.h"
+#include "parse/parser.h"
+#include "shell.h"
+#include "util/telemetry.h"
+
+// Request layout: header (sent together with the three fds), then
+// cwd_len bytes of cwd followed by line_len bytes of command line.
+typedef struct {
+    uint32_t cwd_len;
+    uint32_t line_len;
+} RequestHeader;
+
+static int make_address(struct sockaddr_un* addr, const char* path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+static int read_full(int fd, void* buf, size_t n) {
+    char* p = buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        n -= r;
+    }
+    return 0;
+}
+
+// Both ends write only to the socket: a peer that went away is an error,
+// not SIGPIPE
+static int write_full(int fd, const void* buf, size_t n) {
+    const char* p = buf;
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) return -1;
+        p += w;
+        n -= w;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------ */
+/* Server                                                       */
+/* ------------------------------------------------------------ */
+
+// The connection a handler answers on, for a line that runs `exit`
+static struct {
+    pid_t pid;
+    int conn;
+} handler = {0, -1};
+
+static int send_status(int32_t status) {
+    fflush(stdout);
+    fflush(stderr);
+    telemetry_flush();
+
+    int conn = handler.conn;
+    handler.conn = -1;
+    return write_full(conn, &status, sizeof(status));
+}
+
+// `exit N` ends the handler inside execute_list; the client still gets N
+static void send_exit_status(void) {
+    // not from stages the handler forked
+    if (getpid() != handler.pid || handler.conn < 0) return;
+    send_status(shell_last_status);
+}
+
+// Runs in a child forked from the warm server for one connection
+static int serve_connection(int conn) {
+    RequestHeader hdr;
+    int fds[3];
+
+    char cbuf[CMSG_SPACE(sizeof(fds))];
+    struct iovec iov = {&hdr, sizeof(hdr)};
+    struct msghdr msg = {.msg_iov = &iov,
+                         .msg_iovlen = 1,
+                         .msg_control = cbuf,
+                         .msg_controllen = sizeof(cbuf)};
+
+    ssize_t n = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    if (n != sizeof(hdr) || !cm || cm->cmsg_type != SCM_RIGHTS ||
+        cm->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+
+    char* cwd = malloc(hdr.cwd_len + 1);
+    char* line = malloc(hdr.line_len + 1);
+    if (!cwd || !line || read_full(conn, cwd, hdr.cwd_len) != 0 ||
+        read_full(conn, line, hdr.line_len) != 0) {
+        return -1;
+    }
+    cwd[hdr.cwd_len] = '\0';
+    line[hdr.line_len] = '\0';
+
+    // adopt the client's stdio; dup2 clears close-on-exec
+    for (int i = 0; i < 3; i++) {
+        dup2(fds[i], i);
+        close(fds[i]);
+    }
+    if (hdr.cwd_len > 0 && chdir(cwd) != 0) perror(cwd);
+
+    handler.pid = getpid();
+    handler.conn = conn;
+    atexit(send_exit_status);
+
+    int32_t status = 0;
+    if (*line) {
+        CommandList* list = parse_command_list(line);
+        if (list) {
+            status = execute_list(list, false);
+            command_list_release(list);
+        } else {
+            status = 2;
+        }
+    }
+
+    free(cwd);
+    free(line);
+    return send_status(status);
+}
+
+// Only a stale socket is replaced: anything else at the path is refused
+static bool remove_stale_socket(const char* path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        if (errno == ENOENT) return true;
+        perror(path);
+        return false;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        fprintf(stderr, "%s: exists and is not a socket\n", path);
+        return false;
+    }
+    if (unlink(path) != 0) {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+// A connection runs commands as the server's user, so only that user
+// may connect
+static bool same_user(int conn) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        perror("SO_PEERCRED");
+        return false;
+    }
+    if (cred.uid != geteuid()) {
+        fprintf(stderr, "server: refused connection from uid %u\n",
+                (unsigned)cred.uid);
+        return false;
+    }
+    return true;
+}
+
+int server_main(const char* socket_path) {
+    struct sockaddr_un addr;
+    if (make_address(&addr, socket_path) != 0) return 1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    if (!remove_stale_socket(socket_path)) {
+        close(sock);
+        return 1;
+    }
+    // created 0600; the peer check below is what keeps other users out
+    // on filesystems that ignore socket permissions
+    mode_t mask = umask(0077);
+    int bound = bind(sock, (struct sockaddr*)&addr, sizeof(addr));
+    umask(mask);
+    if (bound != 0 || listen(sock, SOMAXCONN) != 0) {
+        perror(socket_path);
+        close(sock);
+        return 1;
+    }
+    struct stat bound_st;
+    if (lstat(socket_path, &bound_st) != 0) {
+        perror(socket_path);
+        close(sock);
+        return 1;
+    }
+
+    // connection handlers are never waited for
+    signal(SIGCHLD, SIG_IGN);
+
+    while (1) {
+        int conn = accept4(sock, NULL, NULL, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept");
+            break;
+        }
+        if (!same_user(conn)) {
+            close(conn);
+            continue;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // handlers wait for their own pipelines
+            signal(SIGCHLD, SIG_DFL);
+            close(sock);
+            telemetry_adopt();
+            _exit(serve_connection(conn) == 0 ? 0 : 1);
+        }
+        if (pid < 0) perror("fork");
+        close(conn);
+    }
+
+    close(sock);
+    // unless another server has replaced it since
+    struct stat st;
+    if (lstat(socket_path, &st) == 0 && st.st_dev == bound_st.st_dev &&
+        st.st_ino == bound_st.st_ino) {
+        unlink(socket_path);
+    }
+    return 1;
+}
+
+/* ------------------------------------------------------------ */
+/* Client                                                       */
+/* ------------------------------------------------------------ */
+
+int client_main(const char* socket_path, const char* line) {
+    struct sockaddr_un addr;
+    if (make_address(&addr, socket_path) != 0) return 1;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror(socket_path);
+        return 1;
+    }
+
+    char* cwd = getcwd(NULL, 0);
+    RequestHeader hdr = {cwd ? strlen(cwd) : 0, strlen(line)};
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+
+    char cbuf[CMSG_SPACE(sizeof(fds))];
+    memset(cbuf, 0, sizeof(cbuf));
+    struct iovec iov = {&hdr, sizeof(hdr)};
+    struct msghdr msg = {.msg_iov = &iov,
+                         .msg_iovlen = 1,
+                         .msg_control = cbuf,
+                         .msg_controllen = sizeof(cbuf)};
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    int32_t status = 1;
+    if (sendmsg(sock, &msg, MSG_NOSIGNAL) != sizeof(hdr) ||
+        write_full(sock, cwd ? cwd : "", hdr.cwd_len) != 0 ||
+        write_full(sock, line, hdr.line_len) != 0 ||
+        read_full(sock, &status, sizeof(status)) != 0) {
+        fprintf(stderr, "%s: server connection failed\n", socket_path);
+        status = 1;
+    }
+
+    free(cwd);
+    close(sock);
+    return status;
+}
@@ -0,0 +1,17 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+ * Command-server mode.
+ *
+ * `shell --server SOCKET` keeps one warm shell (path cache built, builtins
+ * registered) listening on a Unix socket. `shell --client SOCKET LINE`
+ * passes its stdin/stdout/stderr to the server with SCM_RIGHTS together with
+ * its cwd and the command line; the server forks from the warm image, runs
+ * the line on the client's fds and sends back the exit status.
+ */
+
+int server_main(const char* socket_path);
+int client_main(const char* socket_path, const char* line);
+
+#endif
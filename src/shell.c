@@ -3,34 +3,85 @@
 #include <stdlib.h>
 #include <string.h>
 
+ShellOptions shell_options = {.optimize = true};
+int shell_last_status;
+
 #define STRINGLIST_INITIAL_CAPACITY 16
+// rough guess used to pre-size the pool from the item capacity
+#define STRINGLIST_AVG_LENGTH 16
 
 // Initialize the list with a starting capacity
 void list_init(StringList* list, size_t initial_capacity) {
     if (initial_capacity == 0) initial_capacity = STRINGLIST_INITIAL_CAPACITY;
-    list->items = malloc(sizeof(char*) * initial_capacity);
+    strpool_init(&list->pool, initial_capacity * STRINGLIST_AVG_LENGTH);
+    list->offsets = malloc(sizeof(uint32_t) * initial_capacity);
+    list->lengths = malloc(sizeof(uint32_t) * initial_capacity);
     list->count = 0;
     list->capacity = initial_capacity;
 }
 
-// Append a string, reallocating only if needed
-void list_append(StringList* list, const char* s) {
+static bool list_push(StringList* list, uint32_t off, size_t len) {
     if (list->count >= list->capacity) {
         size_t new_capacity = list->capacity * 2;
-        char** tmp = realloc(list->items, sizeof(char*) * new_capacity);
-        if (!tmp) return;  // malloc failed, silently ignore
-        list->items = tmp;
+        uint32_t* offsets =
+            realloc(list->offsets, sizeof(uint32_t) * new_capacity);
+        if (!offsets) return false;
+        list->offsets = offsets;
+        uint32_t* lengths =
+            realloc(list->lengths, sizeof(uint32_t) * new_capacity);
+        if (!lengths) return false;
+        list->lengths = lengths;
         list->capacity = new_capacity;
     }
-    list->items[list->count++] = strdup(s);
+    list->offsets[list->count] = off;
+    list->lengths[list->count] = (uint32_t)len;
+    list->count++;
+    return true;
+}
+
+// Append a copy of s, reallocating only if needed
+void list_append(StringList* list, const char* s) {
+    size_t len = strlen(s);
+    uint32_t off = strpool_add(&list->pool, s, len);
+    if (off == STRPOOL_NONE) return;  // malloc failed, silently ignore
+    list_push(list, off, len);
+}
+
+// Append s unless an equal string is already in the list
+bool list_append_unique(StringList* list, const char* s) {
+    size_t len = strlen(s);
+    bool added;
+    uint32_t off = strpool_intern(&list->pool, s, len, &added);
+    if (off == STRPOOL_NONE || !added) return false;
+    return list_push(list, off, len);
 }
 
 // Free all strings and reset the list
 void free_string_list(StringList* list) {
-    if (!list->items) return;
-    for (size_t i = 0; i < list->count; i++) free(list->items[i]);
-    free(list->items);
-    list->items = NULL;
+    if (!list->offsets) return;
+    strpool_free(&list->pool);
+    free(list->offsets);
+    free(list->lengths);
+    list->offsets = NULL;
+    list->lengths = NULL;
     list->count = 0;
     list->capacity = 0;
-}
\ No newline at end of file
+}
+
+// Trim spare capacity once a list is complete. Interning stops working
+// (list_append_unique no longer sees earlier strings).
+void list_shrink_to_fit(StringList* list) {
+    strpool_compact(&list->pool);
+    if (list->count == 0 || list->count == list->capacity) return;
+
+    uint32_t* offsets = realloc(list->offsets, sizeof(uint32_t) * list->count);
+    if (offsets) list->offsets = offsets;
+    uint32_t* lengths = realloc(list->lengths, sizeof(uint32_t) * list->count);
+    if (lengths) list->lengths = lengths;
+    if (offsets && lengths) list->capacity = list->count;
+}
+
+// Heap bytes owned by the list
+size_t list_memory(const StringList* list) {
+    return strpool_memory(&list->pool) + list->capacity * 2 * sizeof(uint32_t);
+}
@@ -7,26 +7,32 @@
 #define PATH_LIST_SEPARATOR ":"
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include "ds/strpool.h"
 
 #define MAX_REDIR 8
-#define MAX_ARGV 16
 
 typedef struct {
     int target_fd;
-    enum { TRUNC, APPEND, READ } mode;
-    char* filename;
+    enum { TRUNC, APPEND, READ, DUP } mode;
+    char* filename;  // for DUP (N>&M, N<&M), the word naming fd M
 } Redirection;
 
 typedef struct {
-    char* argv[MAX_ARGV];
+    char** argv;  // NULL-terminated, argc entries
     int argc;
     Redirection redirections[MAX_REDIR];
     int redirc;
 } Command;
 
+// Strings live back to back in one pool; items are offset/length pairs
 typedef struct {
-    char** items;
+    StrPool pool;
+    uint32_t* offsets;
+    uint32_t* lengths;
     size_t count;
     size_t capacity;
 } StringList;
@@ -36,8 +42,50 @@ typedef struct {
     size_t count;
 } Pipeline;
 
+typedef struct CommandList CommandList;
+
+// One `;`-separated item: a pipeline, or `function() { body; }` when
+// function is set
+typedef struct {
+    Pipeline pipeline;
+    char* function;
+    CommandList* body;
+} ListItem;
+
+// A parsed line. Shared by reference count, since function bodies
+// outlive the line that defined them.
+struct CommandList {
+    ListItem* items;
+    size_t count;
+    unsigned refs;
+};
+
+// Options toggled with `set -o NAME` / `set +o NAME`
+typedef struct {
+    bool pipefail;
+    bool pipemon;
+    bool optimize;  // rewrite pipelines before running them (default on)
+    bool explain;   // print each rewrite to stderr
+} ShellOptions;
+
+extern ShellOptions shell_options;
+
+// Exit status of the last pipeline ($?)
+extern int shell_last_status;
+
 void list_init(StringList* list, size_t initial_capacity);
 void list_append(StringList* list, const char* s);
+bool list_append_unique(StringList* list, const char* s);
 void free_string_list(StringList* list);
+void list_shrink_to_fit(StringList* list);
+size_t list_memory(const StringList* list);
+
+static inline const char* list_get(const StringList* list, size_t i) {
+    return strpool_get(&list->pool, list->offsets[i]);
+}
+
+static inline size_t list_length(const StringList* list, size_t i) {
+    return list->lengths[i];
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "dircache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DIRCACHE_SLOTS 8
+
+static DirListing slots[DIRCACHE_SLOTS];
+static unsigned long use_clock;
+static DirCacheStats stats;
+
+static void listing_clear(DirListing* l) {
+    free_string_list(&l->names);
+    free(l->is_dir);
+    l->is_dir = NULL;
+    l->valid = false;
+}
+
+static bool same_time(struct timespec a, struct timespec b) {
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+// Takes ownership of dfd
+static void listing_scan(DirListing* l, int dfd) {
+    DIR* d = fdopendir(dfd);
+    if (!d) {
+        close(dfd);
+        return;
+    }
+
+    list_init(&l->names, 0);
+    size_t dir_cap = l->names.capacity;
+    l->is_dir = malloc(sizeof(bool) * dir_cap);
+
+    struct dirent* e;
+    while ((e = readdir(d))) {
+        const char* name = e->d_name;
+        if (name[0] == '.' &&
+            (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+
+        unsigned char type = e->d_type;
+        if (type == DT_UNKNOWN || type == DT_LNK || type == DT_REG) {
+            /* Need the mode (or the link target) to classify */
+            struct stat st;
+            if (fstatat(dfd, name, &st, 0) == -1) continue;
+            if (S_ISDIR(st.st_mode)) {
+                type = DT_DIR;
+            } else if (S_ISREG(st.st_mode) && (st.st_mode & 0111)) {
+                type = DT_REG;
+            } else {
+                continue;
+            }
+        } else if (type != DT_DIR) {
+            continue;
+        }
+
+        list_append(&l->names, name);
+        if (l->names.capacity != dir_cap) {
+            dir_cap = l->names.capacity;
+            bool* tmp = realloc(l->is_dir, sizeof(bool) * dir_cap);
+            if (!tmp) break;
+            l->is_dir = tmp;
+        }
+        l->is_dir[l->names.count - 1] = type == DT_DIR;
+    }
+
+    closedir(d);  // also closes dfd
+}
+
+const DirListing* dircache_get(const char* dir) {
+    if (!dir || !*dir) dir = ".";
+
+    int dfd = openat(AT_FDCWD, dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(dfd, &st) != 0) {
+        close(dfd);
+        return NULL;
+    }
+
+    DirListing* victim = &slots[0];
+    for (int i = 0; i < DIRCACHE_SLOTS; i++) {
+        DirListing* l = &slots[i];
+        if (l->valid && l->dev == st.st_dev && l->ino == st.st_ino) {
+            l->last_used = ++use_clock;
+            if (same_time(l->mtime, st.st_mtim)) {
+                stats.hits++;
+                close(dfd);
+                return l;
+            }
+            victim = l;  // same directory, stale listing
+            break;
+        }
+        if (victim->valid && (!l->valid || l->last_used < victim->last_used))
+            victim = l;
+    }
+
+    stats.misses++;
+    if (victim->valid) listing_clear(victim);
+
+    listing_scan(victim, dfd);
+    victim->dev = st.st_dev;
+    victim->ino = st.st_ino;
+    victim->mtime = st.st_mtim;
+    victim->last_used = ++use_clock;
+    victim->valid = victim->is_dir != NULL;
+    return victim->valid ? victim : NULL;
+}
+
+void dircache_free(void) {
+    for (int i = 0; i < DIRCACHE_SLOTS; i++) {
+        if (slots[i].valid) listing_clear(&slots[i]);
+    }
+}
+
+DirCacheStats dircache_stats(void) { return stats; }
@@ -0,0 +1,44 @@
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "shell.h"
+
+/*
+ * Directory listings used by completion, cached per directory.
+ *
+ * Entries are keyed by the directory's dev/inode pair and revalidated with
+ * its mtime, so renaming or cd'ing back and forth reuses the listing while
+ * any change to the directory forces a rescan. A small LRU keeps the most
+ * recently completed directories.
+ */
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    StringList names;
+    bool* is_dir;  // parallel to names
+    unsigned long last_used;
+    bool valid;
+} DirListing;
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+} DirCacheStats;
+
+/*
+ * Listing of dir (relative to the cwd, "" or NULL meaning the cwd itself).
+ * Only directories and executable files are listed. The returned pointer
+ * stays valid until the next dircache_get() call.
+ */
+const DirListing* dircache_get(const char* dir);
+
+void dircache_free(void);
+DirCacheStats dircache_stats(void);
+
+#endif
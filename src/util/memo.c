@@ -0,0 +1,408 @@
+#define _GNU_SOURCE
+
+#include "memo.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MEMO_DEFAULT_MAX_BYTES (64L * 1024 * 1024)
+#define MEMO_MAGIC "shmemo1\n"
+#define MEMO_NAME_LEN 16  // hex digits of the key hash
+
+// Entry file: header, key, stdout, stderr
+typedef struct {
+    char magic[8];
+    int32_t status;
+    uint32_t key_len;
+    uint64_t out_len;
+    uint64_t err_len;
+    int64_t run_ns;
+} EntryHeader;
+
+static struct {
+    char* dir;
+    uint64_t max_bytes;
+    MemoStats stats;
+} memo;
+
+/* ------------------------------------------------------------ */
+/* Cache directory                                              */
+/* ------------------------------------------------------------ */
+
+static const char* cache_dir(void) {
+    if (memo.dir) return memo.dir;
+
+    memo.max_bytes = MEMO_DEFAULT_MAX_BYTES;
+    const char* max = getenv("SHELL_MEMO_MAX_BYTES");
+    if (max) {
+        char* end;
+        long long v = strtoll(max, &end, 10);
+        if (*end == '\0' && v > 0) memo.max_bytes = v;
+    }
+
+    const char* dir = getenv("SHELL_MEMO_DIR");
+    if (dir && *dir) {
+        memo.dir = strdup(dir);
+        return memo.dir;
+    }
+    const char* base = getenv("XDG_CACHE_HOME");
+    const char* suffix = "/shell/memo";
+    if (!base || !*base) {
+        base = getenv("HOME");
+        suffix = "/.cache/shell/memo";
+    }
+    if (!base || !*base) return NULL;
+    if (asprintf(&memo.dir, "%s%s", base, suffix) < 0) memo.dir = NULL;
+    return memo.dir;
+}
+
+// mkdir -p
+static bool make_dirs(const char* path) {
+    char buf[strlen(path) + 1];
+    strcpy(buf, path);
+    for (char* p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return false;
+        *p = '/';
+    }
+    return mkdir(buf, 0755) == 0 || errno == EEXIST;
+}
+
+static bool is_entry_name(const char* name) {
+    if (strlen(name) != MEMO_NAME_LEN) return false;
+    for (const char* p = name; *p; p++) {
+        if (!strchr("0123456789abcdef", *p)) return false;
+    }
+    return true;
+}
+
+static char* entry_path(uint64_t hash) {
+    char* path;
+    if (asprintf(&path, "%s/%016" PRIx64, cache_dir(), hash) < 0) return NULL;
+    return path;
+}
+
+/* ------------------------------------------------------------ */
+/* Keys                                                         */
+/* ------------------------------------------------------------ */
+
+static uint64_t hash_bytes(const char* s, size_t n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Fields are NUL-terminated, so no argument can pose as another field
+static void put_field(FILE* f, const char* s) {
+    fwrite(s, 1, strlen(s) + 1, f);
+}
+
+bool memo_key(MemoKey* key, char* const* argv, char* const* env,
+              char* const* deps) {
+    char* cwd = getcwd(NULL, 0);
+    if (!cwd) return false;
+
+    FILE* f = open_memstream(&key->text, &key->len);
+    if (!f) {
+        free(cwd);
+        return false;
+    }
+
+    put_field(f, "cwd");
+    put_field(f, cwd);
+    free(cwd);
+
+    put_field(f, "argv");
+    for (char* const* a = argv; *a; a++) put_field(f, *a);
+
+    for (char* const* e = env; e && *e; e++) {
+        const char* value = getenv(*e);
+        put_field(f, "env");
+        put_field(f, *e);
+        fprintf(f, "%c%s", value ? '=' : '!', value ? value : "");
+        fputc('\0', f);
+    }
+
+    for (char* const* d = deps; d && *d; d++) {
+        struct stat st;
+        put_field(f, "dep");
+        put_field(f, *d);
+        if (stat(*d, &st) == 0) {
+            fprintf(f, "%lld.%09ld %lld", (long long)st.st_mtim.tv_sec,
+                    st.st_mtim.tv_nsec, (long long)st.st_size);
+        } else {
+            fputs("missing", f);
+        }
+        fputc('\0', f);
+    }
+
+    if (fclose(f) != 0) {
+        free(key->text);
+        return false;
+    }
+    key->hash = hash_bytes(key->text, key->len);
+    return true;
+}
+
+void memo_key_free(MemoKey* key) {
+    free(key->text);
+    *key = (MemoKey){0};
+}
+
+/* ------------------------------------------------------------ */
+/* Entries                                                      */
+/* ------------------------------------------------------------ */
+
+// Maps fd and checks it is an entry for key
+static bool map_entry(int fd, const MemoKey* key, MemoEntry* entry) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(EntryHeader)) {
+        return false;
+    }
+    size_t size = st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return false;
+
+    EntryHeader h;
+    memcpy(&h, map, sizeof(h));
+    const char* key_text = (const char*)map + sizeof(h);
+    if (memcmp(h.magic, MEMO_MAGIC, sizeof(h.magic)) != 0 ||
+        h.key_len != key->len ||
+        sizeof(h) + h.key_len + h.out_len + h.err_len != size ||
+        memcmp(key_text, key->text, key->len) != 0) {
+        munmap(map, size);
+        return false;
+    }
+
+    *entry = (MemoEntry){
+        .status = h.status,
+        .out = key_text + h.key_len,
+        .out_len = h.out_len,
+        .err = key_text + h.key_len + h.out_len,
+        .err_len = h.err_len,
+        .run_ns = h.run_ns,
+        .map = map,
+        .map_len = size,
+    };
+    return true;
+}
+
+bool memo_lookup(const MemoKey* key, MemoEntry* entry) {
+    char* path = cache_dir() ? entry_path(key->hash) : NULL;
+    int fd = path ? open(path, O_RDONLY | O_CLOEXEC) : -1;
+    free(path);
+
+    bool hit = fd >= 0 && map_entry(fd, key, entry);
+    if (hit) {
+        futimens(fd, NULL);  // most recently used
+        memo.stats.hits++;
+        memo.stats.saved_ns += entry->run_ns;
+    } else {
+        memo.stats.misses++;
+    }
+    if (fd >= 0) close(fd);
+    return hit;
+}
+
+void memo_entry_release(MemoEntry* entry) {
+    if (entry->map) munmap(entry->map, entry->map_len);
+    *entry = (MemoEntry){0};
+}
+
+/* ------------------------------------------------------------ */
+/* Eviction                                                     */
+/* ------------------------------------------------------------ */
+
+typedef struct {
+    char name[MEMO_NAME_LEN + 1];
+    struct timespec used;
+    uint64_t size;
+} DirEntry;
+
+// Every entry in the cache directory; *count of them, NULL if none
+static DirEntry* list_entries(DIR* d, size_t* count) {
+    DirEntry* list = NULL;
+    size_t n = 0, capacity = 0;
+    struct dirent* de;
+    while ((de = readdir(d))) {
+        struct stat st;
+        if (!is_entry_name(de->d_name) ||
+            fstatat(dirfd(d), de->d_name, &st, 0) != 0 ||
+            !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            DirEntry* tmp = realloc(list, sizeof(DirEntry) * capacity);
+            if (!tmp) break;
+            list = tmp;
+        }
+        list[n] = (DirEntry){.used = st.st_mtim, .size = st.st_size};
+        memcpy(list[n].name, de->d_name, MEMO_NAME_LEN + 1);
+        n++;
+    }
+    *count = n;
+    return list;
+}
+
+static int by_use(const void* a, const void* b) {
+    const struct timespec* x = &((const DirEntry*)a)->used;
+    const struct timespec* y = &((const DirEntry*)b)->used;
+    if (x->tv_sec != y->tv_sec) return x->tv_sec < y->tv_sec ? -1 : 1;
+    return (x->tv_nsec > y->tv_nsec) - (x->tv_nsec < y->tv_nsec);
+}
+
+// Oldest-used entries go until the directory fits in max_bytes
+static void evict(void) {
+    DIR* d = opendir(cache_dir());
+    if (!d) return;
+
+    size_t n;
+    DirEntry* list = list_entries(d, &n);
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++) total += list[i].size;
+
+    if (total > memo.max_bytes) {
+        qsort(list, n, sizeof(DirEntry), by_use);
+        for (size_t i = 0; i < n && total > memo.max_bytes; i++) {
+            if (unlinkat(dirfd(d), list[i].name, 0) == 0) {
+                total -= list[i].size;
+                memo.stats.evictions++;
+            }
+        }
+    }
+    free(list);
+    closedir(d);
+}
+
+/* ------------------------------------------------------------ */
+/* Capture                                                      */
+/* ------------------------------------------------------------ */
+
+bool memo_capture_begin(const MemoKey* key, MemoCapture* cap) {
+    *cap = (MemoCapture){.out_fd = -1, .err_fd = -1};
+    const char* dir = cache_dir();
+    if (!dir || !make_dirs(dir)) return false;
+
+    // stderr only needs a scratch file; stdout lands in place in the entry
+    char err_path[strlen(dir) + sizeof("/.err-XXXXXX")];
+    sprintf(err_path, "%s/.err-XXXXXX", dir);
+    cap->err_fd = mkostemp(err_path, O_CLOEXEC);
+    if (cap->err_fd < 0) return false;
+    unlink(err_path);
+
+    if (asprintf(&cap->tmp_path, "%s/.tmp-XXXXXX", dir) < 0) {
+        cap->tmp_path = NULL;
+        goto fail;
+    }
+    cap->out_fd = mkostemp(cap->tmp_path, O_CLOEXEC);
+    if (cap->out_fd < 0) goto fail;
+
+    EntryHeader h = {0};  // filled in at the end
+    if (write(cap->out_fd, &h, sizeof(h)) != sizeof(h) ||
+        write(cap->out_fd, key->text, key->len) != (ssize_t)key->len) {
+        unlink(cap->tmp_path);
+        goto fail;
+    }
+    return true;
+
+fail:
+    if (cap->out_fd >= 0) close(cap->out_fd);
+    close(cap->err_fd);
+    free(cap->tmp_path);
+    *cap = (MemoCapture){.out_fd = -1, .err_fd = -1};
+    return false;
+}
+
+// Appends all of from (read from the start) to to
+static bool append_file(int to, int from) {
+    char buf[65536];
+    if (lseek(from, 0, SEEK_SET) != 0) return false;
+    ssize_t n;
+    while ((n = read(from, buf, sizeof(buf))) > 0) {
+        if (write(to, buf, n) != n) return false;
+    }
+    return n == 0;
+}
+
+bool memo_capture_end(MemoCapture* cap, const MemoKey* key, int status,
+                      int64_t run_ns, MemoEntry* entry) {
+    off_t out_end = lseek(cap->out_fd, 0, SEEK_END);
+    off_t err_len = lseek(cap->err_fd, 0, SEEK_END);
+    EntryHeader h = {
+        .status = status,
+        .key_len = key->len,
+        .out_len = out_end - (off_t)(sizeof(h) + key->len),
+        .err_len = err_len,
+        .run_ns = run_ns,
+    };
+    memcpy(h.magic, MEMO_MAGIC, sizeof(h.magic));
+
+    bool ok = out_end >= 0 && err_len >= 0 &&
+              append_file(cap->out_fd, cap->err_fd) &&
+              pwrite(cap->out_fd, &h, sizeof(h), 0) == sizeof(h) &&
+              map_entry(cap->out_fd, key, entry);
+
+    char* path = ok ? entry_path(key->hash) : NULL;
+    uint64_t size = sizeof(h) + key->len + h.out_len + h.err_len;
+    // an entry bigger than the whole cache is replayed once, not kept
+    if (path && size <= memo.max_bytes && rename(cap->tmp_path, path) == 0) {
+        memo.stats.stores++;
+    } else {
+        unlink(cap->tmp_path);
+    }
+    free(path);
+
+    close(cap->out_fd);
+    close(cap->err_fd);
+    free(cap->tmp_path);
+    *cap = (MemoCapture){.out_fd = -1, .err_fd = -1};
+
+    if (ok) evict();
+    return ok;
+}
+
+/* ------------------------------------------------------------ */
+/* Management                                                   */
+/* ------------------------------------------------------------ */
+
+size_t memo_clear(void) {
+    DIR* d = cache_dir() ? opendir(cache_dir()) : NULL;
+    if (!d) return 0;
+
+    size_t n;
+    DirEntry* list = list_entries(d, &n);
+    size_t removed = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (unlinkat(dirfd(d), list[i].name, 0) == 0) removed++;
+    }
+    free(list);
+    closedir(d);
+    return removed;
+}
+
+MemoStats memo_stats(void) {
+    MemoStats s = memo.stats;
+    s.dir = cache_dir();
+    s.max_bytes = memo.max_bytes;
+
+    DIR* d = s.dir ? opendir(s.dir) : NULL;
+    if (!d) return s;
+    DirEntry* list = list_entries(d, &s.entries);
+    for (size_t i = 0; i < s.entries; i++) s.bytes += list[i].size;
+    free(list);
+    closedir(d);
+    return s;
+}
@@ -0,0 +1,83 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * On-disk result cache for the `memo` builtin.
+ *
+ * An entry holds the stdout, stderr and exit status of one run, keyed on
+ * argv, the working directory, chosen environment variables and the
+ * mtime/size of chosen dependency paths. Entries are single files named by
+ * the key's hash in $SHELL_MEMO_DIR (default $XDG_CACHE_HOME/shell/memo or
+ * ~/.cache/shell/memo); the full key is stored in the entry and compared on
+ * lookup. A hit sets the file's mtime, and once the directory grows past
+ * SHELL_MEMO_MAX_BYTES (default 64 MiB) the least recently used entries
+ * are deleted.
+ */
+
+typedef struct {
+    char* text;  // NUL-separated fields
+    size_t len;
+    uint64_t hash;
+} MemoKey;
+
+/* A mapped entry; out and err point into it */
+typedef struct {
+    int status;
+    const char* out;
+    size_t out_len;
+    const char* err;
+    size_t err_len;
+    int64_t run_ns;  // how long the original run took
+    void* map;
+    size_t map_len;
+} MemoEntry;
+
+/* A run being captured into a new entry */
+typedef struct {
+    int out_fd;  // hand these to the command as stdout and stderr
+    int err_fd;
+    char* tmp_path;
+} MemoCapture;
+
+typedef struct {
+    const char* dir;
+    size_t entries;
+    uint64_t bytes;
+    uint64_t max_bytes;
+    unsigned long hits, misses, stores, evictions;  // this session
+    int64_t saved_ns;  // run time of the hits' original runs
+} MemoStats;
+
+/*
+ * Builds the key of argv in the current directory. env and deps are
+ * NULL-terminated lists of variable names and paths. False if out of
+ * memory or the cwd is unknown.
+ */
+bool memo_key(MemoKey* key, char* const* argv, char* const* env,
+              char* const* deps);
+void memo_key_free(MemoKey* key);
+
+/* Maps the entry for key; false on a miss */
+bool memo_lookup(const MemoKey* key, MemoEntry* entry);
+void memo_entry_release(MemoEntry* entry);
+
+/* Opens capture files for a run of key; false if the cache is unusable */
+bool memo_capture_begin(const MemoKey* key, MemoCapture* cap);
+
+/*
+ * Stores the finished run and maps it into *entry; the capture is closed
+ * either way. False (nothing stored) on an I/O error.
+ */
+bool memo_capture_end(MemoCapture* cap, const MemoKey* key, int status,
+                      int64_t run_ns, MemoEntry* entry);
+
+/* Deletes every entry; returns how many */
+size_t memo_clear(void);
+
+MemoStats memo_stats(void);
+
+#endif
@@ -13,8 +13,16 @@
 
 static StringList path_cache;
 
+// hash table stats from the last scan_path(); both tables are gone after it
+static HashStats last_names_stats, last_dirs_stats;
+
 const StringList* get_path_cache(void) { return &path_cache; }
 
+PathCacheStats path_cache_stats(void) {
+    return (PathCacheStats){path_cache.count, list_memory(&path_cache),
+                            last_names_stats, last_dirs_stats};
+}
+
 void build_path_cache(void) {
     free_string_list(&path_cache);
     path_cache = scan_path();
@@ -74,7 +82,7 @@ StringList scan_path(void) {
 
                 if (!(st.st_mode & 0111)) continue;
 
-                list_append(&result, e->d_name);
+                list_append_unique(&result, e->d_name);
                 continue;
             }
 
@@ -87,15 +95,18 @@ StringList scan_path(void) {
 
                 if (!(st.st_mode & 0111)) continue;
 
-                list_append(&result, e->d_name);
+                list_append_unique(&result, e->d_name);
             }
         }
 
         closedir(d);
     }
 
+    last_dirs_stats = hashset_stats(&seen_dirs);
+    last_names_stats = strpool_index_stats(&result.pool);
     hashset_free(&seen_dirs);
     free(path);
+    list_shrink_to_fit(&result);
     return result;
 }
 
@@ -127,7 +138,7 @@ StringList scan_current_directory(void) {
 
             if (!(st.st_mode & 0111)) continue;
 
-            list_append(&result, strdup(e->d_name));
+            list_append(&result, e->d_name);
             continue;
         }
 
@@ -139,7 +150,7 @@ StringList scan_current_directory(void) {
 
             if (!(st.st_mode & 0111)) continue;
 
-            list_append(&result, strdup(e->d_name));
+            list_append(&result, e->d_name);
         }
     }
 
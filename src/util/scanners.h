@@ -1,5 +1,6 @@
 #ifndef SCANNERS_H
 #define SCANNERS_H
+#include "ds/hashstats.h"
 #include "shell.h"
 
 StringList scan_path(void);
@@ -8,4 +9,13 @@ void build_path_cache();
 void free_path_cache();
 const StringList* get_path_cache(void);
 
+typedef struct {
+    size_t entries;
+    size_t bytes;
+    HashStats names;  // dedup index, as it was before being compacted away
+    HashStats dirs;   // PATH directory dedup set
+} PathCacheStats;
+
+PathCacheStats path_cache_stats(void);
+
 #endif
\ No newline at end of file
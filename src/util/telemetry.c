@@ -0,0 +1,417 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TELEMETRY_DEFAULT_MAX_BYTES (16L * 1024 * 1024)
+#define TELEMETRY_KEEP_FILES 3
+#define TELEMETRY_FLUSH_THRESHOLD (64 * 1024)
+#define TELEMETRY_FLUSH_INTERVAL_NS 1000000000LL
+// upper bound on buffered data when the sink is not accepting writes
+#define TELEMETRY_BUFFER_LIMIT (4 * 1024 * 1024)
+
+static struct {
+    bool enabled;
+    pid_t owner;  // forked children must not flush the parent's buffer
+    char* path;
+    int fd;
+    off_t file_size;
+    long max_bytes;
+
+    // records not yet handed to the writer; guarded by lock
+    char* buf;
+    size_t len;
+    size_t cap;
+    size_t dropped;
+    int64_t last_flush_ns;
+
+    // the writer thread and what it owns: out and the sink
+    pthread_mutex_t lock;
+    pthread_cond_t wake;  // to the writer: pending was set
+    pthread_cond_t done;  // from the writer: a round finished
+    pthread_t writer;
+    bool writer_started;
+    bool pending;
+    uint64_t round;       // rounds the writer has begun
+    uint64_t round_done;  // rounds it has finished
+    char* out;            // taken from buf, not yet accepted by the sink
+    size_t out_len;
+    size_t out_cap;
+} tm = {.fd = -1,
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .wake = PTHREAD_COND_INITIALIZER,
+        .done = PTHREAD_COND_INITIALIZER};
+
+/* ------------------------------------------------------------ */
+/* Buffer helpers                                               */
+/* ------------------------------------------------------------ */
+
+static bool buf_reserve(size_t extra) {
+    if (tm.len + extra <= tm.cap) return true;
+
+    size_t new_cap = tm.cap ? tm.cap : TELEMETRY_FLUSH_THRESHOLD;
+    while (new_cap < tm.len + extra) new_cap *= 2;
+
+    char* tmp = realloc(tm.buf, new_cap);
+    if (!tmp) return false;
+    tm.buf = tmp;
+    tm.cap = new_cap;
+    return true;
+}
+
+static void buf_append(const char* s, size_t n) {
+    if (!buf_reserve(n)) return;
+    memcpy(tm.buf + tm.len, s, n);
+    tm.len += n;
+}
+
+static void buf_printf(const char* fmt, ...) {
+    char tmp[128];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        buf_append(tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+    }
+}
+
+static void buf_json_string(const char* s) {
+    buf_append("\"", 1);
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            char esc[2] = {'\\', (char)*p};
+            buf_append(esc, 2);
+        } else if (*p < 0x20) {
+            buf_printf("\\u%04x", *p);
+        } else {
+            buf_append((const char*)p, 1);
+        }
+    }
+    buf_append("\"", 1);
+}
+
+/* ------------------------------------------------------------ */
+/* Sink                                                         */
+/* ------------------------------------------------------------ */
+
+static int open_sink(void) {
+    // O_NONBLOCK matters when the sink is a FIFO read by a collector
+    tm.fd = open(tm.path, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC,
+                 0644);
+    if (tm.fd < 0) return -1;
+
+    struct stat st;
+    tm.file_size = fstat(tm.fd, &st) == 0 ? st.st_size : 0;
+    return 0;
+}
+
+static void rotate_sink(void) {
+    close(tm.fd);
+    tm.fd = -1;
+
+    size_t n = strlen(tm.path) + 16;
+    char from[n], to[n];
+    for (int i = TELEMETRY_KEEP_FILES - 1; i >= 1; i--) {
+        snprintf(from, n, "%s.%d", tm.path, i);
+        snprintf(to, n, "%s.%d", tm.path, i + 1);
+        rename(from, to);
+    }
+    snprintf(to, n, "%s.1", tm.path);
+    rename(tm.path, to);
+
+    open_sink();
+}
+
+// Moves buf to the end of out; caller holds the lock
+static void take_buffer(void) {
+    if (tm.out_len + tm.len > tm.out_cap) {
+        size_t cap = tm.out_cap ? tm.out_cap : TELEMETRY_FLUSH_THRESHOLD;
+        while (cap < tm.out_len + tm.len) cap *= 2;
+        char* tmp = realloc(tm.out, cap);
+        if (!tmp) {
+            tm.dropped++;
+            tm.len = 0;
+            return;
+        }
+        tm.out = tmp;
+        tm.out_cap = cap;
+    }
+    memcpy(tm.out + tm.out_len, tm.buf, tm.len);
+    tm.out_len += tm.len;
+    tm.len = 0;
+}
+
+// Writes out to the sink; only the writer (or the owner, when there is no
+// writer) calls this
+static void write_out(void) {
+    if (tm.out_len == 0) return;
+    if (tm.fd < 0 && open_sink() != 0) return;
+
+    struct stat st;
+    if (fstat(tm.fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        tm.file_size + (off_t)tm.out_len > tm.max_bytes &&
+        tm.file_size > 0) {
+        rotate_sink();
+        if (tm.fd < 0) return;
+    }
+
+    size_t off = 0;
+    while (off < tm.out_len) {
+        ssize_t n = write(tm.fd, tm.out + off, tm.out_len - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;  // EAGAIN or a real error: keep the rest for later
+        }
+        off += (size_t)n;
+        tm.file_size += n;
+    }
+
+    memmove(tm.out, tm.out + off, tm.out_len - off);
+    tm.out_len -= off;
+
+    if (tm.out_len > TELEMETRY_BUFFER_LIMIT) {
+        tm.dropped++;
+        tm.out_len = 0;
+    }
+}
+
+static void* writer_main(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&tm.lock);
+    for (;;) {
+        while (!tm.pending) pthread_cond_wait(&tm.wake, &tm.lock);
+        tm.pending = false;
+        uint64_t round = ++tm.round;
+        take_buffer();
+        pthread_mutex_unlock(&tm.lock);
+
+        write_out();  // the slow part, off the command path
+
+        pthread_mutex_lock(&tm.lock);
+        tm.round_done = round;
+        pthread_cond_broadcast(&tm.done);
+    }
+    return NULL;
+}
+
+// Caller holds the lock
+static bool start_writer(void) {
+    if (tm.writer_started) return true;
+
+    // the writer must not take the shell's signals
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    tm.writer_started =
+        pthread_create(&tm.writer, NULL, writer_main, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (tm.writer_started) pthread_detach(tm.writer);
+    return tm.writer_started;
+}
+
+// Wakes the writer; caller holds the lock. Returns the round that will
+// include everything buffered so far, or 0 if there is no writer.
+static uint64_t request_round(void) {
+    if (!start_writer()) return 0;
+    tm.pending = true;
+    pthread_cond_signal(&tm.wake);
+    return tm.round + 1;
+}
+
+void telemetry_flush(void) {
+    if (!tm.enabled || getpid() != tm.owner) return;
+
+    pthread_mutex_lock(&tm.lock);
+    if (tm.len == 0 && !tm.writer_started) {
+        pthread_mutex_unlock(&tm.lock);
+        return;
+    }
+    uint64_t round = request_round();
+    if (round == 0) {
+        take_buffer();  // no thread: write here, as a last resort
+        pthread_mutex_unlock(&tm.lock);
+        write_out();
+        return;
+    }
+    while (tm.round_done < round) pthread_cond_wait(&tm.done, &tm.lock);
+    pthread_mutex_unlock(&tm.lock);
+}
+
+// Threads do not survive fork(): the child gets an unlocked mutex and no
+// writer, and starts its own if it becomes an owner (telemetry_adopt)
+static void before_fork(void) { pthread_mutex_lock(&tm.lock); }
+
+static void after_fork_parent(void) { pthread_mutex_unlock(&tm.lock); }
+
+static void after_fork_child(void) {
+    // the parent's waiters do not exist here
+    tm.wake = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    tm.done = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    pthread_mutex_unlock(&tm.lock);
+    tm.writer_started = false;
+    tm.pending = false;
+    tm.round_done = tm.round;
+}
+
+/* ------------------------------------------------------------ */
+/* Public API                                                   */
+/* ------------------------------------------------------------ */
+
+void telemetry_init(void) {
+    const char* path = getenv("SHELL_TELEMETRY");
+    if (!path || !*path) return;
+
+    tm.path = strdup(path);
+    tm.max_bytes = TELEMETRY_DEFAULT_MAX_BYTES;
+
+    const char* max = getenv("SHELL_TELEMETRY_MAX_BYTES");
+    if (max) {
+        char* end;
+        long v = strtol(max, &end, 10);
+        if (*end == '\0' && v > 0) tm.max_bytes = v;
+    }
+
+    tm.owner = getpid();
+    tm.enabled = true;
+    pthread_atfork(before_fork, after_fork_parent, after_fork_child);
+}
+
+bool telemetry_enabled(void) { return tm.enabled; }
+
+void telemetry_adopt(void) {
+    if (!tm.enabled) return;
+    tm.owner = getpid();
+    tm.len = 0;
+    tm.out_len = 0;
+}
+
+static int64_t clock_us(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t tv_us(struct timeval tv) {
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static int64_t file_size_or_zero(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
+static size_t count_redirections(const Pipeline* pl) {
+    size_t n = 0;
+    for (size_t i = 0; i < pl->count; i++) n += pl->cmds[i].redirc;
+    return n;
+}
+
+void telemetry_begin(TelemetrySpan* span, const Pipeline* pl) {
+    span->redir_sizes = NULL;
+
+    size_t nredir = count_redirections(pl);
+    if (nredir > 0) {
+        span->redir_sizes = malloc(sizeof(int64_t) * nredir);
+        size_t k = 0;
+        for (size_t i = 0; i < pl->count && span->redir_sizes; i++) {
+            const Command* c = &pl->cmds[i];
+            for (int r = 0; r < c->redirc; r++, k++) {
+                span->redir_sizes[k] =
+                    c->redirections[r].mode == APPEND
+                        ? file_size_or_zero(c->redirections[r].filename)
+                        : 0;
+            }
+        }
+    }
+
+    getrusage(RUSAGE_SELF, &span->self_start);
+    getrusage(RUSAGE_CHILDREN, &span->children_start);
+    span->start_real_us = clock_us(CLOCK_REALTIME);
+    span->start_mono_ns = clock_ns(CLOCK_MONOTONIC);
+}
+
+void telemetry_end(TelemetrySpan* span, const Pipeline* pl,
+                   const int* statuses, int first_failed) {
+    int64_t wall_ns = clock_ns(CLOCK_MONOTONIC) - span->start_mono_ns;
+    int64_t end_real_us = clock_us(CLOCK_REALTIME);
+
+    struct rusage self_end, children_end;
+    getrusage(RUSAGE_SELF, &self_end);
+    getrusage(RUSAGE_CHILDREN, &children_end);
+
+    int64_t user_us = tv_us(self_end.ru_utime) -
+                      tv_us(span->self_start.ru_utime) +
+                      tv_us(children_end.ru_utime) -
+                      tv_us(span->children_start.ru_utime);
+    int64_t sys_us = tv_us(self_end.ru_stime) -
+                     tv_us(span->self_start.ru_stime) +
+                     tv_us(children_end.ru_stime) -
+                     tv_us(span->children_start.ru_stime);
+
+    // growth of the output files; the size of a `<` file says nothing about
+    // how much of it was read, so inputs are not counted
+    int64_t redir_bytes = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < pl->count && span->redir_sizes; i++) {
+        const Command* c = &pl->cmds[i];
+        for (int r = 0; r < c->redirc; r++, k++) {
+            const Redirection* rd = &c->redirections[r];
+            if (rd->mode != TRUNC && rd->mode != APPEND) continue;
+            int64_t size = file_size_or_zero(rd->filename);
+            redir_bytes += size - span->redir_sizes[k];
+        }
+    }
+    free(span->redir_sizes);
+    span->redir_sizes = NULL;
+
+    pthread_mutex_lock(&tm.lock);
+    buf_printf("{\"pid\":%d,\"start_us\":%lld,\"end_us\":%lld", (int)getpid(),
+               (long long)span->start_real_us, (long long)end_real_us);
+    buf_printf(",\"wall_us\":%lld,\"cpu_user_us\":%lld,\"cpu_sys_us\":%lld",
+               (long long)(wall_ns / 1000), (long long)user_us,
+               (long long)sys_us);
+    buf_printf(",\"redir_bytes\":%lld,\"first_failed\":%d,\"stages\":[",
+               (long long)redir_bytes, first_failed);
+    for (size_t i = 0; i < pl->count; i++) {
+        const Command* c = &pl->cmds[i];
+        buf_append(i ? ",{\"argv\":[" : "{\"argv\":[", i ? 10 : 9);
+        for (int a = 0; a < c->argc; a++) {
+            if (a) buf_append(",", 1);
+            buf_json_string(c->argv[a]);
+        }
+        buf_printf("],\"status\":%d}", statuses[i]);
+    }
+    buf_append("]}\n", 3);
+
+    // the writer does the write(); this only wakes it
+    int64_t now = span->start_mono_ns + wall_ns;
+    if (getpid() == tm.owner &&
+        (tm.len >= TELEMETRY_FLUSH_THRESHOLD ||
+         now - tm.last_flush_ns >= TELEMETRY_FLUSH_INTERVAL_NS)) {
+        tm.last_flush_ns = now;
+        request_round();
+    }
+    if (tm.len > TELEMETRY_BUFFER_LIMIT) {  // no writer, or a stuck one
+        tm.dropped++;
+        tm.len = 0;
+    }
+    pthread_mutex_unlock(&tm.lock);
+}
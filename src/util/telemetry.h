@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/resource.h>
+
+#include "shell.h"
+
+/*
+ * Opt-in per-pipeline telemetry.
+ *
+ * Enabled by setting SHELL_TELEMETRY=<file>. One JSON object is written per
+ * executed pipeline (JSON lines). Records are buffered in memory and handed
+ * to a writer thread, which does every write() and rotation, so a slow
+ * sink never sits on the command path. The file is rotated to
+ * <file>.1 .. <file>.N once it grows past SHELL_TELEMETRY_MAX_BYTES
+ * (default 16 MiB).
+ */
+
+typedef struct {
+    int64_t start_real_us;
+    int64_t start_mono_ns;
+    struct rusage self_start;
+    struct rusage children_start;
+    int64_t* redir_sizes;  // size of each output target before the run
+} TelemetrySpan;
+
+void telemetry_init(void);
+bool telemetry_enabled(void);
+
+void telemetry_begin(TelemetrySpan* span, const Pipeline* pl);
+void telemetry_end(TelemetrySpan* span, const Pipeline* pl,
+                   const int* statuses, int first_failed);
+
+/*
+ * Write out everything buffered so far, waiting for the writer to do it.
+ * For exit and the server's replies; safe to call when disabled.
+ */
+void telemetry_flush(void);
+
+/*
+ * Make a forked child the owner of its own record stream: records inherited
+ * from the parent are dropped (the parent writes them) and the child may
+ * flush.
+ */
+void telemetry_adopt(void);
+
+#endif
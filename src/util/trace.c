@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_RING_SIZE 8192  // power of two
+#define TRACE_DETAIL_MAX 64
+
+typedef struct {
+    _Atomic uint64_t seq;  // index + 1 once the slot is fully written
+    const char* name;      // static string
+    char detail[TRACE_DETAIL_MAX];
+    int64_t start_ns;
+    int64_t end_ns;
+    int tid;
+} TraceEvent;
+
+bool trace_active;
+
+static TraceEvent ring[TRACE_RING_SIZE];
+static _Atomic uint64_t head;  // next index to claim
+static uint64_t flushed;       // events before this index are written
+static int trace_fd = -1;
+static int trace_pid;           // process all tracks are grouped under
+static int self_tid;            // track of the calling process
+
+/* ------------------------------------------------------------ */
+/* Recording                                                    */
+/* ------------------------------------------------------------ */
+
+void trace_span(const char* name, const char* detail, int64_t start_ns,
+                int64_t end_ns, int tid) {
+    if (!trace_active) return;
+
+    uint64_t idx = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    TraceEvent* ev = &ring[idx & (TRACE_RING_SIZE - 1)];
+
+    ev->name = name;
+    ev->start_ns = start_ns;
+    ev->end_ns = end_ns;
+    ev->tid = tid ? tid : self_tid;
+    if (detail) {
+        strncpy(ev->detail, detail, TRACE_DETAIL_MAX - 1);
+        ev->detail[TRACE_DETAIL_MAX - 1] = '\0';
+    } else {
+        ev->detail[0] = '\0';
+    }
+    atomic_store_explicit(&ev->seq, idx + 1, memory_order_release);
+
+    // keep the ring from lapping unwritten events
+    if (idx - flushed >= TRACE_RING_SIZE / 2) trace_flush();
+}
+
+/* ------------------------------------------------------------ */
+/* Output                                                       */
+/* ------------------------------------------------------------ */
+
+static size_t json_escape(char* out, size_t cap, const char* s) {
+    size_t n = 0;
+    for (; *s && n + 7 < cap; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out[n++] = '\\';
+            out[n++] = c;
+        } else if (c < 0x20) {
+            n += snprintf(out + n, cap - n, "\\u%04x", c);
+        } else {
+            out[n++] = c;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+void trace_flush(void) {
+    if (trace_fd < 0) return;
+
+    uint64_t end = atomic_load_explicit(&head, memory_order_acquire);
+    uint64_t start = flushed;
+    if (end - start > TRACE_RING_SIZE) start = end - TRACE_RING_SIZE;
+
+    char buf[16384];
+    size_t len = 0;
+    for (uint64_t i = start; i < end; i++) {
+        const TraceEvent* ev = &ring[i & (TRACE_RING_SIZE - 1)];
+        // skip slots still being written or already reused
+        if (atomic_load_explicit(&ev->seq, memory_order_acquire) != i + 1)
+            continue;
+
+        char detail[TRACE_DETAIL_MAX * 6 + 1];
+        json_escape(detail, sizeof(detail), ev->detail);
+
+        if (len + 512 > sizeof(buf)) {
+            write(trace_fd, buf, len);
+            len = 0;
+        }
+        len += snprintf(
+            buf + len, sizeof(buf) - len,
+            "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+            "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"detail\":\"%s\"}},\n",
+            ev->name, trace_pid, ev->tid, ev->start_ns / 1000.0,
+            (ev->end_ns - ev->start_ns) / 1000.0, detail);
+    }
+    if (len > 0) write(trace_fd, buf, len);
+    flushed = end;
+}
+
+int trace_start(const char* path) {
+    if (trace_active) trace_stop();
+
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                    0644);
+    if (trace_fd < 0) {
+        perror(path);
+        return -1;
+    }
+    write(trace_fd, "[\n", 2);
+
+    trace_pid = getpid();
+    self_tid = trace_pid;
+    flushed = atomic_load(&head);
+    trace_active = true;
+    return 0;
+}
+
+void trace_stop(void) {
+    if (!trace_active) return;
+    trace_flush();
+    trace_active = false;
+    close(trace_fd);
+    trace_fd = -1;
+}
+
+void trace_child_init(void) {
+    if (!trace_active) return;
+    // the parent writes whatever it had buffered
+    flushed = atomic_load(&head);
+    self_tid = getpid();
+}
@@ -0,0 +1,34 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Execution tracer (`set -o trace=FILE`).
+ *
+ * Spans are recorded into a fixed in-memory ring and appended to FILE as
+ * Chrome trace-event JSON (the array form, which viewers accept without a
+ * closing bracket, so the file can be appended to incrementally). Open it
+ * in chrome://tracing or ui.perfetto.dev. Every child process gets its own
+ * track; children flush their own events just before exec.
+ */
+
+extern bool trace_active;
+
+static inline bool trace_enabled(void) { return trace_active; }
+
+int trace_start(const char* path);
+void trace_stop(void);
+
+/* Complete span on track tid (0 = the calling process's own track) */
+void trace_span(const char* name, const char* detail, int64_t start_ns,
+                int64_t end_ns, int tid);
+
+/* Call in a freshly forked child before recording anything */
+void trace_child_init(void);
+
+/* Write out buffered events (children call this right before exec) */
+void trace_flush(void);
+
+#endif
@@ -0,0 +1,21 @@
+alias say='echo said:'
+say hello
+alias say
+# an alias is not expanded again inside its own text
+alias echo='echo [e]'
+echo once
+unalias echo
+# a trailing blank makes the next word a candidate too
+alias run='say '
+alias word='expanded'
+run word
+# quoted or escaped words are never aliases
+\say not an alias
+'say' quoted
+# command position after | and ;
+say piped | cat
+echo x | say
+echo a; say b
+unalias say
+say gone
+type run
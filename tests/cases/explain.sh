@@ -0,0 +1,11 @@
+# set -o explain prints each rewrite to stderr before the pipeline runs
+printf 'one\ntwo\n' > f
+set -o explain
+cat f | wc -l
+cat < f | sort -r
+echo a | cat | cat | tr a A
+cat f | head -n 1 2> err
+cat f | echo alone
+cat missing 2> /dev/null | wc -l
+set +o optimize
+cat f | wc -l
@@ -0,0 +1,43 @@
+greet() { echo "hello $1 ($# args)"; }
+greet world
+greet "two words" x
+
+args() { for_each "$@"; }
+for_each() { echo "$# args: [$1] [$2] [$3]"; }
+args a "b c" ''
+args
+
+status() { return $1; }
+status 3
+echo "return 3 -> $?"
+status 0
+echo "return 0 -> $?"
+
+# locals are dynamic: a callee sees the caller's local, and the global
+# comes back when the scope pops
+x=global
+show() { echo "show sees $x"; }
+scoped() { local x=inner; show; x=changed; show; }
+scoped
+echo "after scoped: $x"
+
+count=0
+bump() { count=$((count + 1)); }
+bump; bump; bump
+echo "count $count"
+
+# recursion, bounded at 1000 nested calls
+depth() { local n=$1; d=$n; depth $((n + 1)); }
+depth 1
+echo "deepest $d, status $?"
+
+forever() { forever; }
+forever
+echo "after forever: $?"
+
+# a function can redefine itself while it runs
+once() { once() { echo second; }; echo first; }
+once
+once
+
+greet piped | tr a-z A-Z
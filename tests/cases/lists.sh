@@ -0,0 +1,9 @@
+echo one; echo two;echo three
+echo spaced ;  ; echo empty items skipped
+;echo leading
+x=1; echo "x is $x"; x=2; echo "x is $x"
+f() { echo in f; }; f; echo after f
+g() { echo a; echo b; }; g | tr a-z A-Z
+h() { echo "inner $#: $*"; }; h q r; echo "outer $#: $*"
+echo unterminated; f() { echo x
+echo not reached
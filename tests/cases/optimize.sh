@@ -0,0 +1,52 @@
+# Pipelines the optimizer rewrites, and ones it must leave alone. Run with
+# the optimizer on and off (case/optimize, case/optimize_off); both must
+# match optimize.out.
+printf 'pear\napple\nfig\n' > fruit
+mkdir dir
+
+# cat FILE | cmd  and  cat < FILE | cmd
+cat fruit | sort
+cat fruit | wc -l
+cat < fruit | head -n 1
+cat fruit | tr a-z A-Z | sort -r
+cat fruit > copy | wc -c
+cat copy
+
+# a | cat | b
+echo mid | cat | tr m M
+echo "stages: ${PIPESTATUS[@]}"
+printf 'x\ny\n' | cat | cat | wc -l
+
+# the stage after cat reads stdin itself
+cat fruit | sort < copy
+cat fruit | head -n 1 < /dev/null
+echo "empty: $?"
+
+# files cat cannot read keep cat's error and the rest of the pipeline
+cat missing | wc -l
+cat dir | wc -l
+cat -n fruit | tail -n 1
+cat -- fruit | tail -n 1
+
+# statuses
+cat fruit | false
+echo "false: $?"
+cat fruit | grep -q fig
+echo "grep: $?"
+set -o pipefail
+cat missing | true
+echo "pipefail: $?"
+set +o pipefail
+
+# stages left alone in the shell or in a child as before
+cat fruit | cd dir
+pwd | sed 's|.*/||'
+lines() { wc -l; }
+cat fruit | lines
+cat fruit | echo builtin
+cat fruit | [ -t 0 ]
+echo "[ -t 0 ]: $?"
+cat fruit | test -t 0 -o -t 1
+echo "test -t: $?"
+cat fruit | read first
+echo "first '$first'"
@@ -0,0 +1,26 @@
+echo a | false | cat
+echo "${PIPESTATUS[@]} (${#PIPESTATUS[@]} stages)"
+true
+echo "${PIPESTATUS[@]}"
+sh -c 'exit 3' | sh -c 'exit 4'
+echo "$? ${PIPESTATUS[0]} ${PIPESTATUS[1]}"
+echo "PIPESTATUS itself: ${PIPESTATUS[@]}"
+
+# a cat the optimizer removes still has its place
+printf 'x\n' > f
+cat f | wc -l
+echo "${PIPESTATUS[@]}"
+echo a | cat | cat | tr a b
+echo "${PIPESTATUS[@]}"
+
+set -o pipefail
+false | true
+echo "pipefail $?"
+
+# the first failure stops the stages still running; they show 143
+sleep 5 | sh -c 'exit 3' | sleep 5
+echo "stopped $?: ${PIPESTATUS[@]}"
+
+# a writer killed by SIGPIPE stops nothing: head finishes its output
+yes | head -n 2
+echo "head $?: ${PIPESTATUS[@]}"
@@ -0,0 +1,20 @@
+# operator characters that are quoted or escaped are ordinary words
+echo "(" x
+echo '(' ')'
+echo \( y \)
+echo ";" x
+echo a \; b
+echo "|" z | cat
+echo \| q
+echo \< x "<" y
+echo '>' a \> b '2>' c
+echo ">&2" \>\&2
+echo "{" "}" \{ \}
+test \( 1 -eq 1 \); echo "test ( ) -> $?"
+f() { echo "in f }"; echo done; }
+f
+# unquoted they are operators
+echo out > file; cat < file
+echo err 2>&1 >&2 | cat
+echo a ( b
+echo not reached
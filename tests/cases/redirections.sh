@@ -0,0 +1,12 @@
+echo one > f
+echo two >> f
+cat < f
+echo err 2> e >&2
+cat e
+echo quoted '>' x "<" y
+# eight redirections is the limit
+echo eight > r1 > r2 > r3 > r4 > r5 > r6 2>&1 > r8
+cat r8 r1
+# a ninth makes the line a syntax error: nothing on it runs
+echo nine > n1 > n2 > n3 > n4 > n5 > n6 > n7 > n8 > n9; echo ran
+echo not reached
@@ -0,0 +1,161 @@
+// Differential test of the lexer's run scanning: the default build (SSE2
+// on x86-64) and, where the CPU has it, the AVX2 build must produce the
+// same tokens as the LEXER_SCALAR build for every line.
+//
+//   lexer_diff [LINES [SEED]]
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parse/alias.h"
+#include "parse/lexer.h"
+
+Token* scalar_lex_tokens(char* line);
+#ifdef LEXER_DIFF_AVX2
+Token* avx2_lex_tokens(char* line);
+#endif
+
+// Aliases are looked up by every build alike; two fixed ones make sure
+// the expansion path runs too
+const char* alias_get(const char* name) {
+    if (strcmp(name, "ll") == 0) return "ls -l";
+    if (strcmp(name, "p") == 0) return "printf '%s\\n' | ";
+    return NULL;
+}
+
+/* ------------------------------------------------------------ */
+/* Random lines                                                 */
+/* ------------------------------------------------------------ */
+
+static uint64_t rng_state;
+
+static uint32_t rng(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 2685821657736338717ULL) >> 32);
+}
+
+static const char* const pieces[] = {
+    " ",   "  ",   "'",    "\"",   "\\",   "|",    "<",     ">",
+    ">>",  "2>",   "2>&1", ">&",   "<&",   "$",    "$$",    "$x",
+    "${a}", "$((", "))",   "(",    ")",    ";",    "{",     "}",
+    "<(",  ">(",   "ll",   "p",    "=",    "*",    "\\\"",  "\\$",
+};
+
+// A line of random pieces and ordinary runs, some long enough to cross
+// several 16- and 32-byte blocks
+static size_t make_line(char* buf, size_t cap) {
+    size_t len = 0;
+    size_t target = rng() % 8 == 0 ? rng() % (cap - 64) : rng() % 200;
+    while (len < target) {
+        const char* piece;
+        char run[80];
+        if (rng() % 3 == 0) {
+            size_t n = 1 + rng() % (rng() % 4 == 0 ? 79 : 12);
+            for (size_t i = 0; i < n; i++) run[i] = 'a' + rng() % 26;
+            run[n] = '\0';
+            piece = run;
+        } else {
+            piece = pieces[rng() % (sizeof(pieces) / sizeof(*pieces))];
+        }
+        size_t n = strlen(piece);
+        if (len + n >= cap) break;
+        memcpy(buf + len, piece, n);
+        len += n;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/* ------------------------------------------------------------ */
+/* Comparison                                                   */
+/* ------------------------------------------------------------ */
+
+static void free_tokens(Token* tokens) {
+    if (!tokens) return;
+    for (size_t i = 0; tokens[i].text; i++) free(tokens[i].text);
+    free(tokens);
+}
+
+static void print_escaped(const char* s) {
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c < 0x20 || c == 0x7f) {
+            printf("\\x%02x", c);
+        } else {
+            putchar(c);
+        }
+    }
+}
+
+static void print_tokens(const char* label, const Token* tokens) {
+    printf("  %-7s", label);
+    for (size_t i = 0; tokens && tokens[i].text; i++) {
+        printf(" [%d:", tokens[i].type);
+        print_escaped(tokens[i].text);
+        putchar(']');
+    }
+    putchar('\n');
+}
+
+static bool same_tokens(const Token* a, const Token* b) {
+    if (!a || !b) return a == b;
+    size_t i = 0;
+    for (; a[i].text && b[i].text; i++) {
+        if (a[i].type != b[i].type || strcmp(a[i].text, b[i].text) != 0) {
+            return false;
+        }
+    }
+    return !a[i].text && !b[i].text;
+}
+
+// Lexes line with both builds; prints the difference if there is one
+static bool check(const char* label, Token* (*lex)(char*), char* line,
+                  const Token* expected) {
+    Token* got = lex(line);
+    bool ok = same_tokens(got, expected);
+    if (!ok) {
+        printf("mismatch (%s) on line: ", label);
+        print_escaped(line);
+        putchar('\n');
+        print_tokens("scalar", expected);
+        print_tokens(label, got);
+    }
+    free_tokens(got);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    long lines = argc > 1 ? atol(argv[1]) : 50000;
+    rng_state = argc > 2 ? strtoull(argv[2], NULL, 10) : 0x9e3779b97f4a7c15;
+    if (rng_state == 0) rng_state = 1;
+
+#ifdef LEXER_DIFF_AVX2
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    static char line[8192];
+    long failures = 0;
+    for (long i = 0; i < lines && failures < 10; i++) {
+        make_line(line, sizeof(line));
+        Token* expected = scalar_lex_tokens(line);
+        if (!check("default", lex_tokens, line, expected)) failures++;
+#ifdef LEXER_DIFF_AVX2
+        if (avx2 && !check("avx2", avx2_lex_tokens, line, expected)) {
+            failures++;
+        }
+#endif
+        free_tokens(expected);
+    }
+
+    if (failures) {
+        printf("lexer_diff: %ld mismatching lines\n", failures);
+        return 1;
+    }
+    printf("lexer_diff: %ld lines identical\n", lines);
+    return 0;
+}
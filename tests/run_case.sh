@@ -0,0 +1,27 @@
+#!/bin/sh
+# Runs one case script with the shell, in an empty scratch directory, and
+# compares its stdout and stderr, followed by "exit N", with the .out file
+# next to the case. PRELUDE, if given, is a line run before the case.
+#
+#   run_case.sh SHELL CASE.sh [PRELUDE]
+
+set -u
+
+shell=$1
+case_file=$2
+prelude=${3:-}
+expected=${case_file%.sh}.out
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+mkdir "$dir/work"
+# messages name it ../case.sh
+{ [ -z "$prelude" ] || echo "$prelude"; cat "$case_file"; } >"$dir/case.sh"
+
+(cd "$dir/work" && "$shell" ../case.sh) >"$dir/actual" 2>&1
+echo "exit $?" >>"$dir/actual"
+
+if ! diff -u "$expected" "$dir/actual"; then
+    echo "$case_file: output differs from $expected" >&2
+    exit 1
+fi